@@ -5,7 +5,10 @@
  *      Author: pablo-jean
  */
 
+#include <string.h>
+
 #include "nor.h"
+#include "nor_crc.h"
 
 #if defined (NOR_DEBUG)
 #include <stdarg.h>
@@ -26,52 +29,301 @@
 #define NOR_EMPTY_CHECK_BUFFER_LEN		64
 #endif
 
+// Size of the stack buffer used to stream data to the CRC32
+#ifndef NOR_CRC_BUFFER_LEN
+#define NOR_CRC_BUFFER_LEN				64
+#endif
+
+// Size of the stack buffer used by NOR_ReadStream
+#ifndef NOR_STREAM_BUFFER_LEN
+#define NOR_STREAM_BUFFER_LEN			128
+#endif
+
+// Size of the stack buffer used to compare the destination on NOR_CopyRangeEx
+#ifndef NOR_COPY_CMP_BUFFER_LEN
+#define NOR_COPY_CMP_BUFFER_LEN			64
+#endif
+
+// Interval between the polling rounds of NOR_MultiExecute
+#ifndef NOR_MULTI_POLL_US
+#define NOR_MULTI_POLL_US				100
+#endif
+
+// Time the erase runs after a resume, before it can be suspended again
+#ifndef NOR_RESUME_HOLD_US
+#define NOR_RESUME_HOLD_US				100
+#endif
+
+#define _NOR_PAGES_PER_SECTOR			(NOR_SECTOR_SIZE / NOR_PAGE_SIZE)
+
+// Weight of a new sample on the timing averages, 1/(2^SHIFT)
+#ifndef NOR_TIMING_EWMA_SHIFT
+#define NOR_TIMING_EWMA_SHIFT			3
+#endif
+
+// The first status poll is done at this percent of the average duration
+#ifndef NOR_TIMING_FIRST_POLL_PERCENT
+#define NOR_TIMING_FIRST_POLL_PERCENT	90
+#endif
+
+// A sector is slow when its 4K erase takes more than this percent of the average
+#ifndef NOR_TIMING_SLOW_PERCENT
+#define NOR_TIMING_SLOW_PERCENT			150
+#endif
+
+// Samples of the 4K erase before compare the sectors against the average
+#ifndef NOR_TIMING_MIN_SAMPLES
+#define NOR_TIMING_MIN_SAMPLES			8
+#endif
+
+#define _NOR_TIMING_NONE				0xFF
+
+// An optional function is set, on the operations table when used, or on the config
+#define _NOR_HAS_FXN(nor, Op, Fxn)		(((nor)->config.pOps != NULL) ? ((nor)->config.pOps->Op != NULL) : \
+											((nor)->config.Fxn != NULL))
+
+// Fast Read opcode, address and up to 4 dummy bytes
+#define _NOR_READ_CMD_MAX				8
+
+// Values of _internal.u8BusyPending
+#define _NOR_PENDING_PROGRAM			1
+#define _NOR_PENDING_ERASE				2
+
 #define _SANITY_CHECK(n)			if (n == NULL)	return NOR_INVALID_PARAMS;					\
 									if (n->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
 										return NOR_NOT_INITIALIZED;
 
-/* Enumerates */
+/* Functions */
 
-enum _nor_sr_select_e{
-	_SELECT_SR1,
-	_SELECT_SR2,
-	_SELECT_SR3,
-};
+#if defined (NOR_TRACE)
+static uint32_t _nor_trace_time(nor_t *nor){
+	if (nor->trace.TimeFxn != NULL){
+		return nor->trace.TimeFxn();
+	}
+	return nor->trace.u32DelayUs;
+}
 
-/* Functions */
+static void _nor_trace_start(nor_t *nor){
+	if (nor->trace.u8Enabled == 0){
+		return;
+	}
+	nor->trace.Record.u32Timestamp = _nor_trace_time(nor);
+	nor->trace.Record.u32OpAddr = 0;
+	nor->trace.Record.u32Len = 0;
+	nor->trace.u8HdrLen = 0;
+}
+
+static void _nor_trace_tx(nor_t *nor, uint8_t *txBuf, uint32_t size){
+	// the first 4 bytes are the opcode and the address
+	while (size > 0 && nor->trace.u8HdrLen < 4){
+		nor->trace.Record.u32OpAddr |= ((uint32_t)*txBuf++ << (24 - (8 * nor->trace.u8HdrLen)));
+		nor->trace.u8HdrLen++;
+		size--;
+	}
+	nor->trace.Record.u32Len += size;
+}
+
+static void _nor_trace_end(nor_t *nor){
+	if (nor->trace.u8Enabled == 0){
+		return;
+	}
+	nor->trace.Record.u32BusyUs = nor->trace.u32BusyUs;
+	nor->trace.u32BusyUs = 0;
+	nor->trace.pRing[nor->trace.u32Head] = nor->trace.Record;
+	nor->trace.u32Head = (nor->trace.u32Head + 1) % nor->trace.u32Size;
+	if (nor->trace.u32Count < nor->trace.u32Size){
+		nor->trace.u32Count++;
+	}
+	else{
+		nor->trace.u32Dropped++;
+	}
+}
+#endif
 
 static void _nor_cs_assert(nor_t *nor){
-	nor->config.CsAssert();
+	nor->stats.u32Transactions++;
+#if defined (NOR_TRACE)
+	_nor_trace_start(nor);
+#endif
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->CsAssert(nor->config.pOpsCtx);
+	}
+	else{
+		nor->config.CsAssert();
+	}
 }
 
 static void _nor_cs_deassert(nor_t *nor){
-	nor->config.CsDeassert();
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->CsDeassert(nor->config.pOpsCtx);
+	}
+	else{
+		nor->config.CsDeassert();
+	}
+#if defined (NOR_TRACE)
+	_nor_trace_end(nor);
+#endif
 }
 
 static void _nor_spi_tx(nor_t *nor, uint8_t *txBuf, uint32_t size){
-	nor->config.SpiTxFxn(txBuf, size);
+#if defined (NOR_TRACE)
+	_nor_trace_tx(nor, txBuf, size);
+#endif
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->SpiTx(nor->config.pOpsCtx, txBuf, size);
+	}
+	else{
+		nor->config.SpiTxFxn(txBuf, size);
+	}
 }
 
 static void _nor_spi_rx(nor_t *nor, uint8_t *rxBuf, uint32_t size){
-	nor->config.SpiRxFxn(rxBuf, size);
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->SpiRx(nor->config.pOpsCtx, rxBuf, size);
+	}
+	else{
+		nor->config.SpiRxFxn(rxBuf, size);
+	}
+#if defined (NOR_TRACE)
+	nor->trace.Record.u32Len += size;
+#endif
 }
 
 static void _nor_delay_us(nor_t *nor, uint32_t us){
-	nor->config.DelayUs(us);
+#if defined (NOR_TRACE)
+	nor->trace.u32DelayUs += us;
+	nor->trace.u32BusyUs += us;
+#endif
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->DelayUs(nor->config.pOpsCtx, us);
+	}
+	else{
+		nor->config.DelayUs(us);
+	}
 }
 
 static void _nor_mtx_lock(nor_t *nor){
-	if (nor->config.MutexLockFxn != NULL){
+	if (nor->config.pOps != NULL){
+		if (nor->config.pOps->Lock != NULL){
+			nor->config.pOps->Lock(nor->config.pOpsCtx, NOR_LOCK_EXCLUSIVE);
+		}
+	}
+	else if (nor->config.LockFxn != NULL){
+		nor->config.LockFxn(nor->config.LockCtx, NOR_LOCK_EXCLUSIVE);
+	}
+	else if (nor->config.MutexLockFxn != NULL){
 		nor->config.MutexLockFxn();
 	}
+	// still pending when the lock is taken, it was left by a posted call
+	if (nor->_internal.u8BusyPending != 0){
+		nor->_internal.u8Posted = 1;
+	}
 }
 
 static void _nor_mtx_unlock(nor_t *nor){
-	if (nor->config.MutexUnlockFxn != NULL){
+	if (nor->config.pOps != NULL){
+		if (nor->config.pOps->Unlock != NULL){
+			nor->config.pOps->Unlock(nor->config.pOpsCtx, NOR_LOCK_EXCLUSIVE);
+		}
+	}
+	else if (nor->config.UnlockFxn != NULL){
+		nor->config.UnlockFxn(nor->config.LockCtx, NOR_LOCK_EXCLUSIVE);
+	}
+	else if (nor->config.MutexUnlockFxn != NULL){
 		nor->config.MutexUnlockFxn();
 	}
 }
 
+static void _nor_set_width(nor_t *nor, uint8_t Lines){
+	if (nor->config.pOps != NULL){
+		if (nor->config.pOps->BusWidth != NULL){
+			nor->config.pOps->BusWidth(nor->config.pOpsCtx, Lines);
+		}
+	}
+	else if (nor->config.BusWidthFxn != NULL){
+		nor->config.BusWidthFxn(Lines);
+	}
+}
+
+/*
+ * The optional functions below are called only when _NOR_HAS_FXN.
+ */
+static uint32_t _nor_time_us(nor_t *nor){
+	if (nor->config.pOps != NULL){
+		return nor->config.pOps->TimeUs(nor->config.pOpsCtx);
+	}
+	return nor->config.TimeUsFxn();
+}
+
+static uint8_t _nor_wait_ready(nor_t *nor, uint32_t msTimeout){
+	if (nor->config.pOps != NULL){
+		return nor->config.pOps->WaitReady(nor->config.pOpsCtx, msTimeout);
+	}
+	return nor->config.WaitReadyFxn(msTimeout);
+}
+
+static void _nor_verify_fail(nor_t *nor, uint32_t PageAddr){
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->VerifyFail(nor->config.pOpsCtx, PageAddr);
+	}
+	else{
+		nor->config.VerifyFailFxn(PageAddr);
+	}
+}
+
+static void _nor_slow_sector(nor_t *nor, uint32_t Sector, uint32_t EraseUs){
+	if (nor->config.pOps != NULL){
+		nor->config.pOps->SlowSector(nor->config.pOpsCtx, Sector, EraseUs);
+	}
+	else{
+		nor->config.SlowSectorFxn(Sector, EraseUs);
+	}
+}
+
+static void _nor_send_cmd(nor_t *nor, uint8_t Cmd){
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, &Cmd, sizeof(Cmd));
+	_nor_cs_deassert(nor);
+}
+
+static uint32_t _nor_read_cmd(nor_t *nor, uint8_t *pCmd, uint32_t Address){
+	pCmd[0] = NOR_READ_FAST_DATA;
+	pCmd[1] = ((Address >> 16) & 0xFF);
+	pCmd[2] = ((Address >> 8) & 0xFF);
+	pCmd[3] = ((Address) & 0xFF);
+	// 8 dummy clocks on SPI, and 2 clocks per byte on QPI
+	memset(&pCmd[4], 0x00, nor->_internal.u8ReadDummy);
+
+	return 4 + nor->_internal.u8ReadDummy;
+}
+
+static void _nor_reset_cmds(nor_t *nor){
+	// the reset is ignored on the power down
+	_nor_send_cmd(nor, NOR_RELEASE_PD);
+	_nor_delay_us(nor, NOR_EXPECT_RESET_US);
+	_nor_send_cmd(nor, NOR_ENABLE_RESET);
+	_nor_send_cmd(nor, NOR_DEVICE_RESET);
+	_nor_delay_us(nor, NOR_EXPECT_RESET_US);
+}
+
+/*
+ * The MCU may be reset with the device on QPI mode, ignoring the commands sent
+ * on a single line. The exit commands of all manufacturers are sent on 4 lines,
+ * and the device on SPI mode sees only 2 clocks on IO0, ignoring them. The
+ * device isn't reset here, a running erase must not be aborted.
+ */
+static void _nor_qpi_recover(nor_t *nor){
+	if (!_NOR_HAS_FXN(nor, BusWidth, BusWidthFxn)){
+		return;
+	}
+	_nor_set_width(nor, 4);
+	_nor_send_cmd(nor, NOR_RELEASE_PD);
+	_nor_delay_us(nor, NOR_EXPECT_RESET_US);
+	_nor_send_cmd(nor, NOR_EXIT_QPI_WINBOND);
+	_nor_send_cmd(nor, NOR_EXIT_QPI_MXIC);
+	_nor_set_width(nor, 1);
+}
+
 static uint32_t _nor_ReadID(nor_t *nor)
 {
 	uint8_t JedecIdCmd = NOR_JEDEC_ID;
@@ -105,10 +357,19 @@ static void _nor_WriteEnable(nor_t *nor)
 {
 	uint8_t WriteEnCmd = NOR_CMD_WRITE_EN;
 
-	_nor_cs_assert(nor);
-	_nor_spi_tx(nor, &WriteEnCmd, sizeof(WriteEnCmd));
-	_nor_cs_deassert(nor);
-	// TODO Check if a delay was needed here
+	// the latch is still set, like after a command ignored by the device
+	if ((nor->_internal.u8StatusReg1 & (SR1_WEL_BIT | SR1_BUSY_BIT)) == SR1_WEL_BIT){
+		nor->stats.u32SkippedWriteEnables++;
+	}
+	else{
+		_nor_cs_assert(nor);
+		_nor_spi_tx(nor, &WriteEnCmd, sizeof(WriteEnCmd));
+		_nor_cs_deassert(nor);
+	}
+	// the next command consumes the latch
+	nor->_internal.u8StatusReg1 &= ~SR1_WEL_BIT;
+	// an operation of the caller, waited with the lock held
+	nor->_internal.u8Posted = 0;
 }
 
 void _nor_WriteDisable(nor_t *nor)
@@ -118,25 +379,26 @@ void _nor_WriteDisable(nor_t *nor)
 	_nor_cs_assert(nor);
 	_nor_spi_tx(nor, &WriteDisCmd, sizeof(WriteDisCmd));
 	_nor_cs_deassert(nor);
+	nor->_internal.u8StatusReg1 &= ~SR1_WEL_BIT;
 }
 
-uint8_t _nor_ReadStatusRegister(nor_t *nor, enum _nor_sr_select_e SelectSR)
+uint8_t _nor_ReadStatusRegister(nor_t *nor, nor_sr_e SelectSR)
 {
 	uint8_t status = 0, ReadSRCmd;
 	uint8_t *SrUpdateHandler;
 
 	switch (SelectSR){
-	case _SELECT_SR1:
+	case NOR_SR1:
 		ReadSRCmd = NOR_READ_SR1;
 		SrUpdateHandler = &nor->_internal.u8StatusReg1;
 		break;
-	case _SELECT_SR2:
+	case NOR_SR2:
 		ReadSRCmd = NOR_READ_SR2;
-		SrUpdateHandler = &nor->_internal.u8StatusReg1;
+		SrUpdateHandler = &nor->_internal.u8StatusReg2;
 		break;
-	case _SELECT_SR3:
+	case NOR_SR3:
 		ReadSRCmd = NOR_READ_SR3;
-		SrUpdateHandler = &nor->_internal.u8StatusReg1;
+		SrUpdateHandler = &nor->_internal.u8StatusReg3;
 		break;
 	default:
 		return 0xFF;
@@ -151,22 +413,22 @@ uint8_t _nor_ReadStatusRegister(nor_t *nor, enum _nor_sr_select_e SelectSR)
 	return status;
 }
 
-void _nor_WriteStatusRegister(nor_t *nor, enum _nor_sr_select_e SelectSR, uint8_t data)
+void _nor_WriteStatusRegister(nor_t *nor, nor_sr_e SelectSR, uint8_t data)
 {
 	uint8_t WriteSR[2];
 
 	switch (SelectSR){
-	case _SELECT_SR1:
+	case NOR_SR1:
 		WriteSR[0] = NOR_WRITE_SR1;
 		nor->_internal.u8StatusReg1 = data;
 		break;
-	case _SELECT_SR2:
+	case NOR_SR2:
 		WriteSR[0] = NOR_WRITE_SR2;
-		nor->_internal.u8StatusReg1 = data;
+		nor->_internal.u8StatusReg2 = data;
 		break;
-	case _SELECT_SR3:
+	case NOR_SR3:
 		WriteSR[0] = NOR_WRITE_SR3;
-		nor->_internal.u8StatusReg1 = data;
+		nor->_internal.u8StatusReg3 = data;
 		break;
 	default:
 		return ;
@@ -177,37 +439,335 @@ void _nor_WriteStatusRegister(nor_t *nor, enum _nor_sr_select_e SelectSR, uint8_
 	_nor_cs_deassert(nor);
 }
 
+/*
+ * Read the status registers to the copies. The MXIC devices have only SR1,
+ * and 0x35 (Read SR2 on the others) enters on QPI mode on them.
+ */
+static void _nor_ReadStatusAll(nor_t *nor){
+	_nor_ReadStatusRegister(nor, NOR_SR1);
+	if (nor->Manufacturer != MANUF_MXIC){
+		_nor_ReadStatusRegister(nor, NOR_SR2);
+		_nor_ReadStatusRegister(nor, NOR_SR3);
+	}
+}
+
+/*
+ * Every program and erase is started here, and its fail flags are checked on
+ * the completion.
+ */
+static void _nor_timing_start(nor_t *nor, nor_timing_e Op, uint32_t Address){
+	nor->_internal.u8FailOp = Op;
+	nor->_internal.u32FailAddr = Address;
+	if (!_NOR_HAS_FXN(nor, TimeUs, TimeUsFxn)){
+		return;
+	}
+	nor->_internal.u8TimingOp = Op;
+	nor->_internal.u32TimingAddr = Address;
+	nor->_internal.u32TimingStart = _nor_time_us(nor);
+}
+
+static uint32_t _nor_timing_ewma(uint32_t Avg, uint32_t Sample){
+	if (Avg == 0){
+		return Sample;
+	}
+	return Avg - (Avg >> NOR_TIMING_EWMA_SHIFT) + (Sample >> NOR_TIMING_EWMA_SHIFT);
+}
+
+/*
+ * Called when the operation was seen completed. The duration is learned only
+ * when it's Accurate, the completion was seen close to the time it happened,
+ * not on a poll done long after, like of a posted operation.
+ */
+static void _nor_timing_end(nor_t *nor, uint8_t Accurate){
+	uint32_t Sample, Sector, SectorUs;
+	uint8_t Op = nor->_internal.u8TimingOp;
+
+	if (Op == _NOR_TIMING_NONE){
+		return;
+	}
+	nor->_internal.u8TimingOp = _NOR_TIMING_NONE;
+	if (Accurate == 0){
+		return;
+	}
+	Sample = _nor_time_us(nor) - nor->_internal.u32TimingStart;
+	nor->timing.u32AvgUs[Op] = _nor_timing_ewma(nor->timing.u32AvgUs[Op], Sample);
+	if (Sample > nor->timing.u32MaxUs[Op]){
+		nor->timing.u32MaxUs[Op] = Sample;
+	}
+	nor->timing.u32Samples[Op]++;
+	if (Op == NOR_TIMING_PROGRAM && nor->timing.u32Samples[Op] >= NOR_TIMING_MIN_SAMPLES &&
+			(Sample / NOR_TIMING_SLOW_PERCENT) > (nor->timing.u32AvgUs[Op] / 100)){
+		NOR_PRINTF("WARNING: Slow program on 0x%08X, %d us\n\r", (uint)nor->_internal.u32TimingAddr, (int)Sample);
+		nor->timing.u32SlowPrograms++;
+	}
+	if (Op != NOR_TIMING_ERASE_4K || nor->config.pSectorEraseTime == NULL){
+		return;
+	}
+	// the average of each sector, to find the ones wearing faster
+	Sector = nor->_internal.u32TimingAddr / nor->info.u16SectorSize;
+	SectorUs = _nor_timing_ewma(nor->config.pSectorEraseTime[Sector] * NOR_TIMING_SECTOR_UNIT_US, Sample);
+	nor->config.pSectorEraseTime[Sector] = (SectorUs / NOR_TIMING_SECTOR_UNIT_US > 0xFFFF) ? 0xFFFF :
+			(SectorUs / NOR_TIMING_SECTOR_UNIT_US);
+	if (nor->timing.u32Samples[Op] >= NOR_TIMING_MIN_SAMPLES &&
+			(SectorUs / NOR_TIMING_SLOW_PERCENT) > (nor->timing.u32AvgUs[Op] / 100)){
+		NOR_PRINTF("WARNING: Slow erase on the sector %d, %d us\n\r", (int)Sector, (int)SectorUs);
+		nor->timing.u32SlowErases++;
+		if (_NOR_HAS_FXN(nor, SlowSector, SlowSectorFxn)){
+			_nor_slow_sector(nor, Sector, SectorUs);
+		}
+	}
+}
+
+/*
+ * Called when the program or erase was seen completed. The MXIC devices keep
+ * the result on the security register, the others don't report the failures,
+ * that are caught only by the Verify. The erase suspended is checked when
+ * it completes, after the resume, and the programs done meanwhile are checked
+ * on their own completion.
+ */
+static nor_err_e _nor_CheckFail(nor_t *nor){
+	uint8_t ReadScurCmd = NOR_READ_SCUR_MXIC;
+	uint8_t Scur, Op = nor->_internal.u8FailOp;
+
+	if (Op == _NOR_TIMING_NONE){
+		return NOR_OK;
+	}
+	nor->_internal.u8FailOp = _NOR_TIMING_NONE;
+	if (nor->Manufacturer != MANUF_MXIC){
+		return NOR_OK;
+	}
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, &ReadScurCmd, sizeof(ReadScurCmd));
+	_nor_spi_rx(nor, &Scur, sizeof(Scur));
+	_nor_cs_deassert(nor);
+	// only the flag of the operation checked, the other may be of a suspended erase
+	if (Op == NOR_TIMING_PROGRAM){
+		if (Scur & SCUR_PFAIL_BIT){
+			NOR_PRINTF("ERROR: The device reported a program fail\n\r");
+			nor->stats.u32ProgramFails++;
+			return NOR_PROGRAM_FAILED;
+		}
+	}
+	else if (Scur & SCUR_EFAIL_BIT){
+		NOR_PRINTF("ERROR: The device reported an erase fail\n\r");
+		nor->stats.u32EraseFails++;
+		return NOR_ERASE_FAILED;
+	}
+	return NOR_OK;
+}
+
+/*
+ * The wait of the posted operation, before start other one, sees its failure.
+ * The failure isn't of the new operation, it's kept until NOR_Sync or
+ * NOR_IsBusy, and only a timeout is returned.
+ */
+static nor_err_e _nor_LatchFail(nor_t *nor, nor_err_e err){
+	if (err != NOR_PROGRAM_FAILED && err != NOR_ERASE_FAILED){
+		return err;
+	}
+	if (nor->_internal.u8FailErr == NOR_OK){
+		nor->_internal.u8FailErr = err;
+	}
+	return NOR_OK;
+}
+
+static nor_err_e _nor_TakeFail(nor_t *nor){
+	nor_err_e err = (nor_err_e)nor->_internal.u8FailErr;
+
+	nor->_internal.u8FailErr = NOR_OK;
+	return err;
+}
+
+/*
+ * The lock can be released while waiting an operation left by a posted call,
+ * whose failure is kept for NOR_Sync whoever sees it. The operations of the
+ * caller are waited with the lock held, so only the caller checks their
+ * result, and a multi-page write isn't interleaved with other writers. A
+ * suspended erase must be resumed before other task use the device, and a
+ * batch keeps the bus until the end.
+ */
+static uint8_t _nor_can_release(nor_t *nor){
+	return (nor->_internal.u8Posted && nor->_internal.u8Suspended == 0 && nor->_internal.u8Batch == 0);
+}
+
+/*
+ * Wait between the polls, out of the lock when _nor_can_release allows it.
+ */
+static void _nor_busy_delay(nor_t *nor, uint32_t us){
+	if (_nor_can_release(nor) == 0){
+		_nor_delay_us(nor, us);
+	}
+	else{
+		_nor_mtx_unlock(nor);
+		_nor_delay_us(nor, us);
+		_nor_mtx_lock(nor);
+	}
+}
+
 nor_err_e _nor_WaitForBusy(nor_t *nor, uint32_t msTimeout, uint32_t *remaining)
 {
 	uint8_t ReadSr1Cmd = NOR_READ_SR1;
-	uint32_t usTimeout;
+	uint8_t Ready, Accurate = 0;
+	uint32_t usTimeout, Expected = 0, Elapsed, Delay;
 
 	if (remaining != NULL){
 		*remaining = 0;
 	}
+	if (_NOR_HAS_FXN(nor, WaitReady, WaitReadyFxn) && nor->_internal.u8BusyPending){
+		// the host signals the completion, the CPU is free meanwhile
+		if (_nor_can_release(nor) == 0){
+			Ready = _nor_wait_ready(nor, msTimeout);
+		}
+		else{
+			_nor_mtx_unlock(nor);
+			Ready = _nor_wait_ready(nor, msTimeout);
+			_nor_mtx_lock(nor);
+		}
+		if (Ready == 0){
+			return NOR_FAIL;
+		}
+		// usually the first poll confirms it's ready
+		msTimeout = 1;
+		Accurate = 1;
+	}
 	// Convert Ms to Us timeout
 	usTimeout = 1000 * msTimeout;
-	_nor_cs_assert(nor);
-	_nor_spi_tx(nor, (uint8_t*)&ReadSr1Cmd, sizeof(ReadSr1Cmd));
-	// Dummy read from status register
-	_nor_spi_rx(nor, &nor->_internal.u8StatusReg1, sizeof(uint8_t));
-	do{
+	// the first poll is scheduled near the completion learned for the operation
+	if (Accurate == 0 && nor->_internal.u8TimingOp != _NOR_TIMING_NONE){
+		Expected = nor->timing.u32AvgUs[nor->_internal.u8TimingOp];
+		Delay = (Expected / 100) * NOR_TIMING_FIRST_POLL_PERCENT;
+		Elapsed = _nor_time_us(nor) - nor->_internal.u32TimingStart;
+		if (Elapsed < Delay && (Delay - Elapsed) < usTimeout){
+			_nor_busy_delay(nor, Delay - Elapsed);
+			usTimeout -= (Delay - Elapsed);
+			Accurate = 1;
+		}
+	}
+	/*
+	 * Each poll is a single transaction, and the lock may be released while
+	 * waiting the next poll, see _nor_can_release. The caller must hold the lock.
+	 */
+	while (1){
+		_nor_cs_assert(nor);
+		_nor_spi_tx(nor, (uint8_t*)&ReadSr1Cmd, sizeof(ReadSr1Cmd));
 		_nor_spi_rx(nor, &nor->_internal.u8StatusReg1, sizeof(uint8_t));
-		_nor_delay_us(nor, 100);
-		usTimeout -= 100;
-	}while ((nor->_internal.u8StatusReg1 & SR1_BUSY_BIT) && (usTimeout > 0));
-	_nor_cs_deassert(nor);
-
-	msTimeout = usTimeout/1000;
-	if (msTimeout == 0){
-		return NOR_FAIL;
+		_nor_cs_deassert(nor);
+		if ((nor->_internal.u8StatusReg1 & SR1_BUSY_BIT) == 0){
+			break;
+		}
+		if (usTimeout < 100){
+			return NOR_FAIL;
+		}
+		// it was still running, the completion will be seen within a poll
+		Accurate = 1;
+		Delay = 100;
+		if (Expected > 0){
+			// halve the time left to the expected completion
+			Elapsed = _nor_time_us(nor) - nor->_internal.u32TimingStart;
+			if (Elapsed < Expected && ((Expected - Elapsed) / 2) > Delay){
+				Delay = (Expected - Elapsed) / 2;
+			}
+		}
+		if (Delay > usTimeout){
+			Delay = usTimeout;
+		}
+		_nor_busy_delay(nor, Delay);
+		usTimeout -= Delay;
 	}
+
 	if (remaining != NULL){
-		*remaining = msTimeout;
+		*remaining = usTimeout/1000;
+	}
+	nor->_internal.u8BusyPending = 0;
+	_nor_timing_end(nor, Accurate);
+	return _nor_CheckFail(nor);
+}
+
+/*
+ * Mark an erase as posted, with the range it clears, so the accesses to the
+ * range are not done while it is suspended.
+ */
+static void _nor_erase_pending(nor_t *nor, uint32_t Address, uint32_t Size, uint32_t TimeoutMs){
+	nor->_internal.u8BusyPending = _NOR_PENDING_ERASE;
+	nor->_internal.u32EraseMs = TimeoutMs;
+	nor->_internal.u32EraseAddr = Address;
+	nor->_internal.u32EraseSize = Size;
+}
+
+static nor_err_e _nor_WaitPending(nor_t *nor){
+	// only posted operations leave the device busy after the routine returns
+	if (nor->_internal.u8BusyPending == 0){
+		return NOR_OK;
+	}
+	if (nor->_internal.u8BusyPending == _NOR_PENDING_ERASE){
+		return _nor_WaitForBusy(nor, nor->_internal.u32EraseMs, NULL);
+	}
+	return _nor_WaitForBusy(nor, NOR_EXPECT_PAGE_PROG_TIME, NULL);
+}
+
+/*
+ * Prepare the device to a read or a program of the range, suspending the
+ * posted erase when enabled, or waiting the posted operation. An erase of the
+ * range is waited, its content is undefined until the end. The caller holds
+ * the lock, and must call _nor_ResumePending before release it.
+ */
+static nor_err_e _nor_SuspendPending(nor_t *nor, uint32_t Address, uint32_t NumBytes){
+	uint8_t SuspendCmd = NOR_ER_PROG_SUSPEND;
+
+	if (nor->_internal.u8BusyPending != _NOR_PENDING_ERASE || nor->config.EraseSuspend == 0){
+		return _nor_WaitPending(nor);
+	}
+	if (Address < (nor->_internal.u32EraseAddr + nor->_internal.u32EraseSize) &&
+			nor->_internal.u32EraseAddr < (Address + NumBytes)){
+		nor->stats.u32SuspendWaits++;
+		return _nor_WaitPending(nor);
+	}
+	// the erase may be already done, and there is nothing to suspend
+	if ((_nor_ReadStatusRegister(nor, NOR_SR1) & SR1_BUSY_BIT) == 0){
+		nor->_internal.u8BusyPending = 0;
+		_nor_timing_end(nor, 0);
+		return _nor_CheckFail(nor);
+	}
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, &SuspendCmd, sizeof(SuspendCmd));
+	_nor_cs_deassert(nor);
+	// the suspended time would be learned as part of the erase
+	nor->_internal.u8TimingOp = _NOR_TIMING_NONE;
+	// the erase is checked after the resume
+	nor->_internal.u8SuspendedFailOp = nor->_internal.u8FailOp;
+	nor->_internal.u32SuspendedFailAddr = nor->_internal.u32FailAddr;
+	nor->_internal.u8FailOp = _NOR_TIMING_NONE;
+	nor->_internal.u8Suspended = 1;
+	nor->_internal.u8BusyPending = _NOR_PENDING_PROGRAM;
+	if (_nor_WaitForBusy(nor, NOR_EXPECT_SUSPEND_TIME, NULL) != NOR_OK){
+		// the device ignored the suspend, wait the erase
+		nor->_internal.u8Suspended = 0;
+		nor->_internal.u8FailOp = nor->_internal.u8SuspendedFailOp;
+		nor->_internal.u32FailAddr = nor->_internal.u32SuspendedFailAddr;
+		nor->_internal.u8BusyPending = _NOR_PENDING_ERASE;
+		return _nor_WaitPending(nor);
 	}
+
 	return NOR_OK;
 }
 
+static void _nor_ResumePending(nor_t *nor){
+	uint8_t ResumeCmd = NOR_ER_PROG_RESUME;
+
+	if (nor->_internal.u8Suspended == 0){
+		return;
+	}
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, &ResumeCmd, sizeof(ResumeCmd));
+	_nor_cs_deassert(nor);
+	nor->_internal.u8Suspended = 0;
+	nor->_internal.u8BusyPending = _NOR_PENDING_ERASE;
+	nor->_internal.u8FailOp = nor->_internal.u8SuspendedFailOp;
+	nor->_internal.u32FailAddr = nor->_internal.u32SuspendedFailAddr;
+	// back-to-back suspends would starve the erase
+	_nor_delay_us(nor, NOR_RESUME_HOLD_US);
+}
+
 nor_err_e _nor_check_buff_is_empty(uint8_t *pBuffer, uint32_t len){
 	uint32_t i;
 
@@ -220,38 +780,665 @@ nor_err_e _nor_check_buff_is_empty(uint8_t *pBuffer, uint32_t len){
 	return NOR_OK;
 }
 
-/*
- * Publics
- */
-
-nor_err_e NOR_Init(nor_t *nor){
-	uint8_t ExitPDCmd = NOR_RELEASE_PD;
+static void _nor_ReadCrc(nor_t *nor, uint32_t Address, uint32_t NumBytes, uint32_t *pCrc){
+	uint8_t pBuffer[NOR_CRC_BUFFER_LEN];
+	uint8_t ReadCmd[_NOR_READ_CMD_MAX];
+	uint32_t Chunk, CmdLen;
 
-	if (nor == NULL || nor->config.CsAssert == NULL ||
-			nor->config.CsDeassert == NULL || nor->config.DelayUs == NULL ||
-			nor->config.SpiRxFxn == NULL || nor->config.SpiTxFxn == NULL){
-		NOR_PRINTF("ERROR: Invalid Parameters on %s function\n\r", __func__);
-		return NOR_INVALID_PARAMS;
-	}
-	if (nor->_internal.u16Initialized == NOR_INITIALIZED_FLAG){
-		// the flash instance is already initialized
-		NOR_PRINTF("Warning: Flash is already initialized.\n\r");
-		return NOR_OK;
+	CmdLen = _nor_read_cmd(nor, ReadCmd, Address);
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, ReadCmd, CmdLen);
+	// the device keeps streaming while CS is asserted, the CRC is updated chunk by chunk
+	while (NumBytes > 0){
+		Chunk = (NumBytes > NOR_CRC_BUFFER_LEN) ? NOR_CRC_BUFFER_LEN : NumBytes;
+		_nor_spi_rx(nor, pBuffer, Chunk);
+		*pCrc = NOR_CRC32(*pCrc, pBuffer, Chunk);
+		NumBytes -= Chunk;
 	}
-	// we must have sure that the NOR has your CS pin deasserted
 	_nor_cs_deassert(nor);
-	_nor_delay_us(nor, 100);
+}
 
-	// we are assuming, on startup, that the Flash is on Power Down State
-	nor->_internal.u8PdCount = 0;
-	nor->pdState = NOR_IN_IDLE;
-	_nor_cs_assert(nor);
-	_nor_spi_tx(nor, &ExitPDCmd, sizeof(ExitPDCmd));
-	_nor_cs_deassert(nor);
+static nor_err_e _nor_WriteBytes(nor_t *nor, uint8_t *pBuffer, uint32_t WriteAddr, uint32_t NumBytesToWrite, uint8_t Posted){
+	uint8_t WriteCmd[4];
+	uint32_t _BytesToWrite, Crc;
+	nor_err_e err = NOR_OK, WaitErr;
 
-	nor->info.u32JedecID = _nor_ReadID(nor);
-	if (nor->info.u32JedecID == 0x000000 || nor->info.u32JedecID == 0xFFFFFF){
-		// invalid Id, I thing we don't has any flash on SPI
+	if (NumBytesToWrite == 0){
+		NOR_PRINTF("ERROR: Invalid parameters on NOR_WriteBytes\n\r");
+		return NOR_INVALID_PARAMS;
+	}
+	if (WriteAddr >= nor->info.u32Size || NumBytesToWrite > (nor->info.u32Size - WriteAddr)){
+		NOR_PRINTF("ERROR: NOR_WriteBytes beyond the end of the device\n\r");
+		return NOR_OUT_OF_RANGE;
+	}
+	NOR_PRINTF("Writing %d bytes into Address %08X.\n\r", (uint)NumBytesToWrite, (uint)WriteAddr);
+	NOR_PRINTF("Buffer to Write into Flash:\n\r");
+	NOR_PRINTF("====================== Values in HEX ========================");
+	for (uint32_t i = 0; i < NumBytesToWrite; i++)
+	{
+		if (i % 16 == 0)
+		{
+			NOR_PRINTF("\r\n");
+			NOR_PRINTF("0x%08X | ", (uint)(WriteAddr + i));
+		}
+		NOR_PRINTF("%02X ", pBuffer[i]);
+	}
+	NOR_PRINTF("\n\r=============================================================\n\r");
+	_nor_mtx_lock(nor);
+	if (nor->_internal.u8BusyPending == 0){
+		nor->stats.u32SkippedPolls++;
+	}
+	if (_nor_LatchFail(nor, _nor_SuspendPending(nor, WriteAddr, NumBytesToWrite)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		NOR_PRINTF("Write failed.!\n\r\n\r");
+		return NOR_FAIL;
+	}
+	// the erase is resumed only after the last page
+	if (nor->_internal.u8Suspended){
+		Posted = 0;
+	}
+	do{
+		// Wait for Busy is deasserted to write any information
+		WaitErr = _nor_WaitPending(nor);
+		if (WaitErr != NOR_OK){
+			_nor_ResumePending(nor);
+			_nor_mtx_unlock(nor);
+			NOR_PRINTF("Write failed.!\n\r\n\r");
+			return (WaitErr == NOR_PROGRAM_FAILED) ? WaitErr : NOR_FAIL;
+		}
+		if (((WriteAddr%nor->info.u16PageSize)+NumBytesToWrite) > nor->info.u16PageSize){
+			_BytesToWrite = nor->info.u16PageSize - (WriteAddr%nor->info.u16PageSize);
+		}
+		else{
+			_BytesToWrite = NumBytesToWrite;
+		}
+		_nor_WriteEnable(nor);
+		WriteCmd[0] = NOR_PAGE_PROGRAM;
+		WriteCmd[1] = ((WriteAddr >> 16) & 0xFF);
+		WriteCmd[2] = ((WriteAddr >> 8) & 0xFF);
+		WriteCmd[3] = ((WriteAddr) & 0xFF);
+		_nor_cs_assert(nor);
+		_nor_spi_tx(nor, WriteCmd, sizeof(WriteCmd));
+		_nor_spi_tx(nor, pBuffer, _BytesToWrite);
+		_nor_cs_deassert(nor);
+		nor->_internal.u8BusyPending = _NOR_PENDING_PROGRAM;
+		_nor_timing_start(nor, NOR_TIMING_PROGRAM, WriteAddr);
+		if (nor->config.Verify){
+			WaitErr = _nor_WaitForBusy(nor, NOR_EXPECT_PAGE_PROG_TIME, NULL);
+			if (WaitErr != NOR_OK){
+				_nor_ResumePending(nor);
+				_nor_mtx_unlock(nor);
+				NOR_PRINTF("Write failed.!\n\r\n\r");
+				return (WaitErr == NOR_PROGRAM_FAILED) ? WaitErr : NOR_FAIL;
+			}
+			Crc = 0;
+			_nor_ReadCrc(nor, WriteAddr, _BytesToWrite, &Crc);
+			if (Crc != NOR_CRC32(0, pBuffer, _BytesToWrite)){
+				NOR_PRINTF("ERROR: Verify failed on the page 0x%08X\n\r", (uint)WriteAddr);
+				if (_NOR_HAS_FXN(nor, VerifyFail, VerifyFailFxn)){
+					_nor_verify_fail(nor, WriteAddr - (WriteAddr % nor->info.u16PageSize));
+				}
+				err = NOR_VERIFY_FAILED;
+			}
+		}
+		pBuffer += _BytesToWrite;
+		WriteAddr += _BytesToWrite;
+		NumBytesToWrite -= _BytesToWrite;
+	}while (NumBytesToWrite > 0);
+	// on posted mode, the next operation will wait the last page be programmed
+	if (Posted == 0){
+		// release the routine only when the data is writted
+		WaitErr = _nor_WaitForBusy(nor, NOR_EXPECT_PAGE_PROG_TIME, NULL);
+		if (WaitErr != NOR_OK){
+			_nor_ResumePending(nor);
+			_nor_mtx_unlock(nor);
+			NOR_PRINTF("Write failed.!\n\r\n\r");
+			return (WaitErr == NOR_PROGRAM_FAILED) ? WaitErr : NOR_FAIL;
+		}
+	}
+	_nor_ResumePending(nor);
+	_nor_mtx_unlock(nor);
+	NOR_PRINTF("Write done.!\n\r\n\r");
+
+	return err;
+}
+
+static nor_err_e _nor_EraseAddress(nor_t *nor, uint32_t Address, nor_erase_method_e method, uint8_t Posted){
+	uint8_t EraseChipCmd[4];
+	uint32_t expectedTimeoutMs, remaining, Size;
+	nor_err_e err;
+
+	switch (method){
+	case NOR_ERASE_4K:
+		NOR_PRINTF("Erasing 4 KBytes on 0x%08X Address... ", (uint)Address);
+		EraseChipCmd[0] = NOR_SECTOR_ERASE_4K;
+		expectedTimeoutMs = NOR_EXPECT_4K_ERASE_TIME;
+		Size = nor->info.u16SectorSize;
+		break;
+	case NOR_ERASE_32K:
+		NOR_PRINTF("Erasing 32 KBytes on 0x%08X Address... ", (uint)Address);
+		EraseChipCmd[0] = NOR_SECTOR_ERASE_32K;
+		expectedTimeoutMs = NOR_EXPECT_32K_ERASE_TIME;
+		Size = 32*1024;
+		break;
+	case NOR_ERASE_64K:
+		NOR_PRINTF("Erasing 64 KBytes on 0x%08X Address... ", (uint)Address);
+		EraseChipCmd[0] = NOR_SECTOR_ERASE_64K;
+		expectedTimeoutMs = NOR_EXPECT_64K_ERASE_TIME;
+		Size = nor->info.u32BlockSize;
+		break;
+	default:
+		return NOR_INVALID_PARAMS;
+	}
+	if (Address >= nor->info.u32Size){
+		return NOR_OUT_OF_RANGE;
+	}
+	EraseChipCmd[1] = ((Address >> 16) & 0xFF);
+	EraseChipCmd[2] = ((Address >> 8) & 0xFF);
+	EraseChipCmd[3] = ((Address) & 0xFF);
+
+	_nor_mtx_lock(nor);
+	if (_nor_LatchFail(nor, _nor_WaitPending(nor)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		NOR_PRINTF("FAILED!\n\r");
+		return NOR_FAIL;
+	}
+	_nor_WriteEnable(nor);
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, EraseChipCmd, sizeof(EraseChipCmd));
+	_nor_cs_deassert(nor);
+	_nor_erase_pending(nor, Address - (Address % Size), Size, expectedTimeoutMs);
+	_nor_timing_start(nor, NOR_TIMING_ERASE_4K + method, Address);
+	if (Posted){
+		_nor_mtx_unlock(nor);
+		NOR_PRINTF("posted\n\r");
+		return NOR_OK;
+	}
+	err = _nor_WaitForBusy(nor, expectedTimeoutMs, &remaining);
+	_nor_mtx_unlock(nor);
+	if (err != NOR_OK){
+		NOR_PRINTF("FAILED!\n\r");
+	}
+	else{
+		NOR_PRINTF("OK in %d ms!\n\r", (int)(expectedTimeoutMs - remaining));
+	}
+
+	return err;
+}
+
+static uint32_t _nor_op_timeout_us(nor_op_t *op){
+	switch (op->Type){
+	case NOR_OP_ERASE_CHIP:
+		return NOR_EXPECT_ERASE_CHIP * 1000;
+	case NOR_OP_ERASE:
+		if (op->Method == NOR_ERASE_64K){
+			return NOR_EXPECT_64K_ERASE_TIME * 1000;
+		}
+		if (op->Method == NOR_ERASE_32K){
+			return NOR_EXPECT_32K_ERASE_TIME * 1000;
+		}
+		return NOR_EXPECT_4K_ERASE_TIME * 1000;
+	default:
+		return NOR_EXPECT_PAGE_PROG_TIME * 1000;
+	}
+}
+
+static nor_err_e _nor_op_check(nor_op_t *op){
+	_SANITY_CHECK(op->nor);
+
+	switch (op->Type){
+	case NOR_OP_ERASE_CHIP:
+		return NOR_OK;
+	case NOR_OP_ERASE:
+		if (op->Method > NOR_ERASE_64K){
+			return NOR_INVALID_PARAMS;
+		}
+		return (op->Address < op->nor->info.u32Size) ? NOR_OK : NOR_OUT_OF_RANGE;
+	case NOR_OP_PROGRAM:
+		if (op->pBuffer == NULL || op->Len == 0){
+			return NOR_INVALID_PARAMS;
+		}
+		return ((op->Address + op->Len) <= op->nor->info.u32Size) ? NOR_OK : NOR_OUT_OF_RANGE;
+	default:
+		return NOR_INVALID_PARAMS;
+	}
+}
+
+static nor_timing_e _nor_op_timing(nor_op_t *op){
+	switch (op->Type){
+	case NOR_OP_ERASE_CHIP:
+		return NOR_TIMING_ERASE_CHIP;
+	case NOR_OP_ERASE:
+		return NOR_TIMING_ERASE_4K + op->Method;
+	default:
+		return NOR_TIMING_PROGRAM;
+	}
+}
+
+static void _nor_batch_range(nor_t *nor, nor_op_t *op, uint32_t *pStart, uint32_t *pSize){
+	switch (op->Type){
+	case NOR_OP_ERASE_CHIP:
+		*pSize = nor->info.u32Size;
+		break;
+	case NOR_OP_ERASE:
+		if (op->Method == NOR_ERASE_64K){
+			*pSize = nor->info.u32BlockSize;
+		}
+		else if (op->Method == NOR_ERASE_32K){
+			*pSize = 32*1024;
+		}
+		else{
+			*pSize = nor->info.u16SectorSize;
+		}
+		break;
+	default:
+		*pSize = op->Len;
+		*pStart = op->Address + op->_internal.u32Offset;
+		return;
+	}
+	*pStart = op->Address - (op->Address % *pSize);
+}
+
+static nor_err_e _nor_op_issue(nor_op_t *op){
+	nor_t *nor = op->nor;
+	uint8_t Cmd[4];
+	uint32_t Address, Start, Size, CmdLen = sizeof(Cmd), Len = 0;
+
+	Address = op->Address + op->_internal.u32Offset;
+	switch (op->Type){
+	case NOR_OP_ERASE_CHIP:
+		Cmd[0] = NOR_CHIP_ERASE;
+		CmdLen = 1;
+		break;
+	case NOR_OP_ERASE:
+		Cmd[0] = (op->Method == NOR_ERASE_64K) ? NOR_SECTOR_ERASE_64K :
+				(op->Method == NOR_ERASE_32K) ? NOR_SECTOR_ERASE_32K : NOR_SECTOR_ERASE_4K;
+		break;
+	default:
+		Cmd[0] = NOR_PAGE_PROGRAM;
+		Len = nor->info.u16PageSize - (Address % nor->info.u16PageSize);
+		if (Len > (op->Len - op->_internal.u32Offset)){
+			Len = op->Len - op->_internal.u32Offset;
+		}
+		break;
+	}
+	Cmd[1] = ((Address >> 16) & 0xFF);
+	Cmd[2] = ((Address >> 8) & 0xFF);
+	Cmd[3] = ((Address) & 0xFF);
+
+	_nor_mtx_lock(nor);
+	if (_nor_LatchFail(nor, _nor_WaitPending(nor)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		return NOR_FAIL;
+	}
+	_nor_WriteEnable(nor);
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, Cmd, CmdLen);
+	if (Len > 0){
+		_nor_spi_tx(nor, op->pBuffer + op->_internal.u32Offset, Len);
+	}
+	_nor_cs_deassert(nor);
+	if (op->Type == NOR_OP_PROGRAM){
+		nor->_internal.u8BusyPending = _NOR_PENDING_PROGRAM;
+	}
+	else{
+		_nor_batch_range(nor, op, &Start, &Size);
+		_nor_erase_pending(nor, Start, Size, _nor_op_timeout_us(op) / 1000);
+	}
+	_nor_timing_start(nor, _nor_op_timing(op), Address);
+	_nor_mtx_unlock(nor);
+	op->_internal.u32Issued = Len;
+	op->_internal.u32WaitedUs = 0;
+	if (_NOR_HAS_FXN(nor, TimeUs, TimeUsFxn)){
+		op->_internal.u32StartUs = _nor_time_us(nor);
+	}
+	op->_internal.u8InFlight = 1;
+
+	return NOR_OK;
+}
+
+static uint8_t _nor_op_is_busy(nor_op_t *op){
+	nor_t *nor = op->nor;
+	uint8_t Busy;
+
+	_nor_mtx_lock(nor);
+	Busy = (_nor_ReadStatusRegister(nor, NOR_SR1) & SR1_BUSY_BIT);
+	if (Busy == 0){
+		nor->_internal.u8BusyPending = 0;
+		// seen busy on the previous round, the completion is within a round
+		_nor_timing_end(nor, (op->_internal.u32WaitedUs > 0));
+		op->Result = _nor_CheckFail(nor);
+	}
+	_nor_mtx_unlock(nor);
+
+	return Busy;
+}
+
+/*
+ * Time the operation is busy, measured when TimeUs is available, or counted
+ * on the polling delays of NOR_MultiExecute.
+ */
+static uint32_t _nor_op_waited_us(nor_op_t *op){
+	if (_NOR_HAS_FXN(op->nor, TimeUs, TimeUsFxn)){
+		op->_internal.u32WaitedUs = _nor_time_us(op->nor) - op->_internal.u32StartUs;
+	}
+	return op->_internal.u32WaitedUs;
+}
+
+static uint8_t _nor_batch_kind(nor_op_t *op){
+	// the erases of a run can be merged, the chip erase covers all of them
+	return (op->Type == NOR_OP_ERASE_CHIP) ? NOR_OP_ERASE : op->Type;
+}
+
+static nor_err_e _nor_batch_check(nor_t *nor, nor_op_t *op){
+	switch (op->Type){
+	case NOR_OP_ERASE_CHIP:
+		return NOR_OK;
+	case NOR_OP_ERASE:
+		if (op->Method > NOR_ERASE_64K){
+			return NOR_INVALID_PARAMS;
+		}
+		return (op->Address < nor->info.u32Size) ? NOR_OK : NOR_OUT_OF_RANGE;
+	case NOR_OP_PROGRAM:
+	case NOR_OP_READ:
+		if (op->pBuffer == NULL || op->Len == 0){
+			return NOR_INVALID_PARAMS;
+		}
+		if (op->Address >= nor->info.u32Size || op->Len > (nor->info.u32Size - op->Address)){
+			return NOR_OUT_OF_RANGE;
+		}
+		return NOR_OK;
+	default:
+		return NOR_INVALID_PARAMS;
+	}
+}
+
+/*
+ * The failure reported by the device is of the page or of the erase started
+ * last, and is given to the operations of the batch on its range.
+ */
+static void _nor_batch_fail(nor_t *nor, nor_op_t *pAll, uint32_t AllCount, uint8_t FailOp, nor_err_e err){
+	nor_op_t Failed;
+	uint32_t i, Start, Size, OpStart, OpSize;
+
+	memset(&Failed, 0, sizeof(Failed));
+	Failed.Address = nor->_internal.u32FailAddr;
+	switch (FailOp){
+	case NOR_TIMING_ERASE_CHIP:
+		Failed.Type = NOR_OP_ERASE_CHIP;
+		break;
+	case NOR_TIMING_PROGRAM:
+		Failed.Type = NOR_OP_PROGRAM;
+		Failed.Len = nor->info.u16PageSize;
+		break;
+	default:
+		Failed.Type = NOR_OP_ERASE;
+		Failed.Method = (nor_erase_method_e)(FailOp - NOR_TIMING_ERASE_4K);
+		break;
+	}
+	_nor_batch_range(nor, &Failed, &Start, &Size);
+	for (i=0 ; i<AllCount ; i++){
+		if (_nor_batch_kind(&pAll[i]) != _nor_batch_kind(&Failed)){
+			continue;
+		}
+		if (pAll[i].Type == NOR_OP_PROGRAM){
+			OpStart = pAll[i].Address;
+			OpSize = pAll[i].Len;
+		}
+		else{
+			_nor_batch_range(nor, &pAll[i], &OpStart, &OpSize);
+		}
+		if (OpStart < (Start + Size) && Start < (OpStart + OpSize)){
+			pAll[i].Result = err;
+		}
+	}
+}
+
+/*
+ * Wait the last program or erase of the batch, its failure is given to the
+ * operations on its range, the batch continues.
+ */
+static nor_err_e _nor_batch_wait(nor_t *nor, nor_op_t *pAll, uint32_t AllCount){
+	uint8_t FailOp = nor->_internal.u8FailOp;
+	nor_err_e err;
+
+	if (nor->_internal.u8BusyPending == 0){
+		nor->stats.u32SkippedPolls++;
+		return NOR_OK;
+	}
+	err = _nor_WaitPending(nor);
+	if (err == NOR_PROGRAM_FAILED || err == NOR_ERASE_FAILED){
+		_nor_batch_fail(nor, pAll, AllCount, FailOp, err);
+		return NOR_OK;
+	}
+	return err;
+}
+
+/*
+ * The next operation of the run to be executed, the lowest address first. The
+ * programs of a run can be reordered, since a program only clears bits.
+ */
+static nor_op_t* _nor_batch_next(nor_op_t *pOps, uint32_t Count, uint32_t Address, uint8_t Exact){
+	nor_op_t *next = NULL;
+	uint32_t i, Current;
+
+	for (i=0 ; i<Count ; i++){
+		if (pOps[i]._internal.u8Done){
+			continue;
+		}
+		Current = pOps[i].Address + pOps[i]._internal.u32Offset;
+		if (Exact){
+			if (Current == Address){
+				return &pOps[i];
+			}
+		}
+		else if (next == NULL || Current < (next->Address + next->_internal.u32Offset)){
+			next = &pOps[i];
+		}
+	}
+	return next;
+}
+
+static nor_err_e _nor_batch_erase(nor_t *nor, nor_op_t *pOps, uint32_t Count, nor_op_t *pAll, uint32_t AllCount){
+	uint8_t Cmd[4];
+	uint32_t i, j, Start, Size, OtherStart, OtherSize, CmdLen;
+
+	for (i=0 ; i<Count ; i++){
+		if (pOps[i]._internal.u8Done){
+			continue;
+		}
+		pOps[i]._internal.u8Done = 1;
+		_nor_batch_range(nor, &pOps[i], &Start, &Size);
+		// skip the erases covered by a bigger one, or by the first of the repeated
+		for (j=0 ; j<Count ; j++){
+			if (j == i || pOps[j].Result != NOR_OK){
+				continue;
+			}
+			_nor_batch_range(nor, &pOps[j], &OtherStart, &OtherSize);
+			if (Start >= OtherStart && (Start + Size) <= (OtherStart + OtherSize) && (OtherSize > Size || j < i)){
+				break;
+			}
+		}
+		if (j < Count){
+			nor->stats.u32CoalescedOps++;
+			continue;
+		}
+		if (_nor_batch_wait(nor, pAll, AllCount) != NOR_OK){
+			pOps[i].Result = NOR_FAIL;
+			return NOR_FAIL;
+		}
+		if (pOps[i].Type == NOR_OP_ERASE_CHIP){
+			Cmd[0] = NOR_CHIP_ERASE;
+			CmdLen = 1;
+		}
+		else{
+			Cmd[0] = (pOps[i].Method == NOR_ERASE_64K) ? NOR_SECTOR_ERASE_64K :
+					(pOps[i].Method == NOR_ERASE_32K) ? NOR_SECTOR_ERASE_32K : NOR_SECTOR_ERASE_4K;
+			Cmd[1] = ((Start >> 16) & 0xFF);
+			Cmd[2] = ((Start >> 8) & 0xFF);
+			Cmd[3] = ((Start) & 0xFF);
+			CmdLen = 4;
+		}
+		_nor_WriteEnable(nor);
+		_nor_cs_assert(nor);
+		_nor_spi_tx(nor, Cmd, CmdLen);
+		_nor_cs_deassert(nor);
+		_nor_erase_pending(nor, Start, Size, _nor_op_timeout_us(&pOps[i]) / 1000);
+		_nor_timing_start(nor, _nor_op_timing(&pOps[i]), Start);
+	}
+
+	return NOR_OK;
+}
+
+static nor_err_e _nor_batch_program(nor_t *nor, nor_op_t *pOps, uint32_t Count, nor_op_t *pAll, uint32_t AllCount){
+	nor_op_t *op;
+	uint8_t Cmd[4];
+	uint32_t i, Address, PageEnd, Len, Crc;
+	nor_err_e err = NOR_OK;
+
+	while ((op = _nor_batch_next(pOps, Count, 0, 0)) != NULL){
+		if (_nor_batch_wait(nor, pAll, AllCount) != NOR_OK){
+			op->Result = NOR_FAIL;
+			return NOR_FAIL;
+		}
+		Address = op->Address + op->_internal.u32Offset;
+		PageEnd = Address - (Address % nor->info.u16PageSize) + nor->info.u16PageSize;
+		Cmd[0] = NOR_PAGE_PROGRAM;
+		Cmd[1] = ((Address >> 16) & 0xFF);
+		Cmd[2] = ((Address >> 8) & 0xFF);
+		Cmd[3] = ((Address) & 0xFF);
+		_nor_WriteEnable(nor);
+		_nor_cs_assert(nor);
+		_nor_spi_tx(nor, Cmd, sizeof(Cmd));
+		// the operations that continue on the same page share the Page Program
+		do{
+			Len = op->Len - op->_internal.u32Offset;
+			if (Len > (PageEnd - Address)){
+				Len = PageEnd - Address;
+			}
+			_nor_spi_tx(nor, op->pBuffer + op->_internal.u32Offset, Len);
+			op->_internal.u32Offset += Len;
+			Address += Len;
+			if (op->_internal.u32Offset >= op->Len){
+				op->_internal.u8Done = 1;
+			}
+			if (Address >= PageEnd || (op = _nor_batch_next(pOps, Count, Address, 1)) == NULL){
+				break;
+			}
+			nor->stats.u32CoalescedOps++;
+		}while (1);
+		_nor_cs_deassert(nor);
+		nor->_internal.u8BusyPending = _NOR_PENDING_PROGRAM;
+		_nor_timing_start(nor, NOR_TIMING_PROGRAM, PageEnd - nor->info.u16PageSize);
+	}
+	if (nor->config.Verify){
+		if (_nor_batch_wait(nor, pAll, AllCount) != NOR_OK){
+			return NOR_FAIL;
+		}
+		for (i=0 ; i<Count ; i++){
+			if (pOps[i].Result != NOR_OK){
+				continue;
+			}
+			Crc = 0;
+			_nor_ReadCrc(nor, pOps[i].Address, pOps[i].Len, &Crc);
+			if (Crc != NOR_CRC32(0, pOps[i].pBuffer, pOps[i].Len)){
+				NOR_PRINTF("ERROR: Verify failed on the program of 0x%08X\n\r", (uint)pOps[i].Address);
+				if (_NOR_HAS_FXN(nor, VerifyFail, VerifyFailFxn)){
+					_nor_verify_fail(nor, pOps[i].Address - (pOps[i].Address % nor->info.u16PageSize));
+				}
+				pOps[i].Result = NOR_VERIFY_FAILED;
+				err = NOR_VERIFY_FAILED;
+			}
+		}
+	}
+
+	return err;
+}
+
+static nor_err_e _nor_batch_read(nor_t *nor, nor_op_t *pOps, uint32_t Count, nor_op_t *pAll, uint32_t AllCount){
+	nor_op_t *op;
+	uint8_t ReadCmd[_NOR_READ_CMD_MAX];
+	uint32_t Address, CmdLen;
+
+	if (_nor_batch_wait(nor, pAll, AllCount) != NOR_OK){
+		return NOR_FAIL;
+	}
+	while ((op = _nor_batch_next(pOps, Count, 0, 0)) != NULL){
+		Address = op->Address;
+		CmdLen = _nor_read_cmd(nor, ReadCmd, Address);
+		_nor_cs_assert(nor);
+		_nor_spi_tx(nor, ReadCmd, CmdLen);
+		// the contiguous reads are streamed on the same transaction
+		do{
+			_nor_spi_rx(nor, op->pBuffer, op->Len);
+			op->_internal.u8Done = 1;
+			Address += op->Len;
+			if ((op = _nor_batch_next(pOps, Count, Address, 1)) == NULL){
+				break;
+			}
+			nor->stats.u32CoalescedOps++;
+		}while (1);
+		_nor_cs_deassert(nor);
+	}
+
+	return NOR_OK;
+}
+
+/*
+ * The functions required to access the bus, from the operations table when set.
+ */
+static uint8_t _nor_has_bus(nor_t *nor){
+	if (nor->config.pOps != NULL){
+		return (nor->config.pOps->CsAssert != NULL && nor->config.pOps->CsDeassert != NULL &&
+				nor->config.pOps->DelayUs != NULL && nor->config.pOps->SpiRx != NULL &&
+				nor->config.pOps->SpiTx != NULL);
+	}
+	return (nor->config.CsAssert != NULL && nor->config.CsDeassert != NULL &&
+			nor->config.DelayUs != NULL && nor->config.SpiRxFxn != NULL &&
+			nor->config.SpiTxFxn != NULL);
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_Init(nor_t *nor){
+	uint8_t ExitPDCmd = NOR_RELEASE_PD;
+
+	if (nor == NULL || !_nor_has_bus(nor)){
+		NOR_PRINTF("ERROR: Invalid Parameters on %s function\n\r", __func__);
+		return NOR_INVALID_PARAMS;
+	}
+	if (nor->_internal.u16Initialized == NOR_INITIALIZED_FLAG){
+		// the flash instance is already initialized
+		NOR_PRINTF("Warning: Flash is already initialized.\n\r");
+		return NOR_OK;
+	}
+	// we must have sure that the NOR has your CS pin deasserted
+	_nor_cs_deassert(nor);
+	_nor_delay_us(nor, 100);
+
+	// we are assuming, on startup, that the Flash is on Power Down State
+	nor->_internal.u8PdCount = 0;
+	nor->_internal.u8BusyPending = 0;
+	nor->_internal.u8Suspended = 0;
+	nor->_internal.u8Batch = 0;
+	nor->_internal.u8TimingOp = _NOR_TIMING_NONE;
+	nor->_internal.u8FailOp = _NOR_TIMING_NONE;
+	nor->_internal.u8FailErr = NOR_OK;
+	nor->_internal.u8Qpi = 0;
+	nor->_internal.u8ReadDummy = 1;
+	memset(&nor->stats, 0, sizeof(nor->stats));
+	memset(&nor->timing, 0, sizeof(nor->timing));
+	nor->pdState = NOR_IN_IDLE;
+	_nor_qpi_recover(nor);
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, &ExitPDCmd, sizeof(ExitPDCmd));
+	_nor_cs_deassert(nor);
+
+	nor->info.u32JedecID = _nor_ReadID(nor);
+	if (nor->info.u32JedecID == 0x000000 || nor->info.u32JedecID == 0xFFFFFF){
+		// invalid Id, I thing we don't has any flash on SPI
 		NOR_PRINTF("ERROR: Flash memory bus fault.\n\r");
 		return NOR_NO_MEMORY_FOUND;
 	}
@@ -273,9 +1460,11 @@ nor_err_e NOR_Init(nor_t *nor){
 	nor->info.u32PageCount = (nor->info.u32SectorCount * nor->info.u16SectorSize) / nor->info.u16PageSize;
 	nor->info.u32Size = (nor->info.u32SectorCount * nor->info.u16SectorSize);
 
-	_nor_ReadStatusRegister(nor, _SELECT_SR1);
-	_nor_ReadStatusRegister(nor, _SELECT_SR2);
-	_nor_ReadStatusRegister(nor, _SELECT_SR3);
+	_nor_ReadStatusAll(nor);
+	// an erase started before a reset of the MCU can be still running
+	if (nor->_internal.u8StatusReg1 & SR1_BUSY_BIT){
+		_nor_erase_pending(nor, 0, nor->info.u32Size, NOR_EXPECT_ERASE_CHIP);
+	}
 
 	nor->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
 	NOR_PRINTF("== Memory Flash NOR Information ==\n\r");
@@ -296,10 +1485,7 @@ nor_err_e NOR_Init(nor_t *nor){
 nor_err_e NOR_Init_wo_ID(nor_t *nor){
 	uint8_t ExitPDCmd = NOR_RELEASE_PD;
 
-	if (nor == NULL || nor->config.CsAssert == NULL ||
-			nor->config.CsDeassert == NULL || nor->config.DelayUs == NULL ||
-			nor->config.SpiRxFxn == NULL || nor->config.SpiTxFxn == NULL ||
-			nor->info.u32BlockCount == 0){
+	if (nor == NULL || !_nor_has_bus(nor) || nor->info.u32BlockCount == 0){
 		return NOR_INVALID_PARAMS;
 	}
 	if (nor->_internal.u16Initialized == NOR_INITIALIZED_FLAG){
@@ -312,13 +1498,25 @@ nor_err_e NOR_Init_wo_ID(nor_t *nor){
 
 	// we are assuming, on startup, that the Flash is on Power Down State
 	nor->_internal.u8PdCount = 0;
+	nor->_internal.u8BusyPending = 0;
+	nor->_internal.u8Suspended = 0;
+	nor->_internal.u8Batch = 0;
+	nor->_internal.u8TimingOp = _NOR_TIMING_NONE;
+	nor->_internal.u8FailOp = _NOR_TIMING_NONE;
+	nor->_internal.u8FailErr = NOR_OK;
+	nor->_internal.u8Qpi = 0;
+	nor->_internal.u8ReadDummy = 1;
+	memset(&nor->stats, 0, sizeof(nor->stats));
+	memset(&nor->timing, 0, sizeof(nor->timing));
 	nor->pdState = NOR_IN_IDLE;
+	_nor_qpi_recover(nor);
 	_nor_cs_assert(nor);
 	_nor_spi_tx(nor, &ExitPDCmd, sizeof(ExitPDCmd));
 	_nor_cs_deassert(nor);
 
 	nor->info.u32JedecID = _nor_ReadID(nor);
 	nor->info.u64UniqueId = _nor_ReadUniqID(nor);
+	nor->Manufacturer = NOR_IDS_Interpret_Manufacturer(nor->info.u32JedecID);
 
 	nor->info.u16PageSize = NOR_PAGE_SIZE;
 	nor->info.u16SectorSize = NOR_SECTOR_SIZE;
@@ -328,9 +1526,11 @@ nor_err_e NOR_Init_wo_ID(nor_t *nor){
 	nor->info.u32PageCount = (nor->info.u32SectorCount * nor->info.u16SectorSize) / nor->info.u16PageSize;
 	nor->info.u32Size = (nor->info.u32SectorCount * nor->info.u16SectorSize);
 
-	_nor_ReadStatusRegister(nor, _SELECT_SR1);
-	_nor_ReadStatusRegister(nor, _SELECT_SR2);
-	_nor_ReadStatusRegister(nor, _SELECT_SR3);
+	_nor_ReadStatusAll(nor);
+	// an erase started before a reset of the MCU can be still running
+	if (nor->_internal.u8StatusReg1 & SR1_BUSY_BIT){
+		_nor_erase_pending(nor, 0, nor->info.u32Size, NOR_EXPECT_ERASE_CHIP);
+	}
 
 	nor->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
 	NOR_PRINTF("== Memory Flash NOR Information ==\n\r");
@@ -376,6 +1576,8 @@ nor_err_e NOR_EnterPowerDown(nor_t *nor){
 	if (nor->_internal.u8PdCount == 0){
 		NOR_PRINTF("NOR Enter in Deep Power Down\n\r");
 		_nor_mtx_lock(nor);
+		// the device ignores the command while programming
+		_nor_LatchFail(nor, _nor_WaitPending(nor));
 		_nor_cs_assert(nor);
 		_nor_spi_tx(nor, &DeepPDCmd, sizeof(DeepPDCmd));
 		_nor_cs_deassert(nor);
@@ -396,10 +1598,17 @@ nor_err_e NOR_EraseChip(nor_t *nor){
 
 	NOR_PRINTF("Starting Mass Erase\nWait ...\n\r");
 	_nor_mtx_lock(nor);
+	if (_nor_LatchFail(nor, _nor_WaitPending(nor)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		NOR_PRINTF("ERROR: Failed to erase flash\n\r");
+		return NOR_FAIL;
+	}
 	_nor_WriteEnable(nor);
 	_nor_cs_assert(nor);
 	_nor_spi_tx(nor, &EraseChipCmd, sizeof(EraseChipCmd));
 	_nor_cs_deassert(nor);
+	_nor_erase_pending(nor, 0, nor->info.u32Size, NOR_EXPECT_ERASE_CHIP);
+	_nor_timing_start(nor, NOR_TIMING_ERASE_CHIP, 0);
 	err = _nor_WaitForBusy(nor, NOR_EXPECT_ERASE_CHIP, &remainingTime);
 	_nor_mtx_unlock(nor);
 	if (err != NOR_OK){
@@ -413,208 +1622,353 @@ nor_err_e NOR_EraseChip(nor_t *nor){
 }
 
 nor_err_e NOR_EraseAddress(nor_t *nor, uint32_t Address, nor_erase_method_e method){
-	uint8_t EraseChipCmd[4];
-	uint32_t expectedTimeoutMs, remaining;
+	_SANITY_CHECK(nor);
+
+	return _nor_EraseAddress(nor, Address, method, 0);
+}
+
+nor_err_e NOR_EraseAddressPosted(nor_t *nor, uint32_t Address, nor_erase_method_e method){
+	_SANITY_CHECK(nor);
+
+	return _nor_EraseAddress(nor, Address, method, 1);
+}
+
+nor_err_e NOR_EraseSector(nor_t *nor, uint32_t SectorAddr){
+	uint32_t Address;
+
+	_SANITY_CHECK(nor);
+
+	Address = SectorAddr * nor->info.u16SectorSize;
+	return NOR_EraseAddress(nor, Address, NOR_ERASE_4K);
+}
+
+nor_err_e NOR_EraseBlock(nor_t *nor, uint32_t BlockAddr){
+	uint32_t Address;
+
+	_SANITY_CHECK(nor);
+
+	Address = BlockAddr * nor->info.u32BlockSize;
+	return NOR_EraseAddress(nor, Address, NOR_ERASE_64K);
+}
+
+uint32_t NOR_PageToSector(nor_t *nor, uint32_t PageAddr){
+	_SANITY_CHECK(nor);
+	return PageAddr * nor->info.u16PageSize / nor->info.u16SectorSize;
+}
+
+uint32_t NOR_PageToBlock(nor_t *nor, uint32_t PageAddr){
+	_SANITY_CHECK(nor);
+	return PageAddr * nor->info.u16PageSize / nor->info.u32BlockSize;
+}
+
+uint32_t NOR_SectorToBlock(nor_t *nor, uint32_t SectorAddr){
+	_SANITY_CHECK(nor);
+	return  SectorAddr * nor->info.u16SectorSize / nor->info.u32BlockSize;
+}
+
+uint32_t NOR_SectorToPage(nor_t *nor, uint32_t SectorAddr){
+	_SANITY_CHECK(nor);
+	return SectorAddr * nor->info.u16SectorSize / nor->info.u16PageSize;
+}
+
+uint32_t NOR_BlockToPage(nor_t *nor, uint32_t BlockAddr){
+	_SANITY_CHECK(nor);
+	return  BlockAddr * nor->info.u32BlockSize / nor->info.u16PageSize;
+}
+
+nor_err_e NOR_IsEmptyAddress(nor_t *nor, uint32_t Address, uint32_t NumBytesToCheck){
+	uint8_t pBuffer[NOR_EMPTY_CHECK_BUFFER_LEN];
+	uint32_t Chunk;
 	nor_err_e err;
 
 	_SANITY_CHECK(nor);
 
-	switch (method){
-	case NOR_ERASE_4K:
-		NOR_PRINTF("Erasing 4 KBytes on 0x%08X Address... ", (uint)Address);
-		EraseChipCmd[0] = NOR_SECTOR_ERASE_4K;
-		expectedTimeoutMs = NOR_EXPECT_4K_ERASE_TIME;
-		break;
-	case NOR_ERASE_32K:
-		NOR_PRINTF("Erasing 32 KBytes on 0x%08X Address... ", (uint)Address);
-		EraseChipCmd[0] = NOR_SECTOR_ERASE_32K;
-		expectedTimeoutMs = NOR_EXPECT_32K_ERASE_TIME;
-		break;
-	case NOR_ERASE_64K:
-		NOR_PRINTF("Erasing 64 KBytes on 0x%08X Address... ", (uint)Address);
-		EraseChipCmd[0] = NOR_SECTOR_ERASE_64K;
-		expectedTimeoutMs = NOR_EXPECT_64K_ERASE_TIME;
-		break;
+	NOR_PRINTF("Checking if %d bytes of Address 0x%08X are empty.\n\r", (uint)NumBytesToCheck, (uint)Address);
+	while (NumBytesToCheck > 0){
+		// the last chunk is shorter, it may end on the end of the device
+		Chunk = (NumBytesToCheck > NOR_EMPTY_CHECK_BUFFER_LEN) ? NOR_EMPTY_CHECK_BUFFER_LEN : NumBytesToCheck;
+		err = NOR_ReadBytes(nor, pBuffer, Address, Chunk);
+		if (err != NOR_OK){
+			return err;
+		}
+		Address += Chunk;
+		NumBytesToCheck -= Chunk;
+		if (_nor_check_buff_is_empty(pBuffer, Chunk) == NOR_REGIONS_IS_NOT_EMPTY){
+			NOR_PRINTF("Warning: Region is NOT empty.\n\r");
+			return NOR_REGIONS_IS_NOT_EMPTY;
+		}
 	}
-	EraseChipCmd[1] = ((Address >> 16) & 0xFF);
-	EraseChipCmd[2] = ((Address >> 8) & 0xFF);
-	EraseChipCmd[3] = ((Address) & 0xFF);
+	NOR_PRINTF("Region is empty.\n\r");
+	return NOR_OK;
+}
+
+nor_err_e NOR_IsEmptyPage(nor_t *nor, uint32_t PageAddr, uint32_t Offset, uint32_t NumBytesToCheck){
+	uint32_t ActAddress;
+
+	_SANITY_CHECK(nor);
+
+	ActAddress = (nor->info.u16PageSize * PageAddr) + Offset;
+	return NOR_IsEmptyAddress(nor, ActAddress, NumBytesToCheck);
+}
+
+nor_err_e NOR_IsEmptySector(nor_t *nor, uint32_t SectorAddr, uint32_t Offset, uint32_t NumBytesToCheck){
+	uint32_t ActAddress;
+
+	_SANITY_CHECK(nor);
+
+	ActAddress = (nor->info.u16SectorSize * SectorAddr) + Offset;
+	return NOR_IsEmptyAddress(nor, ActAddress, NumBytesToCheck);
+}
+
+nor_err_e NOR_IsEmptyBlock(nor_t *nor, uint32_t BlockAddr, uint32_t Offset, uint32_t NumBytesToCheck){
+	uint32_t ActAddress;
+
+	_SANITY_CHECK(nor);
+
+	ActAddress = (nor->info.u32BlockSize * BlockAddr) + Offset;
+	return NOR_IsEmptyAddress(nor, ActAddress, NumBytesToCheck);
+}
+
+nor_err_e NOR_WriteBytes(nor_t *nor, uint8_t *pBuffer, uint32_t WriteAddr, uint32_t NumBytesToWrite){
+	_SANITY_CHECK(nor);
+
+	return _nor_WriteBytes(nor, pBuffer, WriteAddr, NumBytesToWrite, nor->config.PostedWrite);
+}
+
+nor_err_e NOR_WriteBytesPosted(nor_t *nor, uint8_t *pBuffer, uint32_t WriteAddr, uint32_t NumBytesToWrite){
+	_SANITY_CHECK(nor);
+
+	return _nor_WriteBytes(nor, pBuffer, WriteAddr, NumBytesToWrite, 1);
+}
+
+nor_err_e NOR_Sync(nor_t *nor){
+	nor_err_e err;
+
+	_SANITY_CHECK(nor);
 
 	_nor_mtx_lock(nor);
-	_nor_WriteEnable(nor);
-	_nor_cs_assert(nor);
-	_nor_spi_tx(nor, EraseChipCmd, sizeof(EraseChipCmd));
-	_nor_cs_deassert(nor);
-	err = _nor_WaitForBusy(nor, expectedTimeoutMs, &remaining);
-	_nor_delay_us(nor, 100000);
-	_nor_mtx_unlock(nor);
-	if (err != NOR_OK){
-		NOR_PRINTF("FAILED!\n\r");
+	err = _nor_LatchFail(nor, _nor_WaitPending(nor));
+	if (err == NOR_OK){
+		err = _nor_TakeFail(nor);
 	}
-	else{
-		NOR_PRINTF("OK in %d ms!\n\r", (int)(expectedTimeoutUs - remaining));
+	_nor_mtx_unlock(nor);
+	if (err == NOR_FAIL){
+		NOR_PRINTF("ERROR: Device still busy after the posted operation\n\r");
 	}
 
-
 	return err;
 }
 
-nor_err_e NOR_EraseSector(nor_t *nor, uint32_t SectorAddr){
-	uint32_t Address;
+nor_err_e NOR_IsBusy(nor_t *nor, uint8_t *pBusy){
+	nor_err_e err = NOR_OK;
 
 	_SANITY_CHECK(nor);
 
-	Address = SectorAddr * nor->info.u16SectorSize;
-	return NOR_EraseAddress(nor, Address, NOR_ERASE_4K);
-}
+	if (pBusy == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	*pBusy = 0;
+	_nor_mtx_lock(nor);
+	if (nor->_internal.u8BusyPending != 0){
+		if (_nor_ReadStatusRegister(nor, NOR_SR1) & SR1_BUSY_BIT){
+			*pBusy = 1;
+		}
+		else{
+			nor->_internal.u8BusyPending = 0;
+			_nor_timing_end(nor, 0);
+			_nor_LatchFail(nor, _nor_CheckFail(nor));
+		}
+	}
+	if (*pBusy == 0){
+		err = _nor_TakeFail(nor);
+	}
+	_nor_mtx_unlock(nor);
 
-nor_err_e NOR_EraseBlock(nor_t *nor, uint32_t BlockAddr){
-	uint32_t Address;
+	return err;
+}
 
+nor_err_e NOR_ReadStatusRegister(nor_t *nor, nor_sr_e SelectSR, uint8_t *pValue){
 	_SANITY_CHECK(nor);
 
-	Address = BlockAddr * nor->info.u32BlockSize;
-	return NOR_EraseAddress(nor, Address, NOR_ERASE_64K);
-}
+	if (pValue == NULL || SelectSR > NOR_SR3 || (SelectSR != NOR_SR1 && nor->Manufacturer == MANUF_MXIC)){
+		return NOR_INVALID_PARAMS;
+	}
+	_nor_mtx_lock(nor);
+	*pValue = _nor_ReadStatusRegister(nor, SelectSR);
+	_nor_mtx_unlock(nor);
 
-uint32_t NOR_PageToSector(nor_t *nor, uint32_t PageAddr){
-	_SANITY_CHECK(nor);
-	return PageAddr * nor->info.u16PageSize / nor->info.u16SectorSize;
+	return NOR_OK;
 }
 
-uint32_t NOR_PageToBlock(nor_t *nor, uint32_t PageAddr){
-	_SANITY_CHECK(nor);
-	return PageAddr * nor->info.u16PageSize / nor->info.u32BlockSize;
-}
+nor_err_e NOR_WriteStatusRegister(nor_t *nor, nor_sr_e SelectSR, uint8_t Mask, uint8_t Value){
+	uint8_t *pShadow, NewValue;
+	nor_err_e err;
 
-uint32_t NOR_SectorToBlock(nor_t *nor, uint32_t SectorAddr){
 	_SANITY_CHECK(nor);
-	return  SectorAddr * nor->info.u16SectorSize / nor->info.u32BlockSize;
-}
 
-uint32_t NOR_SectorToPage(nor_t *nor, uint32_t SectorAddr){
-	_SANITY_CHECK(nor);
-	return SectorAddr * nor->info.u16SectorSize / nor->info.u16PageSize;
-}
+	if (SelectSR != NOR_SR1 && nor->Manufacturer == MANUF_MXIC){
+		return NOR_INVALID_PARAMS;
+	}
+	switch (SelectSR){
+	case NOR_SR1:
+		pShadow = &nor->_internal.u8StatusReg1;
+		// the volatile bits can't be written
+		Mask &= ~(SR1_BUSY_BIT | SR1_WEL_BIT);
+		break;
+	case NOR_SR2:
+		pShadow = &nor->_internal.u8StatusReg2;
+		break;
+	case NOR_SR3:
+		pShadow = &nor->_internal.u8StatusReg3;
+		break;
+	default:
+		return NOR_INVALID_PARAMS;
+	}
+	_nor_mtx_lock(nor);
+	NewValue = (*pShadow & ~Mask) | (Value & Mask);
+	if (NewValue == *pShadow){
+		// the write enable, the write and the busy poll
+		nor->stats.u32SkippedStatusWrites++;
+		_nor_mtx_unlock(nor);
+		return NOR_OK;
+	}
+	if (_nor_LatchFail(nor, _nor_WaitPending(nor)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		return NOR_FAIL;
+	}
+	_nor_WriteEnable(nor);
+	_nor_WriteStatusRegister(nor, SelectSR, (SelectSR == NOR_SR1) ? (NewValue & ~(SR1_BUSY_BIT | SR1_WEL_BIT)) : NewValue);
+	nor->_internal.u8BusyPending = _NOR_PENDING_PROGRAM;
+	err = _nor_WaitForBusy(nor, NOR_EXPECT_WRITE_SR_TIME, NULL);
+	// read back, the write is ignored when the registers are protected
+	if (err == NOR_OK && ((_nor_ReadStatusRegister(nor, SelectSR) ^ NewValue) & Mask) != 0){
+		err = NOR_IS_LOCKED;
+	}
+	_nor_mtx_unlock(nor);
 
-uint32_t NOR_BlockToPage(nor_t *nor, uint32_t BlockAddr){
-	_SANITY_CHECK(nor);
-	return  BlockAddr * nor->info.u32BlockSize / nor->info.u16PageSize;
+	return err;
 }
 
-nor_err_e NOR_IsEmptyAddress(nor_t *nor, uint32_t Address, uint32_t NumBytesToCheck){
-	uint8_t pBuffer[NOR_EMPTY_CHECK_BUFFER_LEN];
+nor_err_e NOR_EnterQPI(nor_t *nor){
+	uint8_t EnterCmd, Dummy;
+	nor_err_e err;
 
 	_SANITY_CHECK(nor);
 
-	NOR_PRINTF("Checking if %d bytes of Address 0x%08X are empty.\n\r", (uint)NumBytesToCheck, (uint)Address);
-	while (NumBytesToCheck > 0){
-		NOR_ReadBytes(nor, pBuffer, Address, NOR_EMPTY_CHECK_BUFFER_LEN);
-		Address += NOR_EMPTY_CHECK_BUFFER_LEN;
-		if (NumBytesToCheck >= NOR_EMPTY_CHECK_BUFFER_LEN){
-			NumBytesToCheck -= NOR_EMPTY_CHECK_BUFFER_LEN;
-		}
-		else{
-			NumBytesToCheck = 0;
-		}
-		if (_nor_check_buff_is_empty(pBuffer, NOR_EMPTY_CHECK_BUFFER_LEN) == NOR_REGIONS_IS_NOT_EMPTY){
-			NOR_PRINTF("Warning: Region is NOT empty.\n\r");
-			return NOR_REGIONS_IS_NOT_EMPTY;
+	if (!_NOR_HAS_FXN(nor, BusWidth, BusWidthFxn)){
+		return NOR_INVALID_PARAMS;
+	}
+	if (nor->_internal.u8Qpi){
+		return NOR_OK;
+	}
+	switch (nor->Manufacturer){
+	case MANUF_WINBOND:
+		// the QPI mode is accepted only with the Quad Enable bit set
+		err = NOR_WriteStatusRegister(nor, NOR_SR2, SR2_QE_BIT, SR2_QE_BIT);
+		if (err != NOR_OK){
+			return err;
 		}
+		EnterCmd = NOR_ENTER_QPI_WINBOND;
+		Dummy = NOR_QPI_DUMMY_WINBOND;
+		break;
+	case MANUF_MXIC:
+		EnterCmd = NOR_ENTER_QPI_MXIC;
+		Dummy = NOR_QPI_DUMMY_MXIC;
+		break;
+	default:
+		return NOR_UNKNOWN_DEVICE;
 	}
-	NOR_PRINTF("Region is empty.\n\r");
+	_nor_mtx_lock(nor);
+	if (_nor_LatchFail(nor, _nor_WaitPending(nor)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		return NOR_FAIL;
+	}
+	_nor_send_cmd(nor, EnterCmd);
+	_nor_set_width(nor, 4);
+	nor->_internal.u8Qpi = 1;
+	// each byte takes 2 clocks on 4 lines
+	nor->_internal.u8ReadDummy = Dummy / 2;
+	_nor_mtx_unlock(nor);
+	NOR_PRINTF("NOR on QPI mode\n\r");
+
 	return NOR_OK;
 }
 
-nor_err_e NOR_IsEmptyPage(nor_t *nor, uint32_t PageAddr, uint32_t Offset, uint32_t NumBytesToCheck){
-	uint32_t ActAddress;
-
+nor_err_e NOR_ExitQPI(nor_t *nor){
 	_SANITY_CHECK(nor);
 
-	ActAddress = (nor->info.u16PageSize * PageAddr) + Offset;
-	return NOR_IsEmptyAddress(nor, ActAddress, NumBytesToCheck);
-}
-
-nor_err_e NOR_IsEmptySector(nor_t *nor, uint32_t SectorAddr, uint32_t Offset, uint32_t NumBytesToCheck){
-	uint32_t ActAddress;
-
-	_SANITY_CHECK(nor);
+	if (nor->_internal.u8Qpi == 0){
+		return NOR_OK;
+	}
+	_nor_mtx_lock(nor);
+	if (_nor_LatchFail(nor, _nor_WaitPending(nor)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		return NOR_FAIL;
+	}
+	_nor_send_cmd(nor, (nor->Manufacturer == MANUF_MXIC) ? NOR_EXIT_QPI_MXIC : NOR_EXIT_QPI_WINBOND);
+	_nor_set_width(nor, 1);
+	nor->_internal.u8Qpi = 0;
+	nor->_internal.u8ReadDummy = 1;
+	_nor_mtx_unlock(nor);
+	NOR_PRINTF("NOR on SPI mode\n\r");
 
-	ActAddress = (nor->info.u16SectorSize * SectorAddr) + Offset;
-	return NOR_IsEmptyAddress(nor, ActAddress, NumBytesToCheck);
+	return NOR_OK;
 }
 
-nor_err_e NOR_IsEmptyBlock(nor_t *nor, uint32_t BlockAddr, uint32_t Offset, uint32_t NumBytesToCheck){
-	uint32_t ActAddress;
+nor_err_e NOR_Reset(nor_t *nor){
+	nor_err_e err = NOR_OK;
 
 	_SANITY_CHECK(nor);
 
-	ActAddress = (nor->info.u32BlockSize * BlockAddr) + Offset;
-	return NOR_IsEmptyAddress(nor, ActAddress, NumBytesToCheck);
-}
+	_nor_mtx_lock(nor);
+	// on 4 lines first, the device on SPI mode ignores these commands
+	if (_NOR_HAS_FXN(nor, BusWidth, BusWidthFxn)){
+		_nor_set_width(nor, 4);
+		_nor_reset_cmds(nor);
+		_nor_set_width(nor, 1);
+	}
+	_nor_reset_cmds(nor);
+	nor->_internal.u8Qpi = 0;
+	nor->_internal.u8ReadDummy = 1;
+	nor->_internal.u8BusyPending = 0;
+	nor->_internal.u8Suspended = 0;
+	nor->_internal.u8TimingOp = _NOR_TIMING_NONE;
+	nor->_internal.u8FailOp = _NOR_TIMING_NONE;
+	nor->_internal.u8PdCount = 0;
+	nor->pdState = NOR_IN_IDLE;
+	_nor_ReadStatusAll(nor);
+	if (nor->_internal.u8StatusReg1 & SR1_BUSY_BIT){
+		err = NOR_FAIL;
+	}
+	_nor_mtx_unlock(nor);
+	NOR_PRINTF("NOR reset %s\n\r", (err == NOR_OK) ? "done" : "FAILED");
 
-nor_err_e NOR_WriteBytes(nor_t *nor, uint8_t *pBuffer, uint32_t WriteAddr, uint32_t NumBytesToWrite){
-	uint8_t WriteCmd[4];
-	uint32_t _BytesToWrite;
+	return err;
+}
 
+nor_err_e NOR_Crc32Range(nor_t *nor, uint32_t Address, uint32_t NumBytes, uint32_t *pCrc){
 	_SANITY_CHECK(nor);
 
-	if (NumBytesToWrite == 0){
-		NOR_PRINTF("ERROR: Invalid parameters on NOR_WriteBytes\n\r");
+	if (pCrc == NULL || NumBytes == 0){
 		return NOR_INVALID_PARAMS;
 	}
-	// TODO check if Address is not grater than the Flash size
-	NOR_PRINTF("Writing %d bytes into Address %08X.\n\r", (uint)NumBytesToWrite, (uint)WriteAddr);
-	NOR_PRINTF("Buffer to Write into Flash:\n\r");
-	NOR_PRINTF("====================== Values in HEX ========================");
-	for (uint32_t i = 0; i < NumBytesToWrite; i++)
-	{
-		if (i % 16 == 0)
-		{
-			NOR_PRINTF("\r\n");
-			NOR_PRINTF("0x%08X | ", (uint)(WriteAddr + i));
-		}
-		NOR_PRINTF("%02X ", pBuffer[i]);
+	if (Address >= nor->info.u32Size || NumBytes > (nor->info.u32Size - Address)){
+		return NOR_OUT_OF_RANGE;
 	}
-	NOR_PRINTF("\n\r=============================================================\n\r");
+	NOR_PRINTF("Calculating the CRC32 of %d bytes on the Address %08X.\n\r", (uint)NumBytes, (uint)Address);
+	*pCrc = 0;
 	_nor_mtx_lock(nor);
-	do{
-		// Wait for Busy is deasserted to write any information
-		if (_nor_WaitForBusy(nor, NOR_EXPECT_PAGE_PROG_TIME, NULL) != NOR_OK){
-			NOR_PRINTF("Write failed.!\n\r\n\r");
-			return NOR_FAIL;
-		}
-		if (((WriteAddr%nor->info.u16PageSize)+NumBytesToWrite) > nor->info.u16PageSize){
-			_BytesToWrite = nor->info.u16PageSize - (WriteAddr%nor->info.u16PageSize);
-		}
-		else{
-			_BytesToWrite = NumBytesToWrite;
-		}
-		_nor_WriteEnable(nor);
-		WriteCmd[0] = NOR_PAGE_PROGRAM;
-		WriteCmd[1] = ((WriteAddr >> 16) & 0xFF);
-		WriteCmd[2] = ((WriteAddr >> 8) & 0xFF);
-		WriteCmd[3] = ((WriteAddr) & 0xFF);
-		_nor_cs_assert(nor);
-		_nor_spi_tx(nor, WriteCmd, sizeof(WriteCmd));
-		_nor_spi_tx(nor, pBuffer, _BytesToWrite);
-		_nor_cs_deassert(nor);
-		pBuffer += _BytesToWrite;
-		WriteAddr += _BytesToWrite;
-		NumBytesToWrite -= _BytesToWrite;
-	}while (NumBytesToWrite > 0);
-	// release the routine only when the data is writted
-	if (_nor_WaitForBusy(nor, NOR_EXPECT_PAGE_PROG_TIME, NULL) != NOR_OK){
-		NOR_PRINTF("Write failed.!\n\r\n\r");
+	if (_nor_LatchFail(nor, _nor_SuspendPending(nor, Address, NumBytes)) != NOR_OK){
+		_nor_mtx_unlock(nor);
 		return NOR_FAIL;
 	}
+	_nor_ReadCrc(nor, Address, NumBytes, pCrc);
+	_nor_ResumePending(nor);
 	_nor_mtx_unlock(nor);
-	NOR_PRINTF("Write done.!\n\r\n\r");
 
 	return NOR_OK;
 }
 
-
 nor_err_e NOR_WritePage(nor_t *nor, uint8_t *pBuffer, uint32_t PageAddr, uint32_t Offset, uint32_t NumBytesToWrite){
 	uint32_t Address;
 
@@ -657,28 +2011,300 @@ nor_err_e NOR_WriteBlock(nor_t *nor, uint8_t *pBuffer, uint32_t BlockAddr, uint3
 	return NOR_WriteBytes(nor, pBuffer, Address, NumBytesToWrite);
 }
 
+nor_err_e NOR_CopyRange(nor_t *nor, uint32_t DstAddr, uint32_t SrcAddr, uint32_t NumBytes){
+	return NOR_CopyRangeEx(nor, DstAddr, nor, SrcAddr, NumBytes);
+}
+
+nor_err_e NOR_CopyRangeEx(nor_t *dst, uint32_t DstAddr, nor_t *src, uint32_t SrcAddr, uint32_t NumBytes){
+	uint8_t pBuffer[NOR_PAGE_SIZE], pCmp[NOR_COPY_CMP_BUFFER_LEN];
+	uint32_t SectorStart, SectorEnd, Start, End, Address, Chunk, Offset, Cmp, DirtyPages, Page, i;
+	uint8_t NeedErase, Programmed = 0;
+	nor_err_e err;
+
+	_SANITY_CHECK(dst);
+	_SANITY_CHECK(src);
+
+	if (NumBytes == 0 || dst->info.u16PageSize != NOR_PAGE_SIZE || dst->info.u16SectorSize != NOR_SECTOR_SIZE){
+		return NOR_INVALID_PARAMS;
+	}
+	if (DstAddr >= dst->info.u32Size || NumBytes > (dst->info.u32Size - DstAddr) ||
+			SrcAddr >= src->info.u32Size || NumBytes > (src->info.u32Size - SrcAddr)){
+		return NOR_OUT_OF_RANGE;
+	}
+	if (dst == src && DstAddr < (SrcAddr + NumBytes) && SrcAddr < (DstAddr + NumBytes)){
+		NOR_PRINTF("ERROR: Overlapped regions on %s\n\r", __func__);
+		return NOR_INVALID_PARAMS;
+	}
+	NOR_PRINTF("Copying %d bytes from 0x%08X to 0x%08X.\n\r", (uint)NumBytes, (uint)SrcAddr, (uint)DstAddr);
+	Start = DstAddr;
+	End = DstAddr + NumBytes;
+	while (Start < End){
+		SectorStart = Start - (Start % NOR_SECTOR_SIZE);
+		SectorEnd = SectorStart + NOR_SECTOR_SIZE;
+		if (SectorEnd > End){
+			SectorEnd = End;
+		}
+		/*
+		 * First pass, compare the destination with the source, page by page, to
+		 * find the pages that changed, and if any of them needs the erase.
+		 */
+		DirtyPages = 0;
+		NeedErase = 0;
+		for (Address=Start ; Address<SectorEnd && NeedErase == 0 ; Address+=Chunk){
+			Chunk = NOR_PAGE_SIZE - (Address % NOR_PAGE_SIZE);
+			if (Chunk > (SectorEnd - Address)){
+				Chunk = SectorEnd - Address;
+			}
+			err = NOR_ReadBytes(src, pBuffer, SrcAddr + (Address - DstAddr), Chunk);
+			for (Offset=0 ; Offset<Chunk && NeedErase == 0 && err == NOR_OK ; Offset+=Cmp){
+				Cmp = Chunk - Offset;
+				if (Cmp > NOR_COPY_CMP_BUFFER_LEN){
+					Cmp = NOR_COPY_CMP_BUFFER_LEN;
+				}
+				err = NOR_ReadBytes(dst, pCmp, Address + Offset, Cmp);
+				for (i=0 ; i<Cmp && err == NOR_OK ; i++){
+					if (pBuffer[Offset + i] != pCmp[i]){
+						DirtyPages |= (1UL << ((Address % NOR_SECTOR_SIZE) / NOR_PAGE_SIZE));
+						if ((pBuffer[Offset + i] & pCmp[i]) != pBuffer[Offset + i]){
+							NeedErase = 1;
+							break;
+						}
+					}
+				}
+			}
+			if (err != NOR_OK){
+				return err;
+			}
+		}
+		if (NeedErase){
+			// we can't erase data outside the range
+			if (Start != SectorStart || (SectorEnd - SectorStart) != NOR_SECTOR_SIZE){
+				NOR_PRINTF("ERROR: Destination sector 0x%08X must be erased\n\r", (uint)SectorStart);
+				return NOR_REGIONS_IS_NOT_EMPTY;
+			}
+			err = NOR_EraseAddress(dst, SectorStart, NOR_ERASE_4K);
+			if (err != NOR_OK){
+				return err;
+			}
+			DirtyPages = (1UL << _NOR_PAGES_PER_SECTOR) - 1;
+		}
+		/*
+		 * Second pass, program only the changed pages. The program is posted, so
+		 * the next source read runs while the destination is busy, when they are
+		 * different devices.
+		 */
+		for (Address=Start ; Address<SectorEnd ; Address+=Chunk){
+			Chunk = NOR_PAGE_SIZE - (Address % NOR_PAGE_SIZE);
+			if (Chunk > (SectorEnd - Address)){
+				Chunk = SectorEnd - Address;
+			}
+			Page = (Address % NOR_SECTOR_SIZE) / NOR_PAGE_SIZE;
+			if ((DirtyPages & (1UL << Page)) == 0){
+				continue;
+			}
+			err = NOR_ReadBytes(src, pBuffer, SrcAddr + (Address - DstAddr), Chunk);
+			if (err != NOR_OK){
+				return err;
+			}
+			if (NeedErase && _nor_check_buff_is_empty(pBuffer, Chunk) == NOR_OK){
+				continue;
+			}
+			err = _nor_WriteBytes(dst, pBuffer, Address, Chunk, 1);
+			if (err != NOR_OK){
+				return err;
+			}
+			Programmed = 1;
+		}
+		Start = SectorEnd;
+	}
+	if (dst->config.PostedWrite == 0 && Programmed){
+		/*
+		 * Wait the last program of the copy like a synchronous write, with the
+		 * lock held, so a failure latched by an older posted call stays for
+		 * NOR_Sync.
+		 */
+		_nor_mtx_lock(dst);
+		dst->_internal.u8Posted = 0;
+		err = _nor_WaitPending(dst);
+		_nor_mtx_unlock(dst);
+		if (err != NOR_OK){
+			return (err == NOR_PROGRAM_FAILED) ? err : NOR_FAIL;
+		}
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_MultiExecute(nor_op_t *pOps, uint32_t Count){
+	nor_op_t *op;
+	nor_t *DelayNor;
+	uint32_t i, j, Active, Completed;
+	nor_err_e err = NOR_OK;
+
+	if (pOps == NULL || Count == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	for (i=0 ; i<Count ; i++){
+		memset(&pOps[i]._internal, 0, sizeof(pOps[i]._internal));
+		pOps[i].Result = _nor_op_check(&pOps[i]);
+		if (pOps[i].Result != NOR_OK){
+			pOps[i]._internal.u8Done = 1;
+			err = NOR_FAIL;
+		}
+	}
+	do{
+		Active = 0;
+		Completed = 0;
+		DelayNor = NULL;
+		for (i=0 ; i<Count ; i++){
+			op = &pOps[i];
+			if (op->_internal.u8Done){
+				continue;
+			}
+			Active++;
+			if (op->_internal.u8InFlight == 0){
+				// the previous operations on the same device go first
+				for (j=0 ; j<i && (pOps[j]._internal.u8Done || pOps[j].nor != op->nor) ; j++);
+				if (j < i){
+					continue;
+				}
+				op->Result = _nor_op_issue(op);
+				if (op->Result != NOR_OK){
+					op->_internal.u8Done = 1;
+					err = NOR_FAIL;
+				}
+				continue;
+			}
+			if (_nor_op_is_busy(op) == 0){
+				op->_internal.u8InFlight = 0;
+				op->_internal.u32Offset += op->_internal.u32Issued;
+				if (op->Type != NOR_OP_PROGRAM || op->_internal.u32Offset >= op->Len || op->Result != NOR_OK){
+					op->_internal.u8Done = 1;
+				}
+				if (op->Result != NOR_OK){
+					err = NOR_FAIL;
+				}
+				Completed++;
+			}
+			else if (_nor_op_waited_us(op) >= _nor_op_timeout_us(op)){
+				NOR_PRINTF("ERROR: Timeout on the operation %d\n\r", (int)i);
+				op->Result = NOR_FAIL;
+				op->_internal.u8Done = 1;
+				err = NOR_FAIL;
+			}
+			else{
+				DelayNor = op->nor;
+			}
+		}
+		// all devices are still busy, wait before the next round. Without a
+		// timer, the delay is done on every round, it's the time counted
+		if (DelayNor != NULL && (Completed == 0 || !_NOR_HAS_FXN(DelayNor, TimeUs, TimeUsFxn))){
+			_nor_delay_us(DelayNor, NOR_MULTI_POLL_US);
+			for (i=0 ; i<Count ; i++){
+				if (pOps[i]._internal.u8InFlight && !_NOR_HAS_FXN(pOps[i].nor, TimeUs, TimeUsFxn)){
+					pOps[i]._internal.u32WaitedUs += NOR_MULTI_POLL_US;
+				}
+			}
+		}
+	}while (Active > 0);
+
+	return err;
+}
+
+nor_err_e NOR_BatchExecute(nor_t *nor, nor_op_t *pOps, uint32_t Count){
+	uint32_t i, j;
+	nor_err_e err = NOR_OK, RunErr;
+
+	_SANITY_CHECK(nor);
+
+	if (pOps == NULL || Count == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	for (i=0 ; i<Count ; i++){
+		memset(&pOps[i]._internal, 0, sizeof(pOps[i]._internal));
+		pOps[i].Result = _nor_batch_check(nor, &pOps[i]);
+		if (pOps[i].Result != NOR_OK){
+			pOps[i]._internal.u8Done = 1;
+			err = NOR_FAIL;
+		}
+	}
+	_nor_mtx_lock(nor);
+	nor->_internal.u8Batch = 1;
+	// a failure of the posted operation before the batch isn't of its operations
+	RunErr = _nor_LatchFail(nor, _nor_WaitPending(nor));
+	for (i=0 ; i<Count && RunErr != NOR_FAIL ; i=j){
+		// a run of operations of the same kind, reordered and merged inside it
+		for (j=i+1 ; j<Count && _nor_batch_kind(&pOps[j]) == _nor_batch_kind(&pOps[i]) ; j++);
+		switch (_nor_batch_kind(&pOps[i])){
+		case NOR_OP_ERASE:
+			RunErr = _nor_batch_erase(nor, &pOps[i], j - i, pOps, Count);
+			break;
+		case NOR_OP_PROGRAM:
+			RunErr = _nor_batch_program(nor, &pOps[i], j - i, pOps, Count);
+			break;
+		default:
+			RunErr = _nor_batch_read(nor, &pOps[i], j - i, pOps, Count);
+			break;
+		}
+		if (RunErr == NOR_FAIL){
+			break;
+		}
+		if (RunErr != NOR_OK){
+			err = NOR_FAIL;
+		}
+	}
+	// the last program or erase
+	if (i >= Count && nor->_internal.u8BusyPending && _nor_batch_wait(nor, pOps, Count) != NOR_OK){
+		RunErr = NOR_FAIL;
+	}
+	nor->_internal.u8Batch = 0;
+	_nor_mtx_unlock(nor);
+	// the failures reported by the device, given to the operations
+	for (i=0 ; i<Count ; i++){
+		if (pOps[i].Result != NOR_OK){
+			err = NOR_FAIL;
+		}
+	}
+	if (RunErr == NOR_FAIL){
+		NOR_PRINTF("ERROR: Batch failed\n\r");
+		for (i=0 ; i<Count ; i++){
+			if (pOps[i]._internal.u8Done == 0){
+				pOps[i].Result = NOR_FAIL;
+			}
+		}
+		err = NOR_FAIL;
+	}
+
+	return err;
+}
+
 nor_err_e NOR_ReadBytes(nor_t *nor, uint8_t *pBuffer, uint32_t ReadAddr, uint32_t NumByteToRead){
-	uint8_t ReadCmd[5];
-	uint32_t Readed, toRead;
+	uint8_t ReadCmd[_NOR_READ_CMD_MAX];
+	uint32_t Readed, toRead, CmdLen;
 
 	_SANITY_CHECK(nor);
 
 	if (NumByteToRead == 0){
 		return NOR_INVALID_PARAMS;
 	}
-	// TODO check if Address is not grater than the Flash size
+	if (ReadAddr >= nor->info.u32Size || NumByteToRead > (nor->info.u32Size - ReadAddr)){
+		return NOR_OUT_OF_RANGE;
+	}
 
 	NOR_PRINTF("Reading %d bytes on the Address %08X.\n\r", (uint)NumByteToRead, (uint)ReadAddr);
 
 	_nor_mtx_lock(nor);
-	_nor_WaitForBusy(nor, NOR_EXPECT_PAGE_PROG_TIME, NULL);
-	ReadCmd[0] = NOR_READ_FAST_DATA;
-	ReadCmd[1] = ((ReadAddr >> 16) & 0xFF);
-	ReadCmd[2] = ((ReadAddr >> 8) & 0xFF);
-	ReadCmd[3] = ((ReadAddr) & 0xFF);
-	ReadCmd[4] = 0x00;
+	// the state tells when the device is idle, without poll it
+	if (nor->_internal.u8BusyPending == 0){
+		nor->stats.u32SkippedPolls++;
+	}
+	if (_nor_LatchFail(nor, _nor_SuspendPending(nor, ReadAddr, NumByteToRead)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		return NOR_FAIL;
+	}
+	CmdLen = _nor_read_cmd(nor, ReadCmd, ReadAddr);
 	_nor_cs_assert(nor);
-	_nor_spi_tx(nor, ReadCmd, sizeof(ReadCmd));
+	_nor_spi_tx(nor, ReadCmd, CmdLen);
 	_nor_spi_rx(nor, pBuffer, NumByteToRead);
 //	Readed = 0;
 //	while (Readed < NumByteToRead){
@@ -693,6 +2319,7 @@ nor_err_e NOR_ReadBytes(nor_t *nor, uint8_t *pBuffer, uint32_t ReadAddr, uint32_
 //	}
 	_nor_cs_deassert(nor);
 
+	_nor_ResumePending(nor);
 	_nor_mtx_unlock(nor);
 	NOR_PRINTF("Buffer readed from NOR:\n\r");
 	NOR_PRINTF("====================== Values in HEX ========================");
@@ -711,6 +2338,46 @@ nor_err_e NOR_ReadBytes(nor_t *nor, uint8_t *pBuffer, uint32_t ReadAddr, uint32_
 	return NOR_OK;
 }
 
+nor_err_e NOR_ReadStream(nor_t *nor, uint32_t Address, uint32_t NumBytes, stream_sink_fxn_t SinkFxn, void *Ctx){
+	uint8_t pBuffer[NOR_STREAM_BUFFER_LEN];
+	uint8_t ReadCmd[_NOR_READ_CMD_MAX], Continue = 1;
+	uint32_t Chunk, CmdLen;
+
+	_SANITY_CHECK(nor);
+
+	if (SinkFxn == NULL || NumBytes == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Address >= nor->info.u32Size || NumBytes > (nor->info.u32Size - Address)){
+		return NOR_OUT_OF_RANGE;
+	}
+	NOR_PRINTF("Streaming %d bytes from the Address %08X.\n\r", (uint)NumBytes, (uint)Address);
+	_nor_mtx_lock(nor);
+	if (_nor_LatchFail(nor, _nor_SuspendPending(nor, Address, NumBytes)) != NOR_OK){
+		_nor_mtx_unlock(nor);
+		return NOR_FAIL;
+	}
+	CmdLen = _nor_read_cmd(nor, ReadCmd, Address);
+	_nor_cs_assert(nor);
+	_nor_spi_tx(nor, ReadCmd, CmdLen);
+	// the device keeps streaming while CS is asserted
+	while (NumBytes > 0 && Continue){
+		Chunk = (NumBytes > NOR_STREAM_BUFFER_LEN) ? NOR_STREAM_BUFFER_LEN : NumBytes;
+		_nor_spi_rx(nor, pBuffer, Chunk);
+		Continue = SinkFxn(Ctx, pBuffer, Chunk);
+		NumBytes -= Chunk;
+	}
+	_nor_cs_deassert(nor);
+	_nor_ResumePending(nor);
+	_nor_mtx_unlock(nor);
+	if (Continue == 0){
+		NOR_PRINTF("Stream stopped by the sink, %d bytes left\n\r", (uint)NumBytes);
+		return NOR_FAIL;
+	}
+
+	return NOR_OK;
+}
+
 nor_err_e NOR_ReadPage(nor_t *nor, uint8_t *pBuffer, uint32_t PageAddr, uint32_t Offset, uint32_t NumByteToRead){
 	uint32_t Address;
 
@@ -753,3 +2420,52 @@ nor_err_e NOR_ReadBlock(nor_t *nor, uint8_t *pBuffer, uint32_t BlockAddr, uint32
 	return NOR_ReadBytes(nor, pBuffer, Address, NumByteToRead);
 }
 
+#if defined (NOR_TRACE)
+nor_err_e NOR_TRACE_Start(nor_t *nor, nor_trace_rec_t *pRing, uint32_t Size, trace_time_fxn_t TimeFxn){
+	if (nor == NULL || pRing == NULL || Size == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	_nor_mtx_lock(nor);
+	nor->trace.TimeFxn = TimeFxn;
+	nor->trace.u32Size = Size;
+	nor->trace.u32Head = 0;
+	nor->trace.u32Count = 0;
+	nor->trace.u32Dropped = 0;
+	nor->trace.u32BusyUs = 0;
+	nor->trace.pRing = pRing;
+	nor->trace.u8Enabled = 1;
+	_nor_mtx_unlock(nor);
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_TRACE_Stop(nor_t *nor){
+	if (nor == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	_nor_mtx_lock(nor);
+	// the records are kept, only the recording stops
+	nor->trace.u8Enabled = 0;
+	_nor_mtx_unlock(nor);
+
+	return NOR_OK;
+}
+
+uint32_t NOR_TRACE_Read(nor_t *nor, nor_trace_rec_t *pRecords, uint32_t MaxRecords){
+	uint32_t Tail, i;
+
+	if (nor == NULL || pRecords == NULL || nor->trace.u32Size == 0){
+		return 0;
+	}
+	if (MaxRecords > nor->trace.u32Count){
+		MaxRecords = nor->trace.u32Count;
+	}
+	Tail = (nor->trace.u32Head + nor->trace.u32Size - nor->trace.u32Count) % nor->trace.u32Size;
+	for (i=0 ; i<MaxRecords ; i++){
+		pRecords[i] = nor->trace.pRing[(Tail + i) % nor->trace.u32Size];
+	}
+	nor->trace.u32Count -= MaxRecords;
+
+	return MaxRecords;
+}
+#endif
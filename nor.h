@@ -31,6 +31,9 @@
 // Flag to tell to the library "Hey, I'm initialized"
 #define NOR_INITIALIZED_FLAG		0xCFFE
 
+// Unit of config.pSectorEraseTime
+#define NOR_TIMING_SECTOR_UNIT_US	100
+
 
 
 
@@ -61,6 +64,10 @@ typedef enum{
 	NOR_NOT_INITIALIZED,     /**< NOR_NOT_INITIALIZED */
 	NOR_REGIONS_IS_NOT_EMPTY,/**< NOR_REGIONS_IS_NOT_EMPTY */
 	NOR_IS_LOCKED,           /**< NOR_IS_LOCKED */
+	NOR_VERIFY_FAILED,       /**< NOR_VERIFY_FAILED */
+	NOR_ECC_UNCORRECTABLE,   /**< NOR_ECC_UNCORRECTABLE */
+	NOR_PROGRAM_FAILED,      /**< NOR_PROGRAM_FAILED, reported by the device */
+	NOR_ERASE_FAILED,        /**< NOR_ERASE_FAILED, reported by the device */
 
 	NOR_UNKNOWN = 0xFF       /**< NOR_UNKNOWN */
 }nor_err_e;
@@ -75,6 +82,50 @@ typedef enum{
 	NOR_ERASE_64K /**< NOR_ERASE_64K */
 }nor_erase_method_e;
 
+/**
+ * @brief Lock modes requested to the context-carrying lock
+ *
+ */
+typedef enum{
+	NOR_LOCK_SHARED,   /**< NOR_LOCK_SHARED, readers of RAM state */
+	NOR_LOCK_EXCLUSIVE /**< NOR_LOCK_EXCLUSIVE, bus transactions and state changes */
+}nor_lock_e;
+
+/**
+ * @brief Operations of NOR_MultiExecute and NOR_BatchExecute
+ *
+ */
+typedef enum{
+	NOR_OP_ERASE,     /**< NOR_OP_ERASE, Address and Method */
+	NOR_OP_ERASE_CHIP,/**< NOR_OP_ERASE_CHIP */
+	NOR_OP_PROGRAM,   /**< NOR_OP_PROGRAM, Address, pBuffer and Len */
+	NOR_OP_READ       /**< NOR_OP_READ, Address, pBuffer and Len, only on NOR_BatchExecute */
+}nor_op_type_e;
+
+/**
+ * @brief Status registers, for NOR_ReadStatusRegister and NOR_WriteStatusRegister
+ *
+ */
+typedef enum{
+	NOR_SR1,/**< NOR_SR1, BUSY, WEL and the block protection bits */
+	NOR_SR2,/**< NOR_SR2, the Quad Enable bit, on Winbond devices */
+	NOR_SR3 /**< NOR_SR3 */
+}nor_sr_e;
+
+/**
+ * @brief Operations with the duration learned, index of the timing arrays
+ *
+ */
+typedef enum{
+	NOR_TIMING_PROGRAM,   /**< NOR_TIMING_PROGRAM, Page Program */
+	NOR_TIMING_ERASE_4K,  /**< NOR_TIMING_ERASE_4K */
+	NOR_TIMING_ERASE_32K, /**< NOR_TIMING_ERASE_32K */
+	NOR_TIMING_ERASE_64K, /**< NOR_TIMING_ERASE_64K */
+	NOR_TIMING_ERASE_CHIP,/**< NOR_TIMING_ERASE_CHIP */
+
+	NOR_TIMING_COUNT
+}nor_timing_e;
+
 /**
  * Function Typedefs
  */
@@ -85,6 +136,59 @@ typedef void (*CS_Assert_fnx_t)(void);
 typedef void (*CS_Deassert_fxn_t)(void);
 typedef void (*delay_us_fxn_t)(uint32_t us);
 typedef void (*mutex_fxn_t)(void);
+typedef void (*lock_fxn_t)(void *LockCtx, nor_lock_e Mode);
+typedef void (*verify_fail_fxn_t)(uint32_t PageAddr);
+typedef uint32_t (*trace_time_fxn_t)(void);
+typedef uint8_t (*wait_ready_fxn_t)(uint32_t msTimeout);
+typedef uint8_t (*stream_sink_fxn_t)(void *Ctx, const uint8_t *pData, uint32_t Len);
+typedef void (*slow_sector_fxn_t)(uint32_t Sector, uint32_t EraseUs);
+typedef void (*bus_width_fxn_t)(uint8_t Lines);
+
+/**
+ * Operations Table
+ */
+
+/**
+ * @brief Operations of an instance, every one receiving the config.pOpsCtx of
+ * the nor_t, like the handle of its SPI bus. A single table serves any number
+ * of devices, and the same code drives them from different threads.
+ */
+typedef struct{
+	// Required, the same as the SpiTxFxn, SpiRxFxn, CsAssert, CsDeassert and
+	// DelayUs of the config
+	void (*SpiTx)(void *Ctx, uint8_t *TxBuff, uint32_t len);
+	void (*SpiRx)(void *Ctx, uint8_t *RxBuff, uint32_t len);
+	void (*CsAssert)(void *Ctx);
+	void (*CsDeassert)(void *Ctx);
+	void (*DelayUs)(void *Ctx, uint32_t us);
+	// Optional, the same as the config functions with the same name
+	void (*Lock)(void *Ctx, nor_lock_e Mode);
+	void (*Unlock)(void *Ctx, nor_lock_e Mode);
+	uint8_t (*WaitReady)(void *Ctx, uint32_t msTimeout);
+	void (*VerifyFail)(void *Ctx, uint32_t PageAddr);
+	uint32_t (*TimeUs)(void *Ctx);
+	void (*SlowSector)(void *Ctx, uint32_t Sector, uint32_t EraseUs);
+	void (*BusWidth)(void *Ctx, uint8_t Lines);
+}nor_ops_t;
+
+/**
+ * Trace Structs
+ */
+
+/**
+ * @brief One record for each SPI transaction (CS asserted to deasserted), with
+ * 16 bytes, stored little endian on dumps. Recorded only with NOR_TRACE defined.
+ */
+typedef struct{
+	// time of the CS assertion, in us
+	uint32_t u32Timestamp;
+	// opcode on the 8 MSB bits, and the next 3 bytes sent (the address)
+	uint32_t u32OpAddr;
+	// bytes transferred after the opcode and address, including dummy bytes
+	uint32_t u32Len;
+	// time spent on delays since the previous transaction, like busy polls, in us
+	uint32_t u32BusyUs;
+}nor_trace_rec_t;
 
 /**
  * Structs
@@ -100,6 +204,50 @@ typedef struct{
 		delay_us_fxn_t DelayUs;
 		mutex_fxn_t MutexLockFxn;
 		mutex_fxn_t MutexUnlockFxn;
+		// Optional lock with context, used instead of the Mutex functions when set.
+		// The bus transactions are done in EXCLUSIVE mode, and the lock is released
+		// between the status polls of the wait of a posted operation, so the same
+		// lock can be shared by all devices on a SPI bus. The synchronous
+		// operations keep it until they complete
+		lock_fxn_t LockFxn;
+		lock_fxn_t UnlockFxn;
+		void *LockCtx;
+		// Optional, block until the device is ready, returning 1, or 0 on timeout.
+		// Implement it with the auto-poll of a QSPI controller (match on BUSY = 0)
+		// or with the ready/busy line, waiting the interrupt. Called without the
+		// lock for posted operations, and with it for the synchronous ones. Must
+		// return at once if already ready, and the driver confirms the ready
+		// state with a single status read
+		wait_ready_fxn_t WaitReadyFxn;
+		// When not zero, NOR_WriteBytes returns right after the last Page Program
+		// command, and the busy wait is deferred to the next operation (or NOR_Sync)
+		uint8_t PostedWrite;
+		// When not zero, every programmed page is read back and compared by CRC32
+		uint8_t Verify;
+		// Optional, called with the address of every page that failed the verify
+		verify_fail_fxn_t VerifyFailFxn;
+		// When not zero, reads and programs suspend a posted erase in progress,
+		// instead of wait it. Enable only if the device supports the Erase
+		// Suspend/Resume commands (0x75/0x7A)
+		uint8_t EraseSuspend;
+		// Optional, a free running timestamp in us. When set, the duration of the
+		// programs and erases is learned, and the first busy poll is scheduled
+		// near the expected completion
+		trace_time_fxn_t TimeUsFxn;
+		// Optional, one entry per sector, with the average 4K erase time of the
+		// sector in units of NOR_TIMING_SECTOR_UNIT_US. Keep it between boots to
+		// track the wear
+		uint16_t *pSectorEraseTime;
+		// Optional, called after each 4K erase of a sector that erases slower
+		// than the average of the device, usually a sector near its end of life
+		slow_sector_fxn_t SlowSectorFxn;
+		// Optional, required by NOR_EnterQPI. Reconfigure the SPI transport to
+		// send and receive every byte on 1 or 4 Lines, including the opcode
+		bus_width_fxn_t BusWidthFxn;
+		// Optional, operations with context. When set, all the functions above
+		// are ignored, and the operations are called with pOpsCtx
+		const nor_ops_t *pOps;
+		void *pOpsCtx;
 	}config;
 	struct{
 		uint64_t u64UniqueId;
@@ -112,18 +260,112 @@ typedef struct{
 		uint32_t u32BlockSize;
 		uint32_t u32BlockCount;
 	}info;
+	struct{
+		// SPI transactions, CS asserted to deasserted. Compare it before and
+		// after an operation to get the transactions spent on it
+		uint32_t u32Transactions;
+		// busy polls not done, the device was known idle
+		uint32_t u32SkippedPolls;
+		// Write Enable commands not sent, the latch was known set
+		uint32_t u32SkippedWriteEnables;
+		// status writes not done, the register already had the value
+		uint32_t u32SkippedStatusWrites;
+		// batch operations merged into the transaction of another one, or
+		// erases covered by another erase of the batch
+		uint32_t u32CoalescedOps;
+		// reads and programs on the range of the posted erase, waited instead
+		// of suspend it
+		uint32_t u32SuspendWaits;
+		// programs and erases with the fail flag set by the device, only the
+		// MXIC devices report them, on the security register
+		uint32_t u32ProgramFails;
+		uint32_t u32EraseFails;
+	}stats;
+	struct{
+		// average duration of each nor_timing_e, in us, zero before the first
+		// sample. May be restored after NOR_Init
+		uint32_t u32AvgUs[NOR_TIMING_COUNT];
+		uint32_t u32MaxUs[NOR_TIMING_COUNT];
+		uint32_t u32Samples[NOR_TIMING_COUNT];
+		// 4K erases of slow sectors
+		uint32_t u32SlowErases;
+		// page programs slower than the average of the device
+		uint32_t u32SlowPrograms;
+	}timing;
 	struct{
 		uint16_t u16Initialized;
 		uint8_t u8StatusReg1;
 		uint8_t u8StatusReg2;
 		uint8_t u8StatusReg3;
 		uint8_t u8PdCount;
+		uint8_t u8BusyPending;
+		uint8_t u8Suspended;
+		uint8_t u8Batch;
+		// the pending operation was left by a posted call
+		uint8_t u8Posted;
+		uint8_t u8TimingOp;
+		uint8_t u8Qpi;
+		uint8_t u8ReadDummy;
+		// program or erase to check on the completion (nor_timing_e), and the
+		// one of the erase suspended, checked after the resume
+		uint8_t u8FailOp;
+		uint8_t u8SuspendedFailOp;
+		// failure of a posted operation, kept until NOR_Sync or NOR_IsBusy
+		uint8_t u8FailErr;
+		uint32_t u32FailAddr;
+		uint32_t u32SuspendedFailAddr;
+		uint32_t u32EraseMs;
+		// range of the posted erase
+		uint32_t u32EraseAddr;
+		uint32_t u32EraseSize;
+		uint32_t u32TimingAddr;
+		uint32_t u32TimingStart;
 	}_internal;
+#if defined (NOR_TRACE)
+	struct{
+		nor_trace_rec_t *pRing;
+		uint32_t u32Size;
+		uint32_t u32Head;
+		uint32_t u32Count;
+		uint32_t u32Dropped;
+		trace_time_fxn_t TimeFxn;
+		uint32_t u32DelayUs;
+		uint32_t u32BusyUs;
+		uint8_t u8Enabled;
+		uint8_t u8HdrLen;
+		nor_trace_rec_t Record;
+	}trace;
+#endif
 	nor_manuf_e Manufacturer;
 	nor_model_e Model;
 	nor_pd_e pdState;
 }nor_t;
 
+/**
+ * @brief Operation descriptor, for NOR_MultiExecute and NOR_BatchExecute
+ *
+ */
+typedef struct{
+	// ignored by NOR_BatchExecute
+	nor_t *nor;
+	nor_op_type_e Type;
+	uint32_t Address;
+	uint8_t *pBuffer;
+	uint32_t Len;
+	nor_erase_method_e Method;
+	// result of the operation, filled by the routine
+	nor_err_e Result;
+	struct{
+		uint8_t u8Done;
+		uint8_t u8InFlight;
+		uint32_t u32Offset;
+		uint32_t u32Issued;
+		// time busy, and the time of the issue when TimeUs is available
+		uint32_t u32WaitedUs;
+		uint32_t u32StartUs;
+	}_internal;
+}nor_op_t;
+
 /**
  * Publics
  */
@@ -200,6 +442,59 @@ nor_err_e NOR_EnterPowerDown(nor_t *nor);
  */
 nor_err_e NOR_ExitPowerDown(nor_t *nor);
 
+/* **********************************
+ * QPI and Reset Functions
+ * **********************************/
+
+/**
+ * @brief Enter on QPI (4-4-4) mode, where the opcode, the address and the data
+ * are sent on 4 lines, cutting the overhead of the small commands. The
+ * config.BusWidthFxn is called to reconfigure the transport. On Winbond devices
+ * the Quad Enable bit is set before, with 0x38, and on MXIC devices 0x35 is
+ * used. The mode is kept by the power down commands, and left by NOR_ExitQPI,
+ * NOR_Reset or NOR_Init.
+ *
+ * @param nor pointer to the Nor Instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL, or config.BusWidthFxn (or the BusWidth
+ * operation, with config.pOps) wasn't set
+ * @return NOR_UNKNOWN_DEVICE the manufacturer has no known QPI commands
+ * @return NOR_IS_LOCKED the Quad Enable bit is protected
+ * @return NOR_FAIL the previous operation wasn't completed on the expected time
+ */
+nor_err_e NOR_EnterQPI(nor_t *nor);
+
+/**
+ * @brief Leave the QPI mode, back to the SPI mode on a single line.
+ *
+ * @param nor pointer to the Nor Instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL
+ * @return NOR_FAIL the previous operation wasn't completed on the expected time
+ */
+nor_err_e NOR_ExitQPI(nor_t *nor);
+
+/**
+ * @brief Reset the device with the Enable Reset (0x66) and Reset (0x99)
+ * commands, to recover it after an operation failed. The commands are sent on
+ * 4 lines and then on a single line, when config.BusWidthFxn is set, since the
+ * mode of the device is unknown after a failure. The device is released from
+ * the power down before, and left on SPI mode. A running program or erase is
+ * aborted, and its data is undefined.
+ *
+ * @param nor pointer to the Nor Instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL
+ * @return NOR_FAIL the device is still busy after the reset
+ */
+nor_err_e NOR_Reset(nor_t *nor);
+
 /* **********************************
  * Memory Erase Functions
  * **********************************/
@@ -215,6 +510,7 @@ nor_err_e NOR_ExitPowerDown(nor_t *nor);
  * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
  * or NOR_Init_wo_ID
  * @return NOR_INVALID_PARAMS nor was NULL
+ * @return NOR_ERASE_FAILED the device reported the erase failed
  */
 nor_err_e NOR_EraseChip(nor_t *nor);
 
@@ -235,11 +531,47 @@ nor_err_e NOR_EraseChip(nor_t *nor);
  * or NOR_Init_wo_ID
  * @return NOR_INVALID_PARAMS nor was NULL or methos is an invalid address
  * @return NOR_OUT_OF_RANGE if Address is greater than the device memory
+ * @return NOR_ERASE_FAILED the device reported the erase failed, the sector
+ * is worn and should be retired (see nor_bbt)
+ * @return NOR_FAIL the erase wasn't completed on the expected time
  */
 nor_err_e NOR_EraseAddress(nor_t *nor, uint32_t Address, nor_erase_method_e method);
 nor_err_e NOR_EraseSector(nor_t *nor, uint32_t SectorAddr);
 nor_err_e NOR_EraseBlock(nor_t *nor, uint32_t BlockAddr);
 
+/**
+ * @brief Start the erase of an address and return without wait it. The next
+ * operation on the instance waits the erase, or suspends it, for reads and
+ * programs out of the erased range, when config.EraseSuspend is enabled. Use NOR_IsBusy to know when
+ * the erase was completed, or NOR_Sync to wait it, both report its failure.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param Address The address that we want to erase
+ * @param method Accept the following vaues: NOR_ERASE_4K, NOR_ERASE_32K and
+ * NOR_ERASE_64K
+ * @return NOR_OK the erase was started
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL or method is invalid
+ * @return NOR_FAIL the previous operation wasn't completed on the expected time
+ */
+nor_err_e NOR_EraseAddressPosted(nor_t *nor, uint32_t Address, nor_erase_method_e method);
+
+/**
+ * @brief Check, without wait, if the last posted operation is still running.
+ * Doesn't access the bus when nothing was posted.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param pBusy receives 1 if the device is busy, 0 otherwise
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor or pBusy was NULL
+ * @return NOR_PROGRAM_FAILED or NOR_ERASE_FAILED the device is idle, and reported
+ * a posted operation failed, since the last NOR_Sync or NOR_IsBusy
+ */
+nor_err_e NOR_IsBusy(nor_t *nor, uint8_t *pBusy);
+
 /* **********************************
  * Page/Sector/Block Conversions
  * **********************************/
@@ -263,11 +595,211 @@ nor_err_e NOR_IsEmptyBlock(nor_t *nor, uint32_t BlockAddr, uint32_t Offset, uint
  * Memory programming functions
  * **********************************/
 
+/**
+ * @brief Program a range, split on the page boundaries. The range should be
+ * erased.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param pBuffer data to program
+ * @param WriteAddr address of the first byte
+ * @param NumBytesToWrite number of bytes
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL or NumBytesToWrite is zero
+ * @return NOR_OUT_OF_RANGE the range is beyond the end of the device
+ * @return NOR_VERIFY_FAILED a page read back different, with config.Verify
+ * @return NOR_PROGRAM_FAILED the device reported a page program of this range
+ * failed, the sector is worn and should be retired (see nor_bbt). The failures
+ * of the posted operations before are reported by NOR_Sync or NOR_IsBusy
+ * @return NOR_FAIL a program wasn't completed on the expected time
+ */
 nor_err_e NOR_WriteBytes(nor_t *nor, uint8_t *pBuffer, uint32_t WriteAddr, uint32_t NumBytesToWrite);
 nor_err_e NOR_WritePage(nor_t *nor, uint8_t *pBuffer, uint32_t PageAddr, uint32_t Offset, uint32_t NumBytesToWrite);
 nor_err_e NOR_WriteSector(nor_t *nor, uint8_t *pBuffer, uint32_t SectorAddr, uint32_t Offset, uint32_t NumBytesToWrite);
 nor_err_e NOR_WriteBlock(nor_t *nor, uint8_t *pBuffer, uint32_t BlockAddr, uint32_t Offset, uint32_t NumBytesToWrite);
 
+/**
+ * @brief Same as NOR_WriteBytes with config.PostedWrite enabled, for this call
+ * only: returns right after the last Page Program command, and the next
+ * operation on the instance (or NOR_Sync) waits for it.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param pBuffer data to program, must be kept until the return
+ * @param WriteAddr address of the first byte
+ * @param NumBytesToWrite number of bytes
+ * @return NOR_OK the last page is being programmed, its failure is reported by
+ * NOR_Sync or NOR_IsBusy
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL or NumBytesToWrite is zero
+ * @return NOR_OUT_OF_RANGE the range is beyond the end of the device
+ * @return NOR_PROGRAM_FAILED the device reported a page program failed, before
+ * the last page
+ * @return NOR_FAIL the previous operation wasn't completed on the expected time
+ */
+nor_err_e NOR_WriteBytesPosted(nor_t *nor, uint8_t *pBuffer, uint32_t WriteAddr, uint32_t NumBytesToWrite);
+
+/**
+ * @brief Wait until the last posted operation was completed by the device.
+ * When config.PostedWrite is enabled, NOR_WriteBytes returns with the last page
+ * still being programmed, and the next operation on the instance waits for it.
+ * Call this function when you need the data programmed before continue, like
+ * before power off the device or before a reset.
+ *
+ * @param nor pointer to the Nor Instance
+ * @return NOR_OK everything was ok, the device is idle
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL
+ * @return NOR_FAIL the device doesn't finished the operation on the expected time
+ * @return NOR_PROGRAM_FAILED or NOR_ERASE_FAILED the device reported a posted
+ * operation failed, since the last NOR_Sync or NOR_IsBusy. The failure is kept
+ * by the instance until reported here, the reads and the other operations done
+ * meanwhile don't report it
+ */
+nor_err_e NOR_Sync(nor_t *nor);
+
+/**
+ * @brief Read a status register from the device, refreshing the copy kept by
+ * the instance.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param SelectSR NOR_SR1, NOR_SR2 or NOR_SR3
+ * @param pValue receives the register value
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor or pValue was NULL, or SelectSR is invalid
+ */
+nor_err_e NOR_ReadStatusRegister(nor_t *nor, nor_sr_e SelectSR, uint8_t *pValue);
+
+/**
+ * @brief Write the bits selected by Mask on a status register, like the Quad
+ * Enable or the block protection bits. Nothing is sent when the copy kept by
+ * the instance already has the value, otherwise the register is read back
+ * after the write.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param SelectSR NOR_SR1, NOR_SR2 or NOR_SR3
+ * @param Mask bits to change, BUSY and WEL are ignored
+ * @param Value new value of the bits
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor was NULL or SelectSR is invalid
+ * @return NOR_IS_LOCKED the device ignored the write, the register is protected
+ * @return NOR_FAIL the device doesn't finished the operation on the expected time
+ */
+nor_err_e NOR_WriteStatusRegister(nor_t *nor, nor_sr_e SelectSR, uint8_t Mask, uint8_t Value);
+
+/**
+ * @brief Calculate the CRC32 of a region of the memory. The data is streamed
+ * through a small buffer on the stack, so large regions can be checked without
+ * read it to the RAM. The CRC is the same of NOR_CRC32 (zlib crc32).
+ *
+ * @param nor pointer to the Nor Instance
+ * @param Address start address of the region
+ * @param NumBytes size of the region
+ * @param pCrc receives the CRC32 of the region
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor or pCrc was NULL, or NumBytes is zero
+ * @return NOR_OUT_OF_RANGE the region exceeds the device size
+ */
+nor_err_e NOR_Crc32Range(nor_t *nor, uint32_t Address, uint32_t NumBytes, uint32_t *pCrc);
+
+/* **********************************
+ * Memory copy functions
+ * **********************************/
+
+/**
+ * @brief Copy a region of the memory to another region of the same device.
+ * See NOR_CopyRangeEx.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param DstAddr destination address
+ * @param SrcAddr source address
+ * @param NumBytes number of bytes to copy
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS NumBytes is zero, or the regions are overlapped
+ * @return NOR_OUT_OF_RANGE a region exceeds the device size
+ * @return NOR_REGIONS_IS_NOT_EMPTY a partially copied sector must be erased
+ */
+nor_err_e NOR_CopyRange(nor_t *nor, uint32_t DstAddr, uint32_t SrcAddr, uint32_t NumBytes);
+
+/**
+ * @brief Copy a region of one device to a region of another device, or the same.
+ * The data flows through a page buffer on the stack. Destination pages that
+ * already hold the data are not programmed, and a destination sector is erased
+ * only if a changed page needs a bit going from 0 to 1.
+ *
+ * @note Only sectors entirely covered by the destination region can be erased,
+ * a partially covered sector that needs the erase returns NOR_REGIONS_IS_NOT_EMPTY.
+ *
+ * @param dst pointer to the destination Nor Instance
+ * @param DstAddr destination address
+ * @param src pointer to the source Nor Instance
+ * @param SrcAddr source address
+ * @param NumBytes number of bytes to copy
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS NumBytes is zero, or the regions are overlapped
+ * @return NOR_OUT_OF_RANGE a region exceeds the device size
+ * @return NOR_REGIONS_IS_NOT_EMPTY a partially copied sector must be erased
+ */
+nor_err_e NOR_CopyRangeEx(nor_t *dst, uint32_t DstAddr, nor_t *src, uint32_t SrcAddr, uint32_t NumBytes);
+
+/* **********************************
+ * Batch functions
+ * **********************************/
+
+/**
+ * @brief Execute several operations on the device holding the bus from the
+ * first to the last, even during the busy waits, so other tasks can't
+ * interleave with them. The operations are split in runs of consecutive
+ * operations of the same kind (erases, programs or reads), and inside a run:
+ * - the erases covered by a bigger erase, or repeated, are skipped;
+ * - the programs are executed by address, and the ones that continue on the
+ *   same page share a single Page Program;
+ * - the contiguous reads are streamed on a single transaction.
+ * The runs are executed in the order of the array, a read after a program
+ * always gets the programmed data. The busy polls are done only when a
+ * program or erase was issued, and the last one is waited before return.
+ * With config.Verify, the programs of each run are checked by CRC after it.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param pOps array of operations, the Result of each one is filled
+ * @param Count number of operations
+ * @return NOR_OK all operations were ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor or pOps was NULL, or Count is zero
+ * @return NOR_FAIL at least one operation failed, see the Result of each one
+ */
+nor_err_e NOR_BatchExecute(nor_t *nor, nor_op_t *pOps, uint32_t Count);
+
+/* **********************************
+ * Multiple devices functions
+ * **********************************/
+
+/**
+ * @brief Execute erases and programs on several devices at the same time. The
+ * command of each device is issued, and then the devices are polled round-robin,
+ * issuing the next command to the first device that finishes. The total time
+ * approaches the time of the slowest device, instead of the sum of all.
+ * Operations on the same device are executed in the order of the array.
+ * The timeout of each operation is measured with config.TimeUsFxn when set,
+ * otherwise it's counted on the polling delays, done on every round.
+ *
+ * @param pOps array of operations, the Result of each one is filled
+ * @param Count number of operations
+ * @return NOR_OK all operations were ok
+ * @return NOR_INVALID_PARAMS pOps was NULL or Count is zero
+ * @return NOR_FAIL at least one operation failed, see the Result of each one
+ */
+nor_err_e NOR_MultiExecute(nor_op_t *pOps, uint32_t Count);
+
 /* **********************************
  * Memory read functions
  * **********************************/
@@ -277,4 +809,68 @@ nor_err_e NOR_ReadPage(nor_t *nor, uint8_t *pBuffer, uint32_t PageAddr, uint32_t
 nor_err_e NOR_ReadSector(nor_t *nor, uint8_t *pBuffer, uint32_t SectorAddr, uint32_t Offset, uint32_t NumByteToRead);
 nor_err_e NOR_ReadBlock(nor_t *nor, uint8_t *pBuffer, uint32_t BlockAddr, uint32_t Offset, uint32_t NumByteToRead);
 
+/**
+ * @brief Read a region of any size with constant memory, handing the data to a
+ * consumer. The whole region is read with a single Fast Read command, through
+ * a buffer of NOR_STREAM_BUFFER_LEN bytes on the stack. Each chunk is valid
+ * only during the sink call, a consumer that sends it by DMA must copy it or
+ * wait the transfer before returning.
+ *
+ * @note The bus lock is held during the whole stream, including the sink calls.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param Address start address of the region
+ * @param NumBytes size of the region
+ * @param SinkFxn called with every chunk, returns 1 to continue or 0 to stop
+ * @param Ctx context passed to the sink
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED the Instance was not initialized, please call NOR_Init
+ * or NOR_Init_wo_ID
+ * @return NOR_INVALID_PARAMS nor or SinkFxn was NULL, or NumBytes is 0
+ * @return NOR_OUT_OF_RANGE the region is beyond the device size
+ * @return NOR_FAIL the sink stopped the stream, or the device was busy
+ */
+nor_err_e NOR_ReadStream(nor_t *nor, uint32_t Address, uint32_t NumBytes, stream_sink_fxn_t SinkFxn, void *Ctx);
+
+/* **********************************
+ * Trace functions
+ * **********************************/
+
+#if defined (NOR_TRACE)
+/**
+ * @brief Start to record every SPI transaction on a ring of records. When the
+ * ring is full, the oldest records are overwritten and counted as dropped.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param pRing ring of records, provided by the caller
+ * @param Size number of records of the ring
+ * @param TimeFxn function returning the time in us, or NULL to use the sum of
+ * the delays requested by the driver
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS nor or pRing was NULL, or Size is zero
+ */
+nor_err_e NOR_TRACE_Start(nor_t *nor, nor_trace_rec_t *pRing, uint32_t Size, trace_time_fxn_t TimeFxn);
+
+/**
+ * @brief Stop recording. The records still on the ring can be read.
+ *
+ * @param nor pointer to the Nor Instance
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_TRACE_Stop(nor_t *nor);
+
+/**
+ * @brief Move the oldest records from the ring to a buffer, to be dumped.
+ *
+ * @note Call it from the same context that uses the instance, or with the
+ * recording stopped.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param pRecords buffer to receive the records
+ * @param MaxRecords size of the buffer, in records
+ * @return number of records moved
+ */
+uint32_t NOR_TRACE_Read(nor_t *nor, nor_trace_rec_t *pRecords, uint32_t MaxRecords);
+#endif
+
 #endif /* FLASH_NOR_NOR_H_ */
@@ -0,0 +1,303 @@
+/*
+ * nor_bbt.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_bbt.h"
+#include "nor_crc.h"
+
+/*
+ * Privates
+ */
+
+#define _BBT_SANITY_CHECK(b)		if (b == NULL)	return NOR_INVALID_PARAMS;					\
+									if (b->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+/* Functions */
+
+static uint32_t _bbt_addr(nor_bbt_t *bbt, uint32_t Physical){
+	return (bbt->config.u32FirstSector + Physical) * bbt->nor->info.u16SectorSize;
+}
+
+static uint32_t _bbt_entry_crc(nor_bbt_entry_t *pEntry){
+	return NOR_CRC32(NOR_BBT_MAGIC, (uint8_t*)pEntry, 2 * sizeof(uint16_t));
+}
+
+static uint8_t _bbt_program_failed(nor_err_e err){
+	return (err == NOR_PROGRAM_FAILED || err == NOR_VERIFY_FAILED);
+}
+
+/*
+ * Append an entry on the next slot of the table. The slot and its spare are
+ * consumed even when the program fails.
+ */
+static nor_err_e _bbt_append(nor_bbt_t *bbt, uint16_t Sector){
+	nor_bbt_entry_t Entry;
+	uint32_t Address;
+
+	Entry.u16Sector = Sector;
+	Entry.u16Spare = bbt->_internal.u16SparesUsed;
+	Entry.u32Crc = _bbt_entry_crc(&Entry);
+	Address = (bbt->config.u32TableSector * bbt->nor->info.u16SectorSize) + (Entry.u16Spare * sizeof(Entry));
+	bbt->_internal.u16SparesUsed++;
+
+	return NOR_WriteBytes(bbt->nor, (uint8_t*)&Entry, Address, sizeof(Entry));
+}
+
+/*
+ * Copy a sector to an erased one, except the range Skip, written again by
+ * the caller. The erased pages aren't programmed.
+ */
+static nor_err_e _bbt_copy(nor_bbt_t *bbt, uint32_t Src, uint32_t Dst, uint32_t SkipOff, uint32_t SkipLen){
+	uint32_t Page, i;
+	uint16_t PageSize = bbt->nor->info.u16PageSize;
+	uint8_t Empty;
+	nor_err_e err;
+
+	for (Page=0 ; Page<bbt->nor->info.u16SectorSize ; Page+=PageSize){
+		if (Page >= SkipOff && (Page + PageSize) <= (SkipOff + SkipLen)){
+			continue;
+		}
+		err = NOR_ReadBytes(bbt->nor, bbt->_internal.u8Page, Src + Page, PageSize);
+		if (err != NOR_OK){
+			return err;
+		}
+		Empty = 1;
+		for (i=0 ; i<PageSize ; i++){
+			if ((Page + i) >= SkipOff && (Page + i) < (SkipOff + SkipLen)){
+				bbt->_internal.u8Page[i] = 0xFF;
+			}
+			if (bbt->_internal.u8Page[i] != 0xFF){
+				Empty = 0;
+			}
+		}
+		if (Empty){
+			continue;
+		}
+		err = NOR_WriteBytes(bbt->nor, bbt->_internal.u8Page, Dst + Page, PageSize);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	return NOR_OK;
+}
+
+/*
+ * Replace a sector by the next spare, copying the data out of the range Skip.
+ * A spare failing the erase or the copy is consumed, and the next one tried.
+ * The entry is appended only after the copy, a power loss before it leaves
+ * the spare free.
+ */
+static nor_err_e _bbt_replace(nor_bbt_t *bbt, uint32_t Sector, uint32_t SkipOff, uint32_t SkipLen){
+	uint32_t Spare, Dst;
+	nor_err_e err;
+
+	while (bbt->_internal.u16SparesUsed < bbt->_internal.u16SparesMax){
+		Spare = bbt->config.u32SectorCount + bbt->_internal.u16SparesUsed;
+		Dst = _bbt_addr(bbt, Spare);
+		err = NOR_EraseAddress(bbt->nor, Dst, NOR_ERASE_4K);
+		if (err == NOR_OK){
+			err = _bbt_copy(bbt, _bbt_addr(bbt, bbt->config.pMap[Sector]), Dst, SkipOff, SkipLen);
+		}
+		if (err == NOR_ERASE_FAILED || _bbt_program_failed(err)){
+			bbt->stats.u32BadSpares++;
+			if (_bbt_append(bbt, NOR_BBT_SPARE_BAD) != NOR_OK){
+				return NOR_FAIL;
+			}
+			continue;
+		}
+		if (err != NOR_OK || _bbt_append(bbt, Sector) != NOR_OK){
+			return NOR_FAIL;
+		}
+		bbt->config.pMap[Sector] = Spare;
+		bbt->stats.u32Retired++;
+		return NOR_OK;
+	}
+	return NOR_FAIL;
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_BBT_Init(nor_bbt_t *bbt){
+	nor_bbt_entry_t Entry;
+	uint32_t i, Slot, Offset, TableAddr;
+	nor_err_e err;
+
+	if (bbt == NULL || bbt->nor == NULL || bbt->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			bbt->config.pMap == NULL || bbt->config.u32SectorCount == 0 || bbt->config.u32SpareCount == 0 ||
+			(bbt->config.u32SectorCount + bbt->config.u32SpareCount) > NOR_BBT_SPARE_BAD){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((bbt->config.u32FirstSector + bbt->config.u32SectorCount + bbt->config.u32SpareCount) > bbt->nor->info.u32SectorCount ||
+			bbt->config.u32TableSector >= bbt->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	if (bbt->config.u32TableSector >= bbt->config.u32FirstSector &&
+			bbt->config.u32TableSector < (bbt->config.u32FirstSector + bbt->config.u32SectorCount + bbt->config.u32SpareCount)){
+		return NOR_INVALID_PARAMS;
+	}
+	bbt->_internal.u16Initialized = 0;
+	bbt->_internal.u16SparesMax = bbt->nor->info.u16SectorSize / sizeof(nor_bbt_entry_t);
+	if (bbt->config.u32SpareCount < bbt->_internal.u16SparesMax){
+		bbt->_internal.u16SparesMax = bbt->config.u32SpareCount;
+	}
+	for (i=0 ; i<bbt->config.u32SectorCount ; i++){
+		bbt->config.pMap[i] = i;
+	}
+	// the entries are replayed in order, the last one of a sector wins
+	TableAddr = bbt->config.u32TableSector * bbt->nor->info.u16SectorSize;
+	for (Slot=0 ; Slot<bbt->_internal.u16SparesMax ; Slot++){
+		Offset = (Slot * sizeof(Entry)) % bbt->nor->info.u16PageSize;
+		if (Offset == 0){
+			err = NOR_ReadBytes(bbt->nor, bbt->_internal.u8Page, TableAddr + (Slot * sizeof(Entry)), bbt->nor->info.u16PageSize);
+			if (err != NOR_OK){
+				return NOR_FAIL;
+			}
+		}
+		memcpy(&Entry, &bbt->_internal.u8Page[Offset], sizeof(Entry));
+		if (Entry.u16Sector == 0xFFFF && Entry.u16Spare == 0xFFFF && Entry.u32Crc == 0xFFFFFFFF){
+			break;
+		}
+		// a torn entry only consumes its spare
+		if (Entry.u32Crc == _bbt_entry_crc(&Entry) && Entry.u16Spare == Slot &&
+				Entry.u16Sector < bbt->config.u32SectorCount){
+			bbt->config.pMap[Entry.u16Sector] = bbt->config.u32SectorCount + Slot;
+		}
+	}
+	bbt->_internal.u16SparesUsed = Slot;
+	memset(&bbt->stats, 0, sizeof(bbt->stats));
+	bbt->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_BBT_Read(nor_bbt_t *bbt, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	uint32_t Sector, SectorOffset, Chunk;
+	uint16_t SectorSize;
+	nor_err_e err;
+
+	_BBT_SANITY_CHECK(bbt);
+
+	if (pData == NULL || Len == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	SectorSize = bbt->nor->info.u16SectorSize;
+	if (Offset >= (bbt->config.u32SectorCount * SectorSize) || Len > ((bbt->config.u32SectorCount * SectorSize) - Offset)){
+		return NOR_OUT_OF_RANGE;
+	}
+	while (Len > 0){
+		Sector = Offset / SectorSize;
+		SectorOffset = Offset % SectorSize;
+		Chunk = ((SectorSize - SectorOffset) < Len) ? (SectorSize - SectorOffset) : Len;
+		err = NOR_ReadBytes(bbt->nor, pData, _bbt_addr(bbt, bbt->config.pMap[Sector]) + SectorOffset, Chunk);
+		if (err != NOR_OK){
+			return NOR_FAIL;
+		}
+		pData += Chunk;
+		Offset += Chunk;
+		Len -= Chunk;
+	}
+	return NOR_OK;
+}
+
+nor_err_e NOR_BBT_Write(nor_bbt_t *bbt, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	uint32_t Sector, SectorOffset, Chunk, Slow;
+	uint16_t SectorSize;
+	nor_err_e err;
+
+	_BBT_SANITY_CHECK(bbt);
+
+	if (pData == NULL || Len == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	SectorSize = bbt->nor->info.u16SectorSize;
+	if (Offset >= (bbt->config.u32SectorCount * SectorSize) || Len > ((bbt->config.u32SectorCount * SectorSize) - Offset)){
+		return NOR_OUT_OF_RANGE;
+	}
+	while (Len > 0){
+		Sector = Offset / SectorSize;
+		SectorOffset = Offset % SectorSize;
+		Chunk = ((SectorSize - SectorOffset) < Len) ? (SectorSize - SectorOffset) : Len;
+		Slow = bbt->nor->timing.u32SlowPrograms;
+		err = NOR_WriteBytes(bbt->nor, pData, _bbt_addr(bbt, bbt->config.pMap[Sector]) + SectorOffset, Chunk);
+		while (_bbt_program_failed(err)){
+			bbt->stats.u32ProgramFails++;
+			// the failed range may hold garbage, it isn't copied
+			if (_bbt_replace(bbt, Sector, SectorOffset, Chunk) != NOR_OK){
+				return err;
+			}
+			err = NOR_WriteBytes(bbt->nor, pData, _bbt_addr(bbt, bbt->config.pMap[Sector]) + SectorOffset, Chunk);
+		}
+		if (err != NOR_OK){
+			return NOR_FAIL;
+		}
+		if ((bbt->config.u8Flags & NOR_BBT_RETIRE_SLOW) && bbt->nor->timing.u32SlowPrograms != Slow){
+			bbt->stats.u32SlowOps++;
+			// the data was programmed, the sector is retired while there are spares
+			_bbt_replace(bbt, Sector, 0, 0);
+		}
+		pData += Chunk;
+		Offset += Chunk;
+		Len -= Chunk;
+	}
+	return NOR_OK;
+}
+
+nor_err_e NOR_BBT_EraseSector(nor_bbt_t *bbt, uint32_t Sector){
+	uint32_t Slow;
+	nor_err_e err;
+
+	_BBT_SANITY_CHECK(bbt);
+
+	if (Sector >= bbt->config.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	Slow = bbt->nor->timing.u32SlowErases;
+	err = NOR_EraseAddress(bbt->nor, _bbt_addr(bbt, bbt->config.pMap[Sector]), NOR_ERASE_4K);
+	if (err == NOR_ERASE_FAILED){
+		bbt->stats.u32EraseFails++;
+		// the spare is erased, nothing to copy
+		if (_bbt_replace(bbt, Sector, 0, bbt->nor->info.u16SectorSize) != NOR_OK){
+			return err;
+		}
+		return NOR_OK;
+	}
+	if (err != NOR_OK){
+		return NOR_FAIL;
+	}
+	if ((bbt->config.u8Flags & NOR_BBT_RETIRE_SLOW) && bbt->nor->timing.u32SlowErases != Slow){
+		bbt->stats.u32SlowOps++;
+		_bbt_replace(bbt, Sector, 0, bbt->nor->info.u16SectorSize);
+	}
+	return NOR_OK;
+}
+
+nor_err_e NOR_BBT_Retire(nor_bbt_t *bbt, uint32_t Sector){
+	_BBT_SANITY_CHECK(bbt);
+
+	if (Sector >= bbt->config.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	return _bbt_replace(bbt, Sector, 0, 0);
+}
+
+uint32_t NOR_BBT_GetAddress(nor_bbt_t *bbt, uint32_t Sector){
+	if (bbt == NULL || bbt->_internal.u16Initialized != NOR_INITIALIZED_FLAG || Sector >= bbt->config.u32SectorCount){
+		return 0xFFFFFFFF;
+	}
+	return _bbt_addr(bbt, bbt->config.pMap[Sector]);
+}
+
+uint32_t NOR_BBT_GetFreeSpares(nor_bbt_t *bbt){
+	if (bbt == NULL || bbt->_internal.u16Initialized != NOR_INITIALIZED_FLAG){
+		return 0;
+	}
+	return bbt->_internal.u16SparesMax - bbt->_internal.u16SparesUsed;
+}
@@ -0,0 +1,188 @@
+/*
+ * nor_bbt.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Bad sector table. A region of logical sectors is backed by a pool of
+ *  spare sectors: when a program or erase fails, or is too slow, the sector
+ *  is retired and replaced by a spare, copying its data. The accesses go
+ *  through a RAM map indexed by the logical sector, so the lookup is O(1).
+ *
+ *  The retirements are appended to a table sector, one entry programmed on
+ *  an erased slot each, so the table is never erased and survives a power
+ *  loss at any point: a torn entry is skipped, with its spare.
+ *
+ *  The failures are reported by the MXIC devices (NOR_PROGRAM_FAILED and
+ *  NOR_ERASE_FAILED). On the other devices, enable config.Verify of the nor_t
+ *  to catch the failed programs, and the timing (config.TimeUsFxn and
+ *  config.pSectorEraseTime) to catch the slow ones.
+ */
+
+#ifndef NOR_BBT_H_
+#define NOR_BBT_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_BBT_MAGIC				0x5442424E	// "NBBT", seed of the entry CRC
+
+// Sector of an entry consuming a spare that failed itself
+#define NOR_BBT_SPARE_BAD			0xFFFF
+
+// Retire the sectors found slow, not only the failed ones
+#define NOR_BBT_RETIRE_SLOW			0x01
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	// logical sector retired, or NOR_BBT_SPARE_BAD
+	uint16_t u16Sector;
+	// spare replacing it, the index of the entry on the table
+	uint16_t u16Spare;
+	// CRC32 of the 4 bytes above, seeded with NOR_BBT_MAGIC
+	uint32_t u32Crc;
+}nor_bbt_entry_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+		// spares, right after the logical sectors, up to 0xFFFF sectors with
+		// them. Only SectorSize / 8 spares can be used, the entries of the table
+		uint32_t u32SpareCount;
+		// sector of the table, out of the logical sectors and the spares
+		uint32_t u32TableSector;
+		// SectorCount entries, the physical sector of every logical one,
+		// relative to FirstSector
+		uint16_t *pMap;
+		uint8_t u8Flags;
+	}config;
+	struct{
+		uint32_t u32ProgramFails;
+		uint32_t u32EraseFails;
+		// operations found slow, with NOR_BBT_RETIRE_SLOW
+		uint32_t u32SlowOps;
+		uint32_t u32Retired;
+		// spares that failed while replacing a sector
+		uint32_t u32BadSpares;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		// spares consumed, and the slots used on the table
+		uint16_t u16SparesUsed;
+		uint16_t u16SparesMax;
+		uint8_t u8Page[NOR_PAGE_SIZE];
+	}_internal;
+}nor_bbt_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Load the table and build the map. An erased table sector is a
+ * table without bad sectors. Fill the nor and config fields before call
+ * this function.
+ *
+ * @param bbt pointer to the bad sector table
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid, or the table sector is
+ * inside the region
+ * @return NOR_OUT_OF_RANGE the region or the table is beyond the device
+ * @return NOR_FAIL failed to read the table
+ */
+nor_err_e NOR_BBT_Init(nor_bbt_t *bbt);
+
+/**
+ * @brief Read a range of the logical sectors.
+ *
+ * @param bbt pointer to the bad sector table
+ * @param Offset offset on the region
+ * @param pData receives the data
+ * @param Len length of the range
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_BBT_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL or Len is zero
+ * @return NOR_OUT_OF_RANGE the range is beyond the region
+ * @return NOR_FAIL failed to read
+ */
+nor_err_e NOR_BBT_Read(nor_bbt_t *bbt, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Program a range of the logical sectors, the range should be erased.
+ * A sector failing the program is retired, its data copied to a spare, and
+ * the program is done again on the spare.
+ *
+ * @param bbt pointer to the bad sector table
+ * @param Offset offset on the region
+ * @param pData data to program
+ * @param Len length of the range
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_BBT_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL or Len is zero
+ * @return NOR_OUT_OF_RANGE the range is beyond the region
+ * @return NOR_PROGRAM_FAILED or NOR_VERIFY_FAILED the program failed, and
+ * there is no spare left
+ * @return NOR_FAIL failed to access the device
+ */
+nor_err_e NOR_BBT_Write(nor_bbt_t *bbt, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Erase a logical sector. A sector failing the erase is replaced by
+ * an erased spare.
+ *
+ * @param bbt pointer to the bad sector table
+ * @param Sector logical sector
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_BBT_Init first
+ * @return NOR_OUT_OF_RANGE the sector is beyond the region
+ * @return NOR_ERASE_FAILED the erase failed, and there is no spare left
+ * @return NOR_FAIL failed to access the device
+ */
+nor_err_e NOR_BBT_EraseSector(nor_bbt_t *bbt, uint32_t Sector);
+
+/**
+ * @brief Retire a logical sector now, copying its data to a spare. Use it
+ * for the wear seen by the upper layers, like the ECC corrections or the
+ * config.SlowSectorFxn of the nor_t.
+ *
+ * @param bbt pointer to the bad sector table
+ * @param Sector logical sector
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_BBT_Init first
+ * @return NOR_OUT_OF_RANGE the sector is beyond the region
+ * @return NOR_FAIL there is no spare left, or failed to access the device
+ */
+nor_err_e NOR_BBT_Retire(nor_bbt_t *bbt, uint32_t Sector);
+
+/**
+ * @brief Get the address of a logical sector on the device.
+ *
+ * @param bbt pointer to the bad sector table
+ * @param Sector logical sector
+ * @return the address, or 0xFFFFFFFF if the sector is beyond the region
+ */
+uint32_t NOR_BBT_GetAddress(nor_bbt_t *bbt, uint32_t Sector);
+
+/**
+ * @brief Get the spares not used yet.
+ *
+ * @param bbt pointer to the bad sector table
+ * @return number of spares, 0 if the table isn't initialized
+ */
+uint32_t NOR_BBT_GetFreeSpares(nor_bbt_t *bbt);
+
+#endif /* NOR_BBT_H_ */
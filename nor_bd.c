@@ -0,0 +1,527 @@
+/*
+ * nor_bd.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_bd.h"
+
+/*
+ * Privates
+ */
+
+#define _BD_SANITY_CHECK(b)			if (b == NULL)	return NOR_INVALID_PARAMS;					\
+									if (b->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+#define _BD_INVALID_ADDR			0xFFFFFFFF
+
+/* Functions */
+
+static void _bd_lock(nor_bd_t *bd, nor_lock_e Mode){
+	if (bd->config.LockFxn != NULL){
+		bd->config.LockFxn(bd->config.LockCtx, Mode);
+	}
+}
+
+static void _bd_unlock(nor_bd_t *bd, nor_lock_e Mode){
+	if (bd->config.UnlockFxn != NULL){
+		bd->config.UnlockFxn(bd->config.LockCtx, Mode);
+	}
+}
+
+static uint8_t _bd_is_pow2(uint32_t value){
+	return (value != 0 && (value & (value - 1)) == 0);
+}
+
+static uint8_t _bd_overlap(uint32_t a, uint32_t aLen, uint32_t b, uint32_t bLen){
+	return (a < (b + bLen) && b < (a + aLen));
+}
+
+/*
+ * AND the bytes of Src over the bytes of Dst on the same addresses. Programs
+ * only clear bits, so this applies a program on a copy of the flash.
+ */
+static void _bd_and(uint8_t *pDst, uint32_t DstAddr, uint32_t DstLen, uint8_t *pSrc, uint32_t SrcAddr, uint32_t SrcLen){
+	uint32_t Start, End;
+
+	Start = (DstAddr > SrcAddr) ? DstAddr : SrcAddr;
+	End = ((DstAddr + DstLen) < (SrcAddr + SrcLen)) ? (DstAddr + DstLen) : (SrcAddr + SrcLen);
+	for ( ; Start < End ; Start++){
+		pDst[Start - DstAddr] &= pSrc[Start - SrcAddr];
+	}
+}
+
+static uint32_t _bd_block_addr(nor_bd_t *bd, uint32_t Block){
+	return (bd->config.u32FirstSector * bd->nor->info.u16SectorSize) + (Block * bd->config.u32BlockSize);
+}
+
+static uint8_t _bd_is_erased(nor_bd_t *bd, uint32_t Block){
+	if (bd->config.pErasedMap == NULL){
+		return 0;
+	}
+	return ((bd->config.pErasedMap[Block / 8] >> (Block % 8)) & 1);
+}
+
+static void _bd_set_erased(nor_bd_t *bd, uint32_t Block, uint8_t erased){
+	if (bd->config.pErasedMap == NULL){
+		return;
+	}
+	if (erased){
+		bd->config.pErasedMap[Block / 8] |= (1 << (Block % 8));
+	}
+	else{
+		bd->config.pErasedMap[Block / 8] &= ~(1 << (Block % 8));
+	}
+}
+
+static uint8_t _bd_erase_pending(nor_bd_t *bd, uint32_t Address, uint32_t Size){
+	return (bd->_internal.u32EraseLen > 0 &&
+			_bd_overlap(Address, Size, bd->_internal.u32EraseAddr, bd->_internal.u32EraseLen));
+}
+
+static void _bd_invalidate_read(nor_bd_t *bd, uint32_t Address, uint32_t Size){
+	if (bd->_internal.u32ReadCacheAddr != _BD_INVALID_ADDR &&
+			_bd_overlap(Address, Size, bd->_internal.u32ReadCacheAddr, bd->config.u16ReadCacheSize)){
+		bd->_internal.u32ReadCacheAddr = _BD_INVALID_ADDR;
+	}
+}
+
+static void _bd_update_read(nor_bd_t *bd, uint32_t Address, uint8_t *pBuffer, uint32_t Size){
+	if (bd->_internal.u32ReadCacheAddr != _BD_INVALID_ADDR){
+		_bd_and(bd->config.pReadCache, bd->_internal.u32ReadCacheAddr, bd->config.u16ReadCacheSize,
+				pBuffer, Address, Size);
+	}
+}
+
+static void _bd_overlay_prog(nor_bd_t *bd, uint8_t *pBuffer, uint32_t Address, uint32_t Size){
+	if (bd->_internal.u16ProgCacheLen > 0){
+		_bd_and(pBuffer, Address, Size, bd->config.pProgCache,
+				bd->_internal.u32ProgCacheAddr, bd->_internal.u16ProgCacheLen);
+	}
+}
+
+/*
+ * Serve the read from the RAM, when the block is known as erased, the erase is
+ * pending, or the data is on the read cache. Needs the lock, in any mode.
+ */
+static uint8_t _bd_read_ram(nor_bd_t *bd, uint32_t Block, uint32_t Address, uint8_t *pBuffer, uint32_t Size){
+	uint32_t Line = bd->_internal.u32ReadCacheAddr;
+
+	if (_bd_is_erased(bd, Block) || _bd_erase_pending(bd, Address, Size)){
+		memset(pBuffer, 0xFF, Size);
+		bd->stats.u32ErasedReads++;
+		return 1;
+	}
+	if (Line != _BD_INVALID_ADDR && Address >= Line && (Address + Size) <= (Line + bd->config.u16ReadCacheSize)){
+		memcpy(pBuffer, &bd->config.pReadCache[Address - Line], Size);
+		bd->stats.u32CacheHits++;
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * The flush functions are called by writers, with the lock in EXCLUSIVE mode,
+ * and release it during the bus operations.
+ */
+
+static nor_err_e _bd_flush_prog(nor_bd_t *bd){
+	nor_err_e err;
+
+	if (bd->_internal.u16ProgCacheLen == 0){
+		return NOR_OK;
+	}
+	// readers keep applying the prog cache over the flash until it's programmed
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+	err = NOR_WriteBytes(bd->nor, bd->config.pProgCache, bd->_internal.u32ProgCacheAddr, bd->_internal.u16ProgCacheLen);
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	bd->_internal.u16ProgCacheLen = 0;
+	bd->stats.u32Progs++;
+
+	return err;
+}
+
+static nor_err_e _bd_flush_erase(nor_bd_t *bd){
+	uint32_t Address, Size, Block;
+	nor_erase_method_e method;
+	nor_err_e err;
+
+	_bd_invalidate_read(bd, bd->_internal.u32EraseAddr, bd->_internal.u32EraseLen);
+	Block = (bd->_internal.u32EraseAddr - _bd_block_addr(bd, 0)) / bd->config.u32BlockSize;
+	while (bd->_internal.u32EraseLen > 0){
+		Address = bd->_internal.u32EraseAddr;
+		// always use the largest erase aligned with the address
+		if ((Address % NOR_BLOCK_SIZE) == 0 && bd->_internal.u32EraseLen >= NOR_BLOCK_SIZE){
+			method = NOR_ERASE_64K;
+			Size = NOR_BLOCK_SIZE;
+		}
+		else if ((Address % (NOR_BLOCK_SIZE/2)) == 0 && bd->_internal.u32EraseLen >= (NOR_BLOCK_SIZE/2)){
+			method = NOR_ERASE_32K;
+			Size = NOR_BLOCK_SIZE/2;
+		}
+		else{
+			method = NOR_ERASE_4K;
+			Size = NOR_SECTOR_SIZE;
+		}
+		// the region stays pending while erasing, and the readers get 0xFF. The
+		// erase is posted, so the readers of other blocks can use the bus (or
+		// suspend it) until it completes
+		_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+		err = NOR_EraseAddressPosted(bd->nor, Address, method);
+		if (err == NOR_OK){
+			err = NOR_Sync(bd->nor);
+		}
+		_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+		if (err != NOR_OK){
+			bd->_internal.u32EraseLen = 0;
+			return err;
+		}
+		bd->stats.u32Erases++;
+		bd->_internal.u32EraseAddr += Size;
+		bd->_internal.u32EraseLen -= Size;
+		// mark the blocks fully erased until now
+		while (Block < bd->config.u32BlockCount &&
+				(_bd_block_addr(bd, Block) + bd->config.u32BlockSize) <= bd->_internal.u32EraseAddr){
+			_bd_set_erased(bd, Block, 1);
+			Block++;
+		}
+	}
+
+	return NOR_OK;
+}
+
+static nor_err_e _bd_prepare(nor_bd_t *bd, uint32_t Address, uint32_t Size){
+	nor_err_e err;
+
+	if (_bd_erase_pending(bd, Address, Size)){
+		err = _bd_flush_erase(bd);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	if (bd->_internal.u16ProgCacheLen > 0 &&
+			_bd_overlap(Address, Size, bd->_internal.u32ProgCacheAddr, bd->_internal.u16ProgCacheLen)){
+		return _bd_flush_prog(bd);
+	}
+
+	return NOR_OK;
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_BD_Init(nor_bd_t *bd){
+	if (bd == NULL || bd->nor == NULL || bd->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			bd->config.u32BlockCount == 0 || bd->config.u32BlockSize == 0 ||
+			(bd->config.u32BlockSize % bd->nor->info.u16SectorSize) != 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if (bd->config.pReadCache != NULL &&
+			(!_bd_is_pow2(bd->config.u16ReadCacheSize) || bd->config.u16ReadCacheSize > bd->nor->info.u16SectorSize)){
+		return NOR_INVALID_PARAMS;
+	}
+	if (bd->config.pProgCache != NULL &&
+			(!_bd_is_pow2(bd->config.u16ProgCacheSize) || bd->config.u16ProgCacheSize > bd->nor->info.u16PageSize)){
+		return NOR_INVALID_PARAMS;
+	}
+	if (((bd->config.u32FirstSector * bd->nor->info.u16SectorSize) +
+			(bd->config.u32BlockCount * bd->config.u32BlockSize)) > bd->nor->info.u32Size){
+		return NOR_OUT_OF_RANGE;
+	}
+	if (bd->config.pErasedMap != NULL){
+		// nothing is known about the blocks yet
+		memset(bd->config.pErasedMap, 0, (bd->config.u32BlockCount + 7) / 8);
+	}
+	memset(&bd->stats, 0, sizeof(bd->stats));
+	bd->_internal.u32ReadCacheAddr = _BD_INVALID_ADDR;
+	bd->_internal.u16ProgCacheLen = 0;
+	bd->_internal.u32EraseLen = 0;
+	bd->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_BD_Read(nor_bd_t *bd, uint32_t Block, uint32_t Offset, uint8_t *pBuffer, uint32_t Size){
+	uint32_t Address, Line, Chunk;
+	nor_err_e err = NOR_OK;
+
+	_BD_SANITY_CHECK(bd);
+
+	if (pBuffer == NULL || Size == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Block >= bd->config.u32BlockCount || (Offset + Size) > bd->config.u32BlockSize){
+		return NOR_OUT_OF_RANGE;
+	}
+	Address = _bd_block_addr(bd, Block) + Offset;
+	_bd_lock(bd, NOR_LOCK_SHARED);
+	if (_bd_read_ram(bd, Block, Address, pBuffer, Size)){
+		_bd_unlock(bd, NOR_LOCK_SHARED);
+		return NOR_OK;
+	}
+	if (bd->config.pReadCache == NULL || Size >= bd->config.u16ReadCacheSize){
+		bd->stats.u32BusReads++;
+		err = NOR_ReadBytes(bd->nor, pBuffer, Address, Size);
+		_bd_overlay_prog(bd, pBuffer, Address, Size);
+		_bd_unlock(bd, NOR_LOCK_SHARED);
+		return err;
+	}
+	_bd_unlock(bd, NOR_LOCK_SHARED);
+	// wait a program or erase in progress out of the lock, so the other readers can use the RAM
+	NOR_Sync(bd->nor);
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	if (_bd_read_ram(bd, Block, Address, pBuffer, Size)){
+		_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+		return NOR_OK;
+	}
+	while (Size > 0){
+		Line = Address & ~((uint32_t)bd->config.u16ReadCacheSize - 1);
+		if (Line != bd->_internal.u32ReadCacheAddr){
+			bd->_internal.u32ReadCacheAddr = _BD_INVALID_ADDR;
+			err = NOR_ReadBytes(bd->nor, bd->config.pReadCache, Line, bd->config.u16ReadCacheSize);
+			if (err != NOR_OK){
+				break;
+			}
+			_bd_overlay_prog(bd, bd->config.pReadCache, Line, bd->config.u16ReadCacheSize);
+			bd->_internal.u32ReadCacheAddr = Line;
+			bd->stats.u32BusReads++;
+		}
+		else{
+			bd->stats.u32CacheHits++;
+		}
+		Chunk = bd->config.u16ReadCacheSize - (Address - Line);
+		if (Chunk > Size){
+			Chunk = Size;
+		}
+		memcpy(pBuffer, &bd->config.pReadCache[Address - Line], Chunk);
+		pBuffer += Chunk;
+		Address += Chunk;
+		Size -= Chunk;
+	}
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+
+	return err;
+}
+
+nor_err_e NOR_BD_Prog(nor_bd_t *bd, uint32_t Block, uint32_t Offset, uint8_t *pBuffer, uint32_t Size){
+	uint32_t Address, Window, Chunk;
+	nor_err_e err = NOR_OK;
+
+	_BD_SANITY_CHECK(bd);
+
+	if (pBuffer == NULL || Size == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Block >= bd->config.u32BlockCount || (Offset + Size) > bd->config.u32BlockSize){
+		return NOR_OUT_OF_RANGE;
+	}
+	Address = _bd_block_addr(bd, Block) + Offset;
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	if (_bd_erase_pending(bd, Address, Size)){
+		err = _bd_flush_erase(bd);
+		if (err != NOR_OK){
+			_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+			return err;
+		}
+	}
+	_bd_set_erased(bd, Block, 0);
+	// programming only clears bits, keep the read cache coherent
+	_bd_update_read(bd, Address, pBuffer, Size);
+	if (bd->config.pProgCache == NULL){
+		bd->stats.u32Progs++;
+		_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+		err = NOR_WriteBytes(bd->nor, pBuffer, Address, Size);
+		_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+		// a reader may have cached the line while it was being programmed
+		_bd_update_read(bd, Address, pBuffer, Size);
+		_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+		return err;
+	}
+	while (Size > 0){
+		Window = Address & ~((uint32_t)bd->config.u16ProgCacheSize - 1);
+		if (bd->_internal.u16ProgCacheLen > 0 &&
+				(Address != (bd->_internal.u32ProgCacheAddr + bd->_internal.u16ProgCacheLen) ||
+				Window != (bd->_internal.u32ProgCacheAddr & ~((uint32_t)bd->config.u16ProgCacheSize - 1)))){
+			err = _bd_flush_prog(bd);
+			if (err != NOR_OK){
+				break;
+			}
+		}
+		if (bd->_internal.u16ProgCacheLen == 0){
+			bd->_internal.u32ProgCacheAddr = Address;
+		}
+		Chunk = bd->config.u16ProgCacheSize - (Address - Window);
+		if (Chunk > Size){
+			Chunk = Size;
+		}
+		memcpy(&bd->config.pProgCache[bd->_internal.u16ProgCacheLen], pBuffer, Chunk);
+		bd->_internal.u16ProgCacheLen += Chunk;
+		pBuffer += Chunk;
+		Address += Chunk;
+		Size -= Chunk;
+		if ((Address - Window) == bd->config.u16ProgCacheSize){
+			// the window is complete
+			err = _bd_flush_prog(bd);
+			if (err != NOR_OK){
+				break;
+			}
+		}
+	}
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+
+	return err;
+}
+
+nor_err_e NOR_BD_Erase(nor_bd_t *bd, uint32_t Block){
+	uint32_t Address;
+	nor_err_e err = NOR_OK;
+
+	_BD_SANITY_CHECK(bd);
+
+	if (Block >= bd->config.u32BlockCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	if (_bd_is_erased(bd, Block)){
+		bd->stats.u32ErasesSkipped++;
+		_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+		return NOR_OK;
+	}
+	Address = _bd_block_addr(bd, Block);
+	// data waiting to be programmed on this block will be erased anyway
+	if (bd->_internal.u16ProgCacheLen > 0 &&
+			_bd_overlap(Address, bd->config.u32BlockSize, bd->_internal.u32ProgCacheAddr, bd->_internal.u16ProgCacheLen)){
+		bd->_internal.u16ProgCacheLen = 0;
+	}
+	_bd_invalidate_read(bd, Address, bd->config.u32BlockSize);
+	if (bd->_internal.u32EraseLen > 0){
+		if (Address == (bd->_internal.u32EraseAddr + bd->_internal.u32EraseLen)){
+			bd->_internal.u32EraseLen += bd->config.u32BlockSize;
+			_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+			return NOR_OK;
+		}
+		err = _bd_flush_erase(bd);
+	}
+	if (err == NOR_OK){
+		bd->_internal.u32EraseAddr = Address;
+		bd->_internal.u32EraseLen = bd->config.u32BlockSize;
+	}
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+
+	return err;
+}
+
+nor_err_e NOR_BD_Sync(nor_bd_t *bd){
+	nor_err_e err;
+
+	_BD_SANITY_CHECK(bd);
+
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	err = _bd_flush_prog(bd);
+	if (err == NOR_OK && bd->_internal.u32EraseLen > 0){
+		err = _bd_flush_erase(bd);
+	}
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+	if (err != NOR_OK){
+		return err;
+	}
+
+	return NOR_Sync(bd->nor);
+}
+
+nor_err_e NOR_BD_Write(nor_bd_t *bd, uint32_t Block, uint8_t *pBuffer){
+	uint8_t pCmp[NOR_BD_CMP_BUFFER_LEN];
+	uint8_t Differ = 0, NeedErase = 0, Erased;
+	uint32_t Address, Offset, Chunk, i;
+	nor_err_e err;
+
+	_BD_SANITY_CHECK(bd);
+
+	if (pBuffer == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Block >= bd->config.u32BlockCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	Address = _bd_block_addr(bd, Block);
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	err = _bd_prepare(bd, Address, bd->config.u32BlockSize);
+	Erased = _bd_is_erased(bd, Block);
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+	if (err != NOR_OK){
+		return err;
+	}
+	if (Erased){
+		Differ = 1;
+	}
+	else{
+		for (Offset=0 ; Offset<bd->config.u32BlockSize && NeedErase == 0 ; Offset+=Chunk){
+			Chunk = bd->config.u32BlockSize - Offset;
+			if (Chunk > NOR_BD_CMP_BUFFER_LEN){
+				Chunk = NOR_BD_CMP_BUFFER_LEN;
+			}
+			err = NOR_ReadBytes(bd->nor, pCmp, Address + Offset, Chunk);
+			if (err != NOR_OK){
+				return err;
+			}
+			for (i=0 ; i<Chunk ; i++){
+				if (pCmp[i] != pBuffer[Offset + i]){
+					Differ = 1;
+					// a bit needs go from 0 to 1
+					if ((pCmp[i] & pBuffer[Offset + i]) != pBuffer[Offset + i]){
+						NeedErase = 1;
+						break;
+					}
+				}
+			}
+		}
+	}
+	if (Differ == 0){
+		return NOR_OK;
+	}
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	if (NeedErase){
+		// other pending erases go first, they can't be merged
+		if (bd->_internal.u32EraseLen > 0){
+			err = _bd_flush_erase(bd);
+		}
+		if (err == NOR_OK){
+			bd->_internal.u32EraseAddr = Address;
+			bd->_internal.u32EraseLen = bd->config.u32BlockSize;
+			err = _bd_flush_erase(bd);
+		}
+		if (err != NOR_OK){
+			_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+			return err;
+		}
+	}
+	_bd_invalidate_read(bd, Address, bd->config.u32BlockSize);
+	_bd_set_erased(bd, Block, 0);
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+	// after the erase, pages full of 0xFF doesn't need be programmed
+	for (Offset=0 ; Offset<bd->config.u32BlockSize ; Offset+=bd->nor->info.u16PageSize){
+		if (NeedErase || Erased){
+			for (i=0 ; i<bd->nor->info.u16PageSize && pBuffer[Offset + i] == 0xFF ; i++);
+			if (i == bd->nor->info.u16PageSize){
+				continue;
+			}
+		}
+		err = NOR_WriteBytes(bd->nor, &pBuffer[Offset], Address + Offset, bd->nor->info.u16PageSize);
+		if (err != NOR_OK){
+			break;
+		}
+		bd->stats.u32Progs++;
+	}
+	// a reader may have cached a line while the block was being programmed
+	_bd_lock(bd, NOR_LOCK_EXCLUSIVE);
+	_bd_invalidate_read(bd, Address, bd->config.u32BlockSize);
+	_bd_unlock(bd, NOR_LOCK_EXCLUSIVE);
+
+	return err;
+}
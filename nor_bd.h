@@ -0,0 +1,167 @@
+/*
+ * nor_bd.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Block device layer to mount filesystems like littlefs and FatFs over the
+ *  NOR driver. The hooks maps directly to the lfs_config read/prog/erase/sync
+ *  callbacks, and NOR_BD_Write implements the FatFs disk_write semantic,
+ *  with FF_MAX_SS equal to the block size.
+ *
+ *  Concurrency: with the optional shared/exclusive lock, NOR_BD_Read can be
+ *  called from any task, and reads served by the RAM (erased blocks, pending
+ *  erases and the read cache) run in parallel with a program or erase on the
+ *  bus. The writers (NOR_BD_Prog, NOR_BD_Erase, NOR_BD_Sync and NOR_BD_Write)
+ *  must be called by one task at a time, as the filesystems already do.
+ *
+ *  Example, for littlefs:
+ *    int lfs_read(const struct lfs_config *c, lfs_block_t b, lfs_off_t o, void *buf, lfs_size_t len){
+ *        return (NOR_BD_Read(c->context, b, o, buf, len) == NOR_OK) ? 0 : LFS_ERR_IO;
+ *    }
+ */
+
+#ifndef NOR_BD_H_
+#define NOR_BD_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+// Size of the stack buffer used to compare blocks on NOR_BD_Write
+#ifndef NOR_BD_CMP_BUFFER_LEN
+#define NOR_BD_CMP_BUFFER_LEN		64
+#endif
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		// first flash sector used by the block device
+		uint32_t u32FirstSector;
+		// filesystem block size, a multiple of the sector size
+		uint32_t u32BlockSize;
+		uint32_t u32BlockCount;
+		// optional read cache, the size must be a power of two
+		uint8_t *pReadCache;
+		uint16_t u16ReadCacheSize;
+		// optional prog cache, the size must be a power of two not greater than a page
+		uint8_t *pProgCache;
+		uint16_t u16ProgCacheSize;
+		// optional bitmap with (u32BlockCount + 7) / 8 bytes, to known erased blocks
+		uint8_t *pErasedMap;
+		// optional shared/exclusive lock, see the notes on the top
+		lock_fxn_t LockFxn;
+		lock_fxn_t UnlockFxn;
+		void *LockCtx;
+	}config;
+	// approximated when readers run in parallel
+	struct{
+		uint32_t u32CacheHits;
+		uint32_t u32BusReads;
+		uint32_t u32ErasedReads;
+		uint32_t u32Progs;
+		uint32_t u32Erases;
+		uint32_t u32ErasesSkipped;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		uint32_t u32ReadCacheAddr;
+		uint32_t u32ProgCacheAddr;
+		uint16_t u16ProgCacheLen;
+		uint32_t u32EraseAddr;
+		uint32_t u32EraseLen;
+	}_internal;
+}nor_bd_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Initialize the Block Device. Fill the nor and config fields before
+ * call this function.
+ *
+ * @param bd pointer to the Block Device instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter or the cache geometry was invalid
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ */
+nor_err_e NOR_BD_Init(nor_bd_t *bd);
+
+/**
+ * @brief Read data from a block. Blocks known as erased are served without
+ * access the bus, and small reads are served by the read cache.
+ *
+ * @param bd pointer to the Block Device instance
+ * @param Block block number
+ * @param Offset offset inside the block
+ * @param pBuffer buffer to receive the data
+ * @param Size number of bytes to read
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE the region exceeds the block
+ */
+nor_err_e NOR_BD_Read(nor_bd_t *bd, uint32_t Block, uint32_t Offset, uint8_t *pBuffer, uint32_t Size);
+
+/**
+ * @brief Program data into a block, that must be erased. Sequential small
+ * programs are coalesced on the prog cache, until a page boundary, a non
+ * sequential program or NOR_BD_Sync.
+ *
+ * @param bd pointer to the Block Device instance
+ * @param Block block number
+ * @param Offset offset inside the block
+ * @param pBuffer data to program
+ * @param Size number of bytes to program
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE the region exceeds the block
+ */
+nor_err_e NOR_BD_Prog(nor_bd_t *bd, uint32_t Block, uint32_t Offset, uint8_t *pBuffer, uint32_t Size);
+
+/**
+ * @brief Erase a block. The erase is deferred, and contiguous erases are merged
+ * and issued with the largest aligned erase command (64K, 32K or 4K) before the
+ * next access to the region, or on NOR_BD_Sync. Blocks known as erased are
+ * skipped.
+ *
+ * @param bd pointer to the Block Device instance
+ * @param Block block number
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE invalid block
+ */
+nor_err_e NOR_BD_Erase(nor_bd_t *bd, uint32_t Block);
+
+/**
+ * @brief Flush the prog cache and the pending erases, and wait the device
+ * complete the operations.
+ *
+ * @param bd pointer to the Block Device instance
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_BD_Sync(nor_bd_t *bd);
+
+/**
+ * @brief Rewrite an entire block, as FatFs disk_write expects. Blocks with the
+ * same content are skipped, and blocks where the new content only clears bits
+ * are programmed without erase.
+ *
+ * @param bd pointer to the Block Device instance
+ * @param Block block number
+ * @param pBuffer u32BlockSize bytes with the new content
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE invalid block
+ */
+nor_err_e NOR_BD_Write(nor_bd_t *bd, uint32_t Block, uint8_t *pBuffer);
+
+#endif /* NOR_BD_H_ */
@@ -0,0 +1,364 @@
+/*
+ * nor_cnt.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_cnt.h"
+
+/*
+ * Privates
+ */
+
+#define _CNT_SANITY_CHECK(c)		if (c == NULL)	return NOR_INVALID_PARAMS;					\
+									if (c->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+#define _FLAGS_MARKER				0x00
+
+/* Functions */
+
+static uint32_t _cnt_sector_addr(nor_t *nor, uint32_t FirstSector, uint32_t Sector){
+	return (FirstSector + Sector) * nor->info.u16SectorSize;
+}
+
+static uint8_t _cnt_read_header(nor_t *nor, uint32_t Address, uint32_t Magic, uint32_t *pValue){
+	nor_cnt_header_t header;
+
+	if (NOR_ReadBytes(nor, (uint8_t*)&header, Address, sizeof(header)) != NOR_OK){
+		return 0;
+	}
+	if (header.u32Magic != Magic || header.u32Value != ~header.u32ValueInv){
+		return 0;
+	}
+	*pValue = header.u32Value;
+	return 1;
+}
+
+static nor_err_e _cnt_program_header(nor_t *nor, uint32_t Address, uint32_t Magic, uint32_t Value){
+	nor_cnt_header_t header;
+
+	header.u32Magic = Magic;
+	header.u32Value = Value;
+	header.u32ValueInv = ~Value;
+	header.u32Reserved = 0xFFFFFFFF;
+
+	return NOR_WriteBytes(nor, (uint8_t*)&header, Address, sizeof(header));
+}
+
+static nor_err_e _cnt_write_header(nor_t *nor, uint32_t Address, uint32_t Magic, uint32_t Value){
+	nor_err_e err;
+
+	err = NOR_EraseAddress(nor, Address, NOR_ERASE_4K);
+	if (err != NOR_OK){
+		return err;
+	}
+
+	return _cnt_program_header(nor, Address, Magic, Value);
+}
+
+static uint8_t _cnt_find_newest(nor_t *nor, uint32_t FirstSector, uint32_t SectorCount, uint32_t Magic,
+		uint32_t *pSector, uint32_t *pValue){
+	uint32_t i, Value;
+	uint8_t found = 0;
+
+	for (i=0 ; i<SectorCount ; i++){
+		if (_cnt_read_header(nor, _cnt_sector_addr(nor, FirstSector, i), Magic, &Value) &&
+				(found == 0 || Value > *pValue)){
+			*pSector = i;
+			*pValue = Value;
+			found = 1;
+		}
+	}
+	return found;
+}
+
+static nor_err_e _flags_program_slot(nor_flags_t *flags, uint32_t Address){
+	uint8_t Marker = _FLAGS_MARKER;
+	nor_err_e err;
+
+	// the marker goes after the map, so a slot is valid only when complete
+	err = NOR_WriteBytes(flags->nor, flags->_internal.u8Map, Address, flags->_internal.u16SlotSize - 1);
+	if (err != NOR_OK){
+		return err;
+	}
+	return NOR_WriteBytes(flags->nor, &Marker, Address + flags->_internal.u16SlotSize - 1, sizeof(Marker));
+}
+
+static nor_err_e _flags_write_slot(nor_flags_t *flags){
+	uint32_t Address, Sector;
+	nor_err_e err;
+
+	if (flags->_internal.u16Slot >= flags->_internal.u16SlotsPerSector){
+		Sector = (flags->_internal.u32Sector + 1) % flags->config.u32SectorCount;
+		Address = _cnt_sector_addr(flags->nor, flags->config.u32FirstSector, Sector);
+		err = NOR_EraseAddress(flags->nor, Address, NOR_ERASE_4K);
+		if (err != NOR_OK){
+			return err;
+		}
+		// the header goes last, the full sector holds the flags until the
+		// first slot of the new one is complete
+		err = _flags_program_slot(flags, Address + sizeof(nor_cnt_header_t));
+		if (err != NOR_OK){
+			return err;
+		}
+		err = _cnt_program_header(flags->nor, Address, NOR_FLAGS_MAGIC, flags->_internal.u32Generation + 1);
+		if (err != NOR_OK){
+			return err;
+		}
+		flags->_internal.u32Sector = Sector;
+		flags->_internal.u32Generation++;
+		flags->_internal.u16Slot = 0;
+		return NOR_OK;
+	}
+	Address = _cnt_sector_addr(flags->nor, flags->config.u32FirstSector, flags->_internal.u32Sector) +
+			sizeof(nor_cnt_header_t) + (flags->_internal.u16Slot * flags->_internal.u16SlotSize);
+
+	return _flags_program_slot(flags, Address);
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_CNT_Init(nor_cnt_t *cnt){
+	uint32_t Address, lo, hi, mid, Used;
+	uint8_t Byte;
+	nor_err_e err;
+
+	if (cnt == NULL || cnt->nor == NULL || cnt->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			cnt->config.u32SectorCount < 2){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((cnt->config.u32FirstSector + cnt->config.u32SectorCount) > cnt->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	cnt->_internal.u16Initialized = 0;
+	cnt->_internal.u32Capacity = (cnt->nor->info.u16SectorSize - sizeof(nor_cnt_header_t)) * 8;
+	if (_cnt_find_newest(cnt->nor, cnt->config.u32FirstSector, cnt->config.u32SectorCount, NOR_CNT_MAGIC,
+			&cnt->_internal.u32Sector, &cnt->_internal.u32Base) == 0){
+		cnt->_internal.u32Sector = 0;
+		cnt->_internal.u32Base = 0;
+		err = _cnt_write_header(cnt->nor, _cnt_sector_addr(cnt->nor, cnt->config.u32FirstSector, 0), NOR_CNT_MAGIC, 0);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	Address = _cnt_sector_addr(cnt->nor, cnt->config.u32FirstSector, cnt->_internal.u32Sector) + sizeof(nor_cnt_header_t);
+	// the used bytes are 0x00, search the first one that isn't
+	lo = 0;
+	hi = cnt->_internal.u32Capacity / 8;
+	while (lo < hi){
+		mid = (lo + hi) / 2;
+		err = NOR_ReadBytes(cnt->nor, &Byte, Address + mid, sizeof(Byte));
+		if (err != NOR_OK){
+			return err;
+		}
+		if (Byte == 0x00){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	Used = lo * 8;
+	if (lo < (cnt->_internal.u32Capacity / 8)){
+		err = NOR_ReadBytes(cnt->nor, &Byte, Address + lo, sizeof(Byte));
+		if (err != NOR_OK){
+			return err;
+		}
+		// the bits are cleared from the LSB
+		while ((Byte & 1) == 0){
+			Byte >>= 1;
+			Used++;
+		}
+	}
+	cnt->_internal.u32Bits = Used;
+	cnt->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_CNT_Increment(nor_cnt_t *cnt){
+	uint32_t Address, Sector, Base;
+	uint8_t Byte;
+	nor_err_e err;
+
+	_CNT_SANITY_CHECK(cnt);
+
+	if (cnt->_internal.u32Bits >= cnt->_internal.u32Capacity){
+		Sector = (cnt->_internal.u32Sector + 1) % cnt->config.u32SectorCount;
+		Base = cnt->_internal.u32Base + cnt->_internal.u32Bits;
+		err = _cnt_write_header(cnt->nor, _cnt_sector_addr(cnt->nor, cnt->config.u32FirstSector, Sector),
+				NOR_CNT_MAGIC, Base);
+		if (err != NOR_OK){
+			// the full sector still holds the value, the rollover is retried
+			return err;
+		}
+		cnt->_internal.u32Sector = Sector;
+		cnt->_internal.u32Base = Base;
+		cnt->_internal.u32Bits = 0;
+	}
+	Address = _cnt_sector_addr(cnt->nor, cnt->config.u32FirstSector, cnt->_internal.u32Sector) +
+			sizeof(nor_cnt_header_t) + (cnt->_internal.u32Bits / 8);
+	Byte = (uint8_t)(0xFF << ((cnt->_internal.u32Bits % 8) + 1));
+	err = NOR_WriteBytes(cnt->nor, &Byte, Address, sizeof(Byte));
+	if (err != NOR_OK){
+		return err;
+	}
+	cnt->_internal.u32Bits++;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_CNT_Get(nor_cnt_t *cnt, uint32_t *pValue){
+	_CNT_SANITY_CHECK(cnt);
+
+	if (pValue == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	*pValue = cnt->_internal.u32Base + cnt->_internal.u32Bits;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_FLAGS_Init(nor_flags_t *flags){
+	uint8_t Slot[(NOR_FLAGS_MAX + 7) / 8];
+	uint32_t Address, lo, hi, mid, i, Next;
+	uint8_t Marker;
+	nor_err_e err;
+
+	if (flags == NULL || flags->nor == NULL || flags->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			flags->config.u32SectorCount < 2 || flags->config.u16NumFlags == 0 ||
+			flags->config.u16NumFlags > NOR_FLAGS_MAX){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((flags->config.u32FirstSector + flags->config.u32SectorCount) > flags->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	flags->_internal.u16Initialized = 0;
+	flags->_internal.u16SlotSize = ((flags->config.u16NumFlags + 7) / 8) + 1;
+	flags->_internal.u16SlotsPerSector = (flags->nor->info.u16SectorSize - sizeof(nor_cnt_header_t)) / flags->_internal.u16SlotSize;
+	memset(flags->_internal.u8Map, 0xFF, sizeof(flags->_internal.u8Map));
+	if (_cnt_find_newest(flags->nor, flags->config.u32FirstSector, flags->config.u32SectorCount, NOR_FLAGS_MAGIC,
+			&flags->_internal.u32Sector, &flags->_internal.u32Generation) == 0){
+		flags->_internal.u32Sector = 0;
+		flags->_internal.u32Generation = 0;
+		err = _cnt_write_header(flags->nor, _cnt_sector_addr(flags->nor, flags->config.u32FirstSector, 0), NOR_FLAGS_MAGIC, 0);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	Address = _cnt_sector_addr(flags->nor, flags->config.u32FirstSector, flags->_internal.u32Sector) + sizeof(nor_cnt_header_t);
+	// the slots are written in order, search the first without marker
+	lo = 0;
+	hi = flags->_internal.u16SlotsPerSector;
+	while (lo < hi){
+		mid = (lo + hi) / 2;
+		err = NOR_ReadBytes(flags->nor, &Marker, Address + (mid * flags->_internal.u16SlotSize) + flags->_internal.u16SlotSize - 1, sizeof(Marker));
+		if (err != NOR_OK){
+			return err;
+		}
+		if (Marker == _FLAGS_MARKER){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	if (lo > 0){
+		// the last complete copy holds the flags
+		err = NOR_ReadBytes(flags->nor, flags->_internal.u8Map, Address + ((lo - 1) * flags->_internal.u16SlotSize), flags->_internal.u16SlotSize - 1);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	Next = lo;
+	if (Next < flags->_internal.u16SlotsPerSector){
+		// a copy interrupted by a power loss leaves a dirty slot without marker
+		err = NOR_ReadBytes(flags->nor, Slot, Address + (Next * flags->_internal.u16SlotSize), flags->_internal.u16SlotSize - 1);
+		if (err != NOR_OK){
+			return err;
+		}
+		for (i=0 ; i<(uint32_t)(flags->_internal.u16SlotSize - 1) ; i++){
+			if (Slot[i] != 0xFF){
+				Next++;
+				break;
+			}
+		}
+	}
+	if (lo == 0 || Next != lo){
+		flags->_internal.u16Slot = Next;
+		err = _flags_write_slot(flags);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	else{
+		flags->_internal.u16Slot = lo - 1;
+	}
+	flags->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_FLAGS_Set(nor_flags_t *flags, uint16_t Flag){
+	uint32_t Address;
+	uint8_t Mask;
+
+	_CNT_SANITY_CHECK(flags);
+
+	if (Flag >= flags->config.u16NumFlags){
+		return NOR_INVALID_PARAMS;
+	}
+	Mask = (1 << (Flag % 8));
+	if ((flags->_internal.u8Map[Flag / 8] & Mask) == 0){
+		return NOR_OK;
+	}
+	flags->_internal.u8Map[Flag / 8] &= ~Mask;
+	Address = _cnt_sector_addr(flags->nor, flags->config.u32FirstSector, flags->_internal.u32Sector) +
+			sizeof(nor_cnt_header_t) + (flags->_internal.u16Slot * flags->_internal.u16SlotSize) + (Flag / 8);
+
+	return NOR_WriteBytes(flags->nor, &flags->_internal.u8Map[Flag / 8], Address, sizeof(uint8_t));
+}
+
+nor_err_e NOR_FLAGS_Clear(nor_flags_t *flags, uint16_t Flag){
+	uint8_t Mask;
+
+	_CNT_SANITY_CHECK(flags);
+
+	if (Flag >= flags->config.u16NumFlags){
+		return NOR_INVALID_PARAMS;
+	}
+	Mask = (1 << (Flag % 8));
+	if (flags->_internal.u8Map[Flag / 8] & Mask){
+		return NOR_OK;
+	}
+	flags->_internal.u8Map[Flag / 8] |= Mask;
+	flags->_internal.u16Slot++;
+
+	return _flags_write_slot(flags);
+}
+
+nor_err_e NOR_FLAGS_ClearAll(nor_flags_t *flags){
+	_CNT_SANITY_CHECK(flags);
+
+	memset(flags->_internal.u8Map, 0xFF, sizeof(flags->_internal.u8Map));
+	flags->_internal.u16Slot++;
+
+	return _flags_write_slot(flags);
+}
+
+nor_err_e NOR_FLAGS_Get(nor_flags_t *flags, uint16_t Flag, uint8_t *pIsSet){
+	_CNT_SANITY_CHECK(flags);
+
+	if (Flag >= flags->config.u16NumFlags || pIsSet == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	*pIsSet = ((flags->_internal.u8Map[Flag / 8] >> (Flag % 8)) & 1) ? 0 : 1;
+
+	return NOR_OK;
+}
@@ -0,0 +1,179 @@
+/*
+ * nor_cnt.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Erase free counters and flags. The NOR can clear bits without an erase,
+ *  so a counter is stored as a run of cleared bits (thermometer code) and
+ *  every increment is a single byte Page Program. A sector is erased only
+ *  when the region of the counter is exhausted, giving ~32K increments per
+ *  erase on 4K sectors.
+ */
+
+#ifndef NOR_CNT_H_
+#define NOR_CNT_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_CNT_MAGIC				0x544E434E	// "NCNT"
+#define NOR_FLAGS_MAGIC				0x474C464E	// "NFLG"
+
+// Maximum number of flags of a nor_flags_t instance
+#ifndef NOR_FLAGS_MAX
+#define NOR_FLAGS_MAX				64
+#endif
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	uint32_t u32Magic;
+	uint32_t u32Value;
+	uint32_t u32ValueInv;
+	uint32_t u32Reserved;
+}nor_cnt_header_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+	}config;
+	struct{
+		uint16_t u16Initialized;
+		uint32_t u32Sector;
+		uint32_t u32Base;
+		uint32_t u32Bits;
+		uint32_t u32Capacity;
+	}_internal;
+}nor_cnt_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+		uint16_t u16NumFlags;
+	}config;
+	struct{
+		uint16_t u16Initialized;
+		uint32_t u32Sector;
+		uint32_t u32Generation;
+		uint16_t u16Slot;
+		uint16_t u16SlotSize;
+		uint16_t u16SlotsPerSector;
+		// flag set is stored as bit cleared, like on the flash
+		uint8_t u8Map[(NOR_FLAGS_MAX + 7) / 8];
+	}_internal;
+}nor_flags_t;
+
+/**
+ * Publics
+ */
+
+/* **********************************
+ * Counter Functions
+ * **********************************/
+
+/**
+ * @brief Mount the counter stored on a region of sectors, formatting the
+ * region when no counter was found. Fill the nor and config fields before
+ * call this function.
+ *
+ * @param cnt pointer to the counter instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid, or SectorCount < 2
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ * @return NOR_FAIL failed to format the region
+ */
+nor_err_e NOR_CNT_Init(nor_cnt_t *cnt);
+
+/**
+ * @brief Increment the counter, programming a single byte. When the active
+ * sector is full, the next sector is erased and receives the value.
+ *
+ * @param cnt pointer to the counter instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_CNT_Init first
+ * @return NOR_FAIL failed to program or erase
+ */
+nor_err_e NOR_CNT_Increment(nor_cnt_t *cnt);
+
+/**
+ * @brief Get the value of the counter, without access the flash.
+ *
+ * @param cnt pointer to the counter instance
+ * @param pValue the counter value
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_CNT_Init first
+ */
+nor_err_e NOR_CNT_Get(nor_cnt_t *cnt, uint32_t *pValue);
+
+/* **********************************
+ * Flags Functions
+ * **********************************/
+
+/**
+ * @brief Mount the flags stored on a region of sectors, formatting the
+ * region when no flags were found. Fill the nor and config fields before
+ * call this function.
+ *
+ * @param flags pointer to the flags instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid, SectorCount < 2 or too
+ * many flags
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ * @return NOR_FAIL failed to format the region
+ */
+nor_err_e NOR_FLAGS_Init(nor_flags_t *flags);
+
+/**
+ * @brief Set a flag. Programs a single byte, without erase.
+ *
+ * @param flags pointer to the flags instance
+ * @param Flag flag index
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_FLAGS_Set(nor_flags_t *flags, uint16_t Flag);
+
+/**
+ * @brief Clear a flag. Bits can't be set without an erase, so a new copy of
+ * the flags is appended, and a sector is erased only when the region is full.
+ *
+ * @param flags pointer to the flags instance
+ * @param Flag flag index
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_FLAGS_Clear(nor_flags_t *flags, uint16_t Flag);
+
+/**
+ * @brief Clear all flags, appending a new copy of the flags.
+ *
+ * @param flags pointer to the flags instance
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_FLAGS_ClearAll(nor_flags_t *flags);
+
+/**
+ * @brief Get a flag, without access the flash.
+ *
+ * @param flags pointer to the flags instance
+ * @param Flag flag index
+ * @param pIsSet receives 1 when the flag is set, 0 otherwise
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_FLAGS_Get(nor_flags_t *flags, uint16_t Flag, uint8_t *pIsSet);
+
+#endif /* NOR_CNT_H_ */
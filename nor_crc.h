@@ -0,0 +1,30 @@
+/*
+ * nor_crc.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  CRC32 (IEEE 802.3, the same of zlib), used to verify the data streamed
+ *  from the device. Uses slicing-by-8 tables, or a single table when
+ *  NOR_CRC32_BYTEWISE is defined, to save 7 KB of flash. On host builds
+ *  with PCLMUL and SSE4.1 enabled, large buffers are folded with carry-less
+ *  multiplication.
+ */
+
+#ifndef NOR_CRC_H_
+#define NOR_CRC_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Update the CRC32 with more data. Start with Crc equal to 0, and
+ * pass the returned value to the next call.
+ *
+ * @param Crc the CRC of the previous data, 0 at start
+ * @param pBuffer data
+ * @param Len size of data
+ * @return the CRC32 of all data until now
+ */
+uint32_t NOR_CRC32(uint32_t Crc, const uint8_t *pBuffer, uint32_t Len);
+
+#endif /* NOR_CRC_H_ */
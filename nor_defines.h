@@ -46,9 +46,19 @@
 #define NOR_READ_SR2				0x35
 #define NOR_WRITE_SR2				0x31
 
+#define SR2_QE_BIT					(1<<1)
+#define SR2_SUS_BIT					(1<<7)
+
 #define NOR_READ_SR3				0x15
 #define NOR_WRITE_SR3				0x11
 
+// Security register of the MXIC devices, with the fail flags of the last
+// program or erase
+#define NOR_READ_SCUR_MXIC			0x2B
+
+#define SCUR_PFAIL_BIT				(1<<5)
+#define SCUR_EFAIL_BIT				(1<<6)
+
 #define NOR_READ_SFDP_REG			0x5A
 #define NOR_ERASE_SEC_REG			0x44
 #define NOR_PROGRAM_SEC_REG			0x42
@@ -66,6 +76,16 @@
 #define NOR_ENABLE_RESET			0x66
 #define NOR_DEVICE_RESET			0x99
 
+// QPI (4-4-4) mode, the opcodes change with the manufacturer
+#define NOR_ENTER_QPI_WINBOND		0x38
+#define NOR_EXIT_QPI_WINBOND		0xFF
+#define NOR_ENTER_QPI_MXIC			0x35
+#define NOR_EXIT_QPI_MXIC			0xF5
+
+// Dummy clocks of the Fast Read on QPI mode, with the default read parameters
+#define NOR_QPI_DUMMY_WINBOND		2
+#define NOR_QPI_DUMMY_MXIC			4
+
 // Flash Memory Global parameters
 #define NOR_PAGE_SIZE				0x100
 #define NOR_SECTOR_SIZE				0x1000
@@ -76,6 +96,9 @@
 #define NOR_EXPECT_64K_ERASE_TIME	25000
 #define NOR_EXPECT_ERASE_CHIP		160000
 #define NOR_EXPECT_PAGE_PROG_TIME	5000
+#define NOR_EXPECT_SUSPEND_TIME		1
+#define NOR_EXPECT_WRITE_SR_TIME	15
+#define NOR_EXPECT_RESET_US			30
 
 
 #endif /* FLASH_NOR_NOR_DEFINES_H_ */
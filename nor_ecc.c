@@ -0,0 +1,280 @@
+/*
+ * nor_ecc.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_ecc.h"
+
+/*
+ * Privates
+ */
+
+#define _ECC_SANITY_CHECK(e)		if (e == NULL)	return NOR_INVALID_PARAMS;					\
+									if (e->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+// parity of a nibble, as a 16 bits table
+#define _ECC_NIBBLE_PARITY			0x6996
+#define _ECC_CODE_BYTES				3
+
+/* Functions */
+
+static uint8_t _ecc_parity(uint8_t b){
+	return (_ECC_NIBBLE_PARITY >> ((b ^ (b >> 4)) & 0x0F)) & 1;
+}
+
+static uint32_t _ecc_sector_addr(nor_ecc_t *ecc, uint32_t Sector){
+	return (ecc->config.u32FirstSector + Sector) * ecc->nor->info.u16SectorSize;
+}
+
+static uint32_t _ecc_code_addr(nor_ecc_t *ecc, uint32_t Sector, uint32_t Chunk){
+	return _ecc_sector_addr(ecc, Sector) + ecc->_internal.u16CodeOffset + (Chunk * NOR_ECC_CODE_SIZE);
+}
+
+static nor_err_e _ecc_decode(nor_ecc_t *ecc, uint8_t *pData, uint8_t *pStored){
+	uint8_t Calc[_ECC_CODE_BYTES];
+
+	ecc->stats.u32ChunksRead++;
+	NOR_ECC_Calculate(pData, Calc);
+	switch (NOR_ECC_Correct(pData, pStored, Calc)){
+	case NOR_ECC_CLEAN:
+		return NOR_OK;
+	case NOR_ECC_CORRECTED:
+		ecc->stats.u32Corrected++;
+		return NOR_OK;
+	default:
+		ecc->stats.u32Uncorrectable++;
+		return NOR_ECC_UNCORRECTABLE;
+	}
+}
+
+/*
+ * Publics
+ */
+
+void NOR_ECC_Calculate(const uint8_t *pData, uint8_t *pCode){
+	uint32_t i, w, t, x = 0;
+	uint8_t Line = 0, Col, p;
+
+	/*
+	 * The line parity is the XOR of the indexes of the bytes with odd parity.
+	 * The bytes are processed four at a time, folding each byte into its low
+	 * nibble, and the parity of the nibble comes from a 16 bits table.
+	 */
+	for (i=0 ; i<NOR_ECC_CHUNK_SIZE ; i+=4){
+		w = (uint32_t)pData[i] | ((uint32_t)pData[i+1] << 8) |
+				((uint32_t)pData[i+2] << 16) | ((uint32_t)pData[i+3] << 24);
+		x ^= w;
+		t = w ^ (w >> 4);
+		p = (_ECC_NIBBLE_PARITY >> (t & 0x0F)) & 1;
+		Line ^= (uint8_t)(i & -p);
+		p = (_ECC_NIBBLE_PARITY >> ((t >> 8) & 0x0F)) & 1;
+		Line ^= (uint8_t)((i + 1) & -p);
+		p = (_ECC_NIBBLE_PARITY >> ((t >> 16) & 0x0F)) & 1;
+		Line ^= (uint8_t)((i + 2) & -p);
+		p = (_ECC_NIBBLE_PARITY >> ((t >> 24) & 0x0F)) & 1;
+		Line ^= (uint8_t)((i + 3) & -p);
+	}
+	// XOR of all bytes, for the column parity
+	x ^= (x >> 16);
+	x ^= (x >> 8);
+	x &= 0xFF;
+	Col = _ecc_parity(x & 0x55) | (_ecc_parity(x & 0xAA) << 1) |
+			(_ecc_parity(x & 0x33) << 2) | (_ecc_parity(x & 0xCC) << 3) |
+			(_ecc_parity(x & 0x0F) << 4) | (_ecc_parity(x & 0xF0) << 5);
+	pCode[0] = ~Line;
+	// the even line parity is the odd one complemented, when the count of odd bytes is odd
+	pCode[1] = ~(Line ^ (_ecc_parity(x) ? 0xFF : 0x00));
+	pCode[2] = ~Col;
+}
+
+nor_ecc_res_e NOR_ECC_Correct(uint8_t *pData, const uint8_t *pStored, const uint8_t *pCalc){
+	uint8_t s0, s1, s2, Bit;
+	uint32_t Bits;
+
+	s0 = pStored[0] ^ pCalc[0];
+	s1 = pStored[1] ^ pCalc[1];
+	s2 = pStored[2] ^ pCalc[2];
+	if ((s0 | s1 | s2) == 0){
+		return NOR_ECC_CLEAN;
+	}
+	// a data bit flip toggles one bit of every parity pair
+	if ((s0 ^ s1) == 0xFF && ((s2 ^ (s2 >> 1)) & 0x15) == 0x15){
+		Bit = ((s2 >> 1) & 0x01) | ((s2 >> 2) & 0x02) | ((s2 >> 3) & 0x04);
+		pData[s0] ^= (1 << Bit);
+		return NOR_ECC_CORRECTED;
+	}
+	// a single bit flip on the code itself
+	Bits = ((uint32_t)s0 << 16) | ((uint32_t)s1 << 8) | s2;
+	if ((Bits & (Bits - 1)) == 0){
+		return NOR_ECC_CORRECTED;
+	}
+
+	return NOR_ECC_FAILED;
+}
+
+nor_err_e NOR_ECC_Init(nor_ecc_t *ecc){
+	if (ecc == NULL || ecc->nor == NULL || ecc->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			ecc->config.u32SectorCount == 0 || ecc->nor->info.u16SectorSize != NOR_SECTOR_SIZE){
+		return NOR_INVALID_PARAMS;
+	}
+	ecc->_internal.u16Chunks = (ecc->config.u16ChunksPerSector != 0) ? ecc->config.u16ChunksPerSector : NOR_ECC_CHUNKS_PER_SECTOR;
+	ecc->_internal.u32SectorData = ecc->_internal.u16Chunks * NOR_ECC_CHUNK_SIZE;
+	ecc->_internal.u16CodeOffset = (ecc->config.u16CodeOffset != 0) ? ecc->config.u16CodeOffset : ecc->_internal.u32SectorData;
+	// the codes can't overlap the data, and both fit on the sector
+	if (ecc->_internal.u16Chunks > NOR_ECC_CHUNKS_PER_SECTOR || ecc->_internal.u16CodeOffset < ecc->_internal.u32SectorData ||
+			(ecc->_internal.u16CodeOffset + (ecc->_internal.u16Chunks * NOR_ECC_CODE_SIZE)) > NOR_SECTOR_SIZE){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((ecc->config.u32FirstSector + ecc->config.u32SectorCount) > ecc->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	ecc->_internal.u32Size = ecc->config.u32SectorCount * ecc->_internal.u32SectorData;
+	memset(&ecc->stats, 0, sizeof(ecc->stats));
+	ecc->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+uint32_t NOR_ECC_GetSize(nor_ecc_t *ecc){
+	if (ecc == NULL || ecc->_internal.u16Initialized != NOR_INITIALIZED_FLAG){
+		return 0;
+	}
+	return ecc->_internal.u32Size;
+}
+
+nor_err_e NOR_ECC_EraseSector(nor_ecc_t *ecc, uint32_t Sector){
+	_ECC_SANITY_CHECK(ecc);
+
+	if (Sector >= ecc->config.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	return NOR_EraseAddress(ecc->nor, _ecc_sector_addr(ecc, Sector), NOR_ERASE_4K);
+}
+
+nor_err_e NOR_ECC_Write(nor_ecc_t *ecc, uint32_t Address, uint8_t *pBuffer, uint32_t Len){
+	uint8_t Codes[NOR_ECC_CHUNKS_PER_SECTOR * NOR_ECC_CODE_SIZE];
+	uint32_t Sector, Chunk, Count, i;
+	nor_err_e err;
+
+	_ECC_SANITY_CHECK(ecc);
+
+	if (pBuffer == NULL || Len == 0 || (Address % NOR_ECC_CHUNK_SIZE) != 0 || (Len % NOR_ECC_CHUNK_SIZE) != 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((Address + Len) > ecc->_internal.u32Size){
+		return NOR_OUT_OF_RANGE;
+	}
+	while (Len > 0){
+		Sector = Address / ecc->_internal.u32SectorData;
+		Chunk = (Address % ecc->_internal.u32SectorData) / NOR_ECC_CHUNK_SIZE;
+		Count = ecc->_internal.u16Chunks - Chunk;
+		if (Count > (Len / NOR_ECC_CHUNK_SIZE)){
+			Count = Len / NOR_ECC_CHUNK_SIZE;
+		}
+		// the codes can't be programmed twice
+		err = NOR_ReadBytes(ecc->nor, Codes, _ecc_code_addr(ecc, Sector, Chunk), Count * NOR_ECC_CODE_SIZE);
+		if (err != NOR_OK){
+			return err;
+		}
+		for (i=0 ; i<(Count * NOR_ECC_CODE_SIZE) ; i++){
+			if (Codes[i] != 0xFF){
+				return NOR_REGIONS_IS_NOT_EMPTY;
+			}
+		}
+		err = NOR_WriteBytes(ecc->nor, pBuffer, _ecc_sector_addr(ecc, Sector) + (Chunk * NOR_ECC_CHUNK_SIZE),
+				Count * NOR_ECC_CHUNK_SIZE);
+		if (err != NOR_OK){
+			return err;
+		}
+		// the codes are programmed after the data, a torn write is detected as uncorrectable
+		for (i=0 ; i<Count ; i++){
+			NOR_ECC_Calculate(pBuffer + (i * NOR_ECC_CHUNK_SIZE), &Codes[i * NOR_ECC_CODE_SIZE]);
+		}
+		err = NOR_WriteBytes(ecc->nor, Codes, _ecc_code_addr(ecc, Sector, Chunk), Count * NOR_ECC_CODE_SIZE);
+		if (err != NOR_OK){
+			return err;
+		}
+		pBuffer += Count * NOR_ECC_CHUNK_SIZE;
+		Address += Count * NOR_ECC_CHUNK_SIZE;
+		Len -= Count * NOR_ECC_CHUNK_SIZE;
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_ECC_Read(nor_ecc_t *ecc, uint32_t Address, uint8_t *pBuffer, uint32_t Len){
+	uint8_t Codes[NOR_ECC_CHUNKS_PER_SECTOR * NOR_ECC_CODE_SIZE];
+	uint8_t Chunk[NOR_ECC_CHUNK_SIZE];
+	uint32_t Sector, First, Last, Base, Offset, Size, Full, i;
+	nor_err_e err, result = NOR_OK;
+
+	_ECC_SANITY_CHECK(ecc);
+
+	if (pBuffer == NULL || Len == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((Address + Len) > ecc->_internal.u32Size){
+		return NOR_OUT_OF_RANGE;
+	}
+	while (Len > 0){
+		Sector = Address / ecc->_internal.u32SectorData;
+		Base = Sector * ecc->_internal.u32SectorData;
+		First = (Address - Base) / NOR_ECC_CHUNK_SIZE;
+		Size = Base + ecc->_internal.u32SectorData - Address;
+		if (Size > Len){
+			Size = Len;
+		}
+		Last = (Address + Size - 1 - Base) / NOR_ECC_CHUNK_SIZE;
+		err = NOR_ReadBytes(ecc->nor, Codes, _ecc_code_addr(ecc, Sector, First), (Last - First + 1) * NOR_ECC_CODE_SIZE);
+		if (err != NOR_OK){
+			return err;
+		}
+		for (i=First ; i<=Last ; i+=Full){
+			Offset = (Address - Base) % NOR_ECC_CHUNK_SIZE;
+			if (Offset != 0 || Len < NOR_ECC_CHUNK_SIZE){
+				// partial chunk, decoded on the stack
+				Full = 1;
+				Size = NOR_ECC_CHUNK_SIZE - Offset;
+				if (Size > Len){
+					Size = Len;
+				}
+				err = NOR_ReadBytes(ecc->nor, Chunk, _ecc_sector_addr(ecc, Sector) + (i * NOR_ECC_CHUNK_SIZE), NOR_ECC_CHUNK_SIZE);
+				if (err != NOR_OK){
+					return err;
+				}
+				if (_ecc_decode(ecc, Chunk, &Codes[(i - First) * NOR_ECC_CODE_SIZE]) != NOR_OK){
+					result = NOR_ECC_UNCORRECTABLE;
+				}
+				memcpy(pBuffer, &Chunk[Offset], Size);
+			}
+			else{
+				// the following entire chunks are read at once, and decoded in place
+				Full = (Len / NOR_ECC_CHUNK_SIZE);
+				if (Full > (Last - i + 1)){
+					Full = Last - i + 1;
+				}
+				Size = Full * NOR_ECC_CHUNK_SIZE;
+				err = NOR_ReadBytes(ecc->nor, pBuffer, _ecc_sector_addr(ecc, Sector) + (i * NOR_ECC_CHUNK_SIZE), Size);
+				if (err != NOR_OK){
+					return err;
+				}
+				for (Offset=0 ; Offset<Full ; Offset++){
+					if (_ecc_decode(ecc, pBuffer + (Offset * NOR_ECC_CHUNK_SIZE),
+							&Codes[(i + Offset - First) * NOR_ECC_CODE_SIZE]) != NOR_OK){
+						result = NOR_ECC_UNCORRECTABLE;
+					}
+				}
+			}
+			pBuffer += Size;
+			Address += Size;
+			Len -= Size;
+		}
+	}
+
+	return result;
+}
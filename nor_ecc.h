@@ -0,0 +1,181 @@
+/*
+ * nor_ecc.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Software ECC for parts that develop bit flips after retention stress. Each
+ *  256 bytes chunk has a 22 bits Hamming code (16 line parity bits and 6 column
+ *  parity bits, like the SmartMedia ECC), correcting one bit and detecting two
+ *  bits errors per chunk.
+ *
+ *  The codes are stored out of band, by default on the last page of every
+ *  sector:
+ *
+ *    | chunk 0 | chunk 1 | ... | chunk 14 | code 0 | code 1 | ... | code 14 |
+ *
+ *  so each sector holds NOR_ECC_SECTOR_DATA bytes of data, and the codes are
+ *  erased together with the data. Codes are stored inverted, so an erased
+ *  chunk is a valid chunk.
+ *
+ *  The layout can be changed on the config: fewer chunks per sector, and the
+ *  codes on any offset after the data, leaving the rest of the sector to the
+ *  application. The data always starts on the sector, and the sectors are the
+ *  4K erase units, the devices with other sector sizes are not supported.
+ */
+
+#ifndef NOR_ECC_H_
+#define NOR_ECC_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_ECC_CHUNK_SIZE			256
+// 3 bytes of code and one reserved byte
+#define NOR_ECC_CODE_SIZE			4
+#define NOR_ECC_CHUNKS_PER_SECTOR	((NOR_SECTOR_SIZE / NOR_ECC_CHUNK_SIZE) - 1)
+#define NOR_ECC_SECTOR_DATA			(NOR_ECC_CHUNKS_PER_SECTOR * NOR_ECC_CHUNK_SIZE)
+
+/**
+ * Enumerates
+ */
+
+typedef enum{
+	NOR_ECC_CLEAN,    /**< no errors on the chunk */
+	NOR_ECC_CORRECTED,/**< a single bit error was corrected */
+	NOR_ECC_FAILED    /**< uncorrectable error */
+}nor_ecc_res_e;
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+		// Optional, chunks of data per sector, up to NOR_ECC_CHUNKS_PER_SECTOR.
+		// 0 uses NOR_ECC_CHUNKS_PER_SECTOR
+		uint16_t u16ChunksPerSector;
+		// Optional, offset of the codes on the sector, after the data. 0 places
+		// them right after the data
+		uint16_t u16CodeOffset;
+	}config;
+	struct{
+		uint32_t u32ChunksRead;
+		uint32_t u32Corrected;
+		uint32_t u32Uncorrectable;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		uint16_t u16Chunks;
+		uint16_t u16CodeOffset;
+		uint32_t u32SectorData;
+		uint32_t u32Size;
+	}_internal;
+}nor_ecc_t;
+
+/**
+ * Publics
+ */
+
+/* **********************************
+ * Codec Functions
+ * **********************************/
+
+/**
+ * @brief Calculate the code of a chunk, already inverted as stored on the flash.
+ *
+ * @param pData NOR_ECC_CHUNK_SIZE bytes of data
+ * @param pCode receives 3 bytes of code
+ */
+void NOR_ECC_Calculate(const uint8_t *pData, uint8_t *pCode);
+
+/**
+ * @brief Check a chunk against the stored code, correcting a single bit error.
+ *
+ * @param pData NOR_ECC_CHUNK_SIZE bytes of data, corrected in place
+ * @param pStored the 3 bytes of code read from the flash
+ * @param pCalc the 3 bytes of code calculated from pData
+ * @return NOR_ECC_CLEAN no errors
+ * @return NOR_ECC_CORRECTED one bit of the data or of the code was wrong
+ * @return NOR_ECC_FAILED more than one bit is wrong
+ */
+nor_ecc_res_e NOR_ECC_Correct(uint8_t *pData, const uint8_t *pStored, const uint8_t *pCalc);
+
+/* **********************************
+ * Region Functions
+ * **********************************/
+
+/**
+ * @brief Initialize the ECC region. Fill the nor and config fields before call
+ * this function.
+ *
+ * @param ecc pointer to the ECC instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid, the layout doesn't fit
+ * on the sector, or the sector size of the device isn't NOR_SECTOR_SIZE
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ */
+nor_err_e NOR_ECC_Init(nor_ecc_t *ecc);
+
+/**
+ * @brief Get the number of data bytes of the region.
+ *
+ * @param ecc pointer to the ECC instance
+ * @return the size, or 0 if not initialized
+ */
+uint32_t NOR_ECC_GetSize(nor_ecc_t *ecc);
+
+/**
+ * @brief Erase a sector of the region, with the codes of its chunks.
+ *
+ * @param ecc pointer to the ECC instance
+ * @param Sector sector of the region, where the data address is Sector times
+ * the chunks per sector times NOR_ECC_CHUNK_SIZE
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE invalid sector
+ */
+nor_err_e NOR_ECC_EraseSector(nor_ecc_t *ecc, uint32_t Sector);
+
+/**
+ * @brief Program entire chunks, with their codes. Each chunk can be programmed
+ * only once after the erase.
+ *
+ * @param ecc pointer to the ECC instance
+ * @param Address data address, multiple of NOR_ECC_CHUNK_SIZE
+ * @param pBuffer data to program
+ * @param Len number of bytes, multiple of NOR_ECC_CHUNK_SIZE
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS unaligned address or length
+ * @return NOR_OUT_OF_RANGE the region exceeds the ECC region
+ * @return NOR_REGIONS_IS_NOT_EMPTY a chunk was already programmed
+ */
+nor_err_e NOR_ECC_Write(nor_ecc_t *ecc, uint32_t Address, uint8_t *pBuffer, uint32_t Len);
+
+/**
+ * @brief Read data, correcting single bit errors. Any address and length are
+ * accepted, the chunks partially read are decoded on a stack buffer.
+ *
+ * @param ecc pointer to the ECC instance
+ * @param Address data address
+ * @param pBuffer buffer to receive the data
+ * @param Len number of bytes
+ * @return NOR_OK everything was ok, maybe with corrected bits
+ * @return NOR_OUT_OF_RANGE the region exceeds the ECC region
+ * @return NOR_ECC_UNCORRECTABLE at least one chunk has uncorrectable errors, the
+ * other chunks are read anyway
+ */
+nor_err_e NOR_ECC_Read(nor_ecc_t *ecc, uint32_t Address, uint8_t *pBuffer, uint32_t Len);
+
+#endif /* NOR_ECC_H_ */
@@ -0,0 +1,215 @@
+/*
+ * nor_img.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_img.h"
+
+/*
+ * Privates
+ */
+
+#define _IMG_FNV_PRIME				0x01000193
+
+typedef struct{
+	uint8_t *pImage;
+}_img_buffer_ctx_t;
+
+/* Functions */
+
+static nor_err_e _img_buffer_src(void *pCtx, uint32_t Offset, uint8_t *pBuffer, uint32_t Len){
+	_img_buffer_ctx_t *ctx = (_img_buffer_ctx_t*)pCtx;
+
+	memcpy(pBuffer, &ctx->pImage[Offset], Len);
+	return NOR_OK;
+}
+
+static uint32_t _img_chunk(nor_t *nor, uint32_t Offset, uint32_t Remaining){
+	uint32_t Chunk;
+
+	// never cross a page, so a chunk belongs to a single page
+	Chunk = nor->info.u16PageSize - (Offset % nor->info.u16PageSize);
+	if (Chunk > NOR_IMG_BUFFER_LEN){
+		Chunk = NOR_IMG_BUFFER_LEN;
+	}
+	if (Chunk > Remaining){
+		Chunk = Remaining;
+	}
+	return Chunk;
+}
+
+static uint8_t _img_is_erased(uint8_t *pBuffer, uint32_t Len){
+	uint32_t i;
+
+	for (i=0 ; i<Len ; i++){
+		if (pBuffer[i] != 0xFF){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Publics
+ */
+
+uint32_t NOR_IMG_Hash(uint32_t Hash, uint8_t *pBuffer, uint32_t Len){
+	uint32_t i;
+
+	for (i=0 ; i<Len ; i++){
+		Hash ^= pBuffer[i];
+		Hash *= _IMG_FNV_PRIME;
+	}
+	return Hash;
+}
+
+nor_err_e NOR_IMG_HashRegion(nor_t *nor, uint32_t Address, uint32_t Len, uint32_t *pSectorHash){
+	uint8_t pBuffer[NOR_IMG_BUFFER_LEN];
+	uint32_t Offset, Chunk, Sector;
+	nor_err_e err;
+
+	if (nor == NULL || pSectorHash == NULL || Len == 0 || (Address % nor->info.u16SectorSize) != 0){
+		return NOR_INVALID_PARAMS;
+	}
+	for (Offset=0 ; Offset<Len ; Offset+=Chunk){
+		Sector = Offset / nor->info.u16SectorSize;
+		if ((Offset % nor->info.u16SectorSize) == 0){
+			pSectorHash[Sector] = NOR_IMG_HASH_INIT;
+		}
+		Chunk = _img_chunk(nor, Offset, Len - Offset);
+		err = NOR_ReadBytes(nor, pBuffer, Address + Offset, Chunk);
+		if (err != NOR_OK){
+			return err;
+		}
+		pSectorHash[Sector] = NOR_IMG_Hash(pSectorHash[Sector], pBuffer, Chunk);
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_IMG_Program(nor_t *nor, uint32_t Address, uint8_t *pImage, uint32_t Len,
+		uint32_t *pSectorHash, nor_img_stats_t *pStats){
+	_img_buffer_ctx_t ctx;
+
+	if (pImage == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	ctx.pImage = pImage;
+	return NOR_IMG_ProgramStream(nor, Address, _img_buffer_src, &ctx, Len, pSectorHash, pStats);
+}
+
+nor_err_e NOR_IMG_ProgramStream(nor_t *nor, uint32_t Address, nor_img_src_fxn_t SrcFxn, void *pCtx,
+		uint32_t Len, uint32_t *pSectorHash, nor_img_stats_t *pStats){
+	uint8_t pNew[NOR_IMG_BUFFER_LEN], pOld[NOR_IMG_BUFFER_LEN];
+	uint32_t Sector, SectorOffset, SectorLen, Offset, Chunk, Hash, DirtyPages, i;
+	uint8_t NeedErase;
+	nor_img_stats_t stats;
+	nor_err_e err;
+
+	if (nor == NULL || SrcFxn == NULL || Len == 0 || nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			(Address % nor->info.u16SectorSize) != 0 ||
+			(nor->info.u16SectorSize / nor->info.u16PageSize) > 32){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Address >= nor->info.u32Size || Len > (nor->info.u32Size - Address)){
+		return NOR_OUT_OF_RANGE;
+	}
+	memset(&stats, 0, sizeof(stats));
+	for (Sector=0 ; (Sector * nor->info.u16SectorSize) < Len ; Sector++){
+		SectorOffset = Sector * nor->info.u16SectorSize;
+		SectorLen = Len - SectorOffset;
+		if (SectorLen > nor->info.u16SectorSize){
+			SectorLen = nor->info.u16SectorSize;
+		}
+		stats.u32Sectors++;
+		Hash = NOR_IMG_HASH_INIT;
+		if (pSectorHash != NULL){
+			for (Offset=0 ; Offset<SectorLen ; Offset+=Chunk){
+				Chunk = _img_chunk(nor, Offset, SectorLen - Offset);
+				err = SrcFxn(pCtx, SectorOffset + Offset, pNew, Chunk);
+				if (err != NOR_OK){
+					return err;
+				}
+				Hash = NOR_IMG_Hash(Hash, pNew, Chunk);
+			}
+			if (Hash == pSectorHash[Sector]){
+				stats.u32SectorsSkipped++;
+				stats.u32BytesSkipped += SectorLen;
+				continue;
+			}
+		}
+		// compare with the device, to known which pages changed
+		DirtyPages = 0;
+		NeedErase = 0;
+		for (Offset=0 ; Offset<SectorLen && NeedErase == 0 ; Offset+=Chunk){
+			Chunk = _img_chunk(nor, Offset, SectorLen - Offset);
+			err = SrcFxn(pCtx, SectorOffset + Offset, pNew, Chunk);
+			if (err == NOR_OK){
+				err = NOR_ReadBytes(nor, pOld, Address + SectorOffset + Offset, Chunk);
+			}
+			if (err != NOR_OK){
+				return err;
+			}
+			for (i=0 ; i<Chunk ; i++){
+				if (pNew[i] != pOld[i]){
+					DirtyPages |= (1UL << (Offset / nor->info.u16PageSize));
+					if ((pNew[i] & pOld[i]) != pNew[i]){
+						NeedErase = 1;
+						break;
+					}
+				}
+			}
+		}
+		if (DirtyPages == 0){
+			stats.u32SectorsSkipped++;
+			stats.u32BytesSkipped += SectorLen;
+		}
+		else{
+			if (NeedErase){
+				err = NOR_EraseAddress(nor, Address + SectorOffset, NOR_ERASE_4K);
+				if (err != NOR_OK){
+					return err;
+				}
+				stats.u32SectorsErased++;
+				DirtyPages = 0xFFFFFFFF;
+			}
+			else{
+				stats.u32SectorsNoErase++;
+			}
+			for (Offset=0 ; Offset<SectorLen ; Offset+=Chunk){
+				Chunk = _img_chunk(nor, Offset, SectorLen - Offset);
+				if ((DirtyPages & (1UL << (Offset / nor->info.u16PageSize))) == 0){
+					stats.u32BytesSkipped += Chunk;
+					continue;
+				}
+				err = SrcFxn(pCtx, SectorOffset + Offset, pNew, Chunk);
+				if (err != NOR_OK){
+					return err;
+				}
+				if (NeedErase && _img_is_erased(pNew, Chunk)){
+					stats.u32BytesSkipped += Chunk;
+					continue;
+				}
+				err = NOR_WriteBytes(nor, pNew, Address + SectorOffset + Offset, Chunk);
+				if (err != NOR_OK){
+					return err;
+				}
+				stats.u32BytesProgrammed += Chunk;
+			}
+		}
+		if (pSectorHash != NULL){
+			pSectorHash[Sector] = Hash;
+		}
+	}
+	stats.u32ErasesSaved = stats.u32Sectors - stats.u32SectorsErased;
+	if (pStats != NULL){
+		*pStats = stats;
+	}
+
+	// each program was checked by NOR_WriteBytes, a failure latched before isn't of the image
+	return NOR_OK;
+}
@@ -0,0 +1,125 @@
+/*
+ * nor_img.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Delta programming of images. The new image is compared with the device
+ *  contents sector by sector, and only the sectors that changed are written.
+ *  Sectors where the changes only clear bits are programmed without erase.
+ */
+
+#ifndef NOR_IMG_H_
+#define NOR_IMG_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+// Size of the stack buffers used to compare the image with the device
+#ifndef NOR_IMG_BUFFER_LEN
+#define NOR_IMG_BUFFER_LEN			NOR_PAGE_SIZE
+#endif
+
+#define NOR_IMG_HASH_INIT			0x811C9DC5
+
+/**
+ * Function Typedefs
+ */
+
+/**
+ * Provides Len bytes of the image, starting at Offset. The same offset can
+ * be requested more than once, while the sector that contains it is processed.
+ */
+typedef nor_err_e (*nor_img_src_fxn_t)(void *pCtx, uint32_t Offset, uint8_t *pBuffer, uint32_t Len);
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	uint32_t u32Sectors;
+	uint32_t u32SectorsSkipped;
+	uint32_t u32SectorsNoErase;
+	uint32_t u32SectorsErased;
+	uint32_t u32BytesProgrammed;
+	uint32_t u32BytesSkipped;
+	uint32_t u32ErasesSaved;
+}nor_img_stats_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Hash function used on the sector hashes (FNV-1a).
+ *
+ * @param Hash previous hash, or NOR_IMG_HASH_INIT
+ * @param pBuffer data
+ * @param Len size of data
+ * @return the updated hash
+ */
+uint32_t NOR_IMG_Hash(uint32_t Hash, uint8_t *pBuffer, uint32_t Len);
+
+/**
+ * @brief Compute the hashes of the device contents, one per sector, to be used
+ * on the next programming.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param Address start of the region, aligned to the sector
+ * @param Len size of the region
+ * @param pSectorHash array with one hash per sector of the region
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid
+ */
+nor_err_e NOR_IMG_HashRegion(nor_t *nor, uint32_t Address, uint32_t Len, uint32_t *pSectorHash);
+
+/**
+ * @brief Program an image from a buffer. See NOR_IMG_ProgramStream.
+ */
+nor_err_e NOR_IMG_Program(nor_t *nor, uint32_t Address, uint8_t *pImage, uint32_t Len,
+		uint32_t *pSectorHash, nor_img_stats_t *pStats);
+
+/**
+ * @brief Program an image provided by a source function, rewriting only the
+ * sectors that changed.
+ *
+ * When pSectorHash is provided, and the hash of the new sector is equal to the
+ * stored hash, the sector is skipped without read the device. Otherwise the
+ * sector is compared with the device, and:
+ *  - identical sectors are skipped;
+ *  - sectors where the changes only clear bits have the changed pages programmed;
+ *  - the other sectors are erased and programmed.
+ * pSectorHash is updated with the hashes of the new image.
+ *
+ * @note The region is rounded up to the sector size. The bytes after the image
+ * end, on the last sector, are lost if the sector needs to be erased.
+ * @note With config.PostedWrite enabled the pages are programmed as by
+ * NOR_WriteBytes, the last one may be in progress on the return, and the
+ * failures are reported by NOR_Sync.
+ *
+ * @param nor pointer to the Nor Instance
+ * @param Address start of the region, aligned to the sector
+ * @param SrcFxn function that provides the image
+ * @param pCtx context passed to SrcFxn
+ * @param Len size of the image
+ * @param pSectorHash optional array with one hash per sector, can be NULL
+ * @param pStats optional statistics of the programming, can be NULL
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid
+ * @return NOR_OUT_OF_RANGE the image doesn't fit on the device
+ * @return NOR_PROGRAM_FAILED or NOR_ERASE_FAILED the device reported a failure
+ * on a sector of the image
+ */
+nor_err_e NOR_IMG_ProgramStream(nor_t *nor, uint32_t Address, nor_img_src_fxn_t SrcFxn, void *pCtx,
+		uint32_t Len, uint32_t *pSectorHash, nor_img_stats_t *pStats);
+
+#endif /* NOR_IMG_H_ */
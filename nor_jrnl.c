@@ -0,0 +1,542 @@
+/*
+ * nor_jrnl.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "nor_jrnl.h"
+#include "nor_crc.h"
+
+/*
+ * Privates
+ */
+
+#define _JRNL_SANITY_CHECK(j)		if (j == NULL)	return NOR_INVALID_PARAMS;					\
+									if (j->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+#define _JRNL_MIN(a, b)				(((a) < (b)) ? (a) : (b))
+
+/* Functions */
+
+static uint32_t _jrnl_addr(nor_jrnl_t *j, uint32_t Ring, uint16_t Page){
+	return ((j->config.u32FirstSector + Ring) * j->nor->info.u16SectorSize) + ((uint32_t)Page * NOR_PAGE_SIZE);
+}
+
+static uint32_t _jrnl_max_update(nor_jrnl_t *j){
+	return _JRNL_MIN(j->config.u16PageCount, NOR_JRNL_MAX_PAGES);
+}
+
+static uint32_t _jrnl_free(nor_jrnl_t *j){
+	return (j->_internal.u16SlotsPerSector + 1 - j->_internal.u16HeadPage) +
+			((j->config.u32SectorCount - j->_internal.u32Used) * j->_internal.u16SlotsPerSector);
+}
+
+static void _jrnl_reset(nor_jrnl_t *j){
+	memset(j->config.pMap, 0xFF, j->config.u16PageCount * sizeof(uint32_t));
+	// empty log, the first slot opens the sector 0
+	j->_internal.u32Used = 0;
+	j->_internal.u32Head = j->config.u32SectorCount - 1;
+	j->_internal.u32Tail = 0;
+	j->_internal.u16HeadPage = j->_internal.u16SlotsPerSector + 1;
+	j->_internal.u32SectorSeq = 0;
+	j->_internal.u32Seq = 0;
+}
+
+static uint32_t _jrnl_record_crc(nor_jrnl_record_t *rec){
+	uint16_t Flags = rec->u16Flags;
+	uint32_t Crc = rec->u32Crc, Result;
+
+	rec->u16Flags = NOR_JRNL_FLAG_PENDING;
+	rec->u32Crc = NOR_JRNL_NONE;
+	Result = NOR_CRC32(0, (uint8_t*)rec, sizeof(nor_jrnl_record_t));
+	rec->u16Flags = Flags;
+	rec->u32Crc = Crc;
+
+	return Result;
+}
+
+static nor_err_e _jrnl_read_header(nor_jrnl_t *j, uint32_t Ring, nor_jrnl_sector_t *pHdr){
+	if (NOR_ReadBytes(j->nor, (uint8_t*)pHdr, _jrnl_addr(j, Ring, 0), sizeof(nor_jrnl_sector_t)) != NOR_OK){
+		return NOR_FAIL;
+	}
+	if (pHdr->u32Magic != NOR_JRNL_SECTOR_MAGIC ||
+			pHdr->u32Crc != NOR_CRC32(0, (uint8_t*)pHdr, offsetof(nor_jrnl_sector_t, u32Crc))){
+		return NOR_REGIONS_IS_NOT_EMPTY;
+	}
+	return NOR_OK;
+}
+
+/*
+ * Start the next sector of the ring. Skip tells how many pages at the start
+ * belong to the record being programmed, so the mount finds the next record
+ * when the sector with that record is compacted.
+ */
+static nor_err_e _jrnl_open_sector(nor_jrnl_t *j, uint16_t Skip){
+	nor_jrnl_sector_t hdr;
+	uint32_t Ring, Sector;
+	nor_err_e err;
+
+	if (j->_internal.u32Used >= j->config.u32SectorCount){
+		return NOR_FAIL;
+	}
+	Ring = (j->_internal.u32Head + 1) % j->config.u32SectorCount;
+	Sector = j->config.u32FirstSector + Ring;
+	// the sectors out of the log may keep a torn header, or a torn erase
+	err = NOR_IsEmptySector(j->nor, Sector, 0, j->nor->info.u16SectorSize);
+	if (err == NOR_REGIONS_IS_NOT_EMPTY){
+		if (NOR_EraseSector(j->nor, Sector) != NOR_OK){
+			return NOR_FAIL;
+		}
+		j->stats.u32Erases++;
+	}
+	else if (err != NOR_OK){
+		return NOR_FAIL;
+	}
+	hdr.u32Magic = NOR_JRNL_SECTOR_MAGIC;
+	hdr.u32Seq = ++j->_internal.u32SectorSeq;
+	hdr.u16Skip = _JRNL_MIN(Skip, j->_internal.u16SlotsPerSector);
+	hdr.u16Reserved = 0xFFFF;
+	hdr.u32Crc = NOR_CRC32(0, (uint8_t*)&hdr, offsetof(nor_jrnl_sector_t, u32Crc));
+	if (NOR_WriteBytes(j->nor, (uint8_t*)&hdr, _jrnl_addr(j, Ring, 0), sizeof(hdr)) != NOR_OK){
+		return NOR_FAIL;
+	}
+	if (j->_internal.u32Used == 0){
+		j->_internal.u32Tail = Ring;
+	}
+	j->_internal.u32Head = Ring;
+	j->_internal.u32Used++;
+	j->_internal.u16HeadPage = 1;
+
+	return NOR_OK;
+}
+
+static nor_err_e _jrnl_slot(nor_jrnl_t *j, uint16_t Skip, uint32_t *pAddress){
+	if (j->_internal.u16HeadPage > j->_internal.u16SlotsPerSector){
+		if (_jrnl_open_sector(j, Skip) != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	*pAddress = _jrnl_addr(j, j->_internal.u32Head, j->_internal.u16HeadPage++);
+
+	return NOR_OK;
+}
+
+/*
+ * Address of the Nth slot after the slot of Page on the sector Ring, the
+ * pages of a record follow it skipping the sector headers.
+ */
+static uint32_t _jrnl_slot_addr(nor_jrnl_t *j, uint32_t Ring, uint16_t Page, uint32_t N){
+	uint32_t Pos = (Page - 1) + N;
+
+	Ring = (Ring + (Pos / j->_internal.u16SlotsPerSector)) % j->config.u32SectorCount;
+	return _jrnl_addr(j, Ring, (Pos % j->_internal.u16SlotsPerSector) + 1);
+}
+
+static nor_err_e _jrnl_read_page(nor_jrnl_t *j, uint32_t Page, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	if (j->config.pMap[Page] == NOR_JRNL_NONE){
+		memset(pData, 0xFF, Len);
+		return NOR_OK;
+	}
+	return NOR_ReadBytes(j->nor, pData, j->config.pMap[Page] + Offset, Len);
+}
+
+/*
+ * Program the record on _internal.Record and its pages, overlaying the range
+ * of pData on the current content. pData NULL just copies the pages.
+ */
+static nor_err_e _jrnl_program(nor_jrnl_t *j, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	nor_jrnl_record_t *rec = &j->_internal.Record;
+	uint32_t RecAddr, Address, Ring, PageStart, Start, End, i;
+	uint16_t Page, Flags;
+
+	rec->u32Magic = NOR_JRNL_RECORD_MAGIC;
+	rec->u32Seq = j->_internal.u32Seq++;
+	rec->u16Flags = NOR_JRNL_FLAG_PENDING;
+	for (i=rec->u16Count ; i<NOR_JRNL_MAX_PAGES ; i++){
+		rec->u16Page[i] = 0xFFFF;
+	}
+	rec->u32Crc = _jrnl_record_crc(rec);
+	if (_jrnl_slot(j, 0, &RecAddr) != NOR_OK ||
+			NOR_WriteBytes(j->nor, (uint8_t*)rec, RecAddr, NOR_PAGE_SIZE) != NOR_OK){
+		return NOR_FAIL;
+	}
+	Ring = j->_internal.u32Head;
+	Page = j->_internal.u16HeadPage - 1;
+	for (i=0 ; i<rec->u16Count ; i++){
+		if (_jrnl_read_page(j, rec->u16Page[i], 0, j->_internal.u8Page, NOR_PAGE_SIZE) != NOR_OK){
+			return NOR_FAIL;
+		}
+		if (pData != NULL){
+			PageStart = rec->u16Page[i] * NOR_PAGE_SIZE;
+			Start = (Offset > PageStart) ? Offset : PageStart;
+			End = _JRNL_MIN(Offset + Len, PageStart + NOR_PAGE_SIZE);
+			memcpy(&j->_internal.u8Page[Start - PageStart], &pData[Start - Offset], End - Start);
+		}
+		if (_jrnl_slot(j, rec->u16Count - i, &Address) != NOR_OK ||
+				NOR_WriteBytes(j->nor, j->_internal.u8Page, Address, NOR_PAGE_SIZE) != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	// programmed only after the pages, a posted write is waited first
+	Flags = NOR_JRNL_FLAG_COMMITTED;
+	if (NOR_WriteBytes(j->nor, (uint8_t*)&Flags, RecAddr + offsetof(nor_jrnl_record_t, u16Flags), sizeof(Flags)) != NOR_OK ||
+			NOR_Sync(j->nor) != NOR_OK){
+		return NOR_FAIL;
+	}
+	for (i=0 ; i<rec->u16Count ; i++){
+		j->config.pMap[rec->u16Page[i]] = _jrnl_slot_addr(j, Ring, Page, i + 1);
+	}
+	j->stats.u32Commits++;
+
+	return NOR_OK;
+}
+
+static nor_err_e _jrnl_commit(nor_jrnl_t *j, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	if (_jrnl_program(j, Offset, pData, Len) != NOR_OK){
+		// the slots after a torn record are not trusted, the next one opens a new sector
+		j->_internal.u16HeadPage = j->_internal.u16SlotsPerSector + 1;
+		return NOR_FAIL;
+	}
+	return NOR_OK;
+}
+
+/*
+ * Position of a slot on the log, counted from the first slot of the tail.
+ */
+static uint32_t _jrnl_pos(nor_jrnl_t *j, uint32_t Address){
+	uint32_t Ring = (Address / j->nor->info.u16SectorSize) - j->config.u32FirstSector;
+	uint32_t Page = (Address % j->nor->info.u16SectorSize) / NOR_PAGE_SIZE;
+
+	Ring = (Ring + j->config.u32SectorCount - j->_internal.u32Tail) % j->config.u32SectorCount;
+	return (Ring * j->_internal.u16SlotsPerSector) + Page - 1;
+}
+
+/*
+ * Slots that a compaction may program: the live pages of the tail, the
+ * pages of a record continued on the next sectors, and their records.
+ */
+static uint32_t _jrnl_reserve(nor_jrnl_t *j){
+	return j->_internal.u16SlotsPerSector + _jrnl_max_update(j) + 2;
+}
+
+/*
+ * Copy the live pages of the records on the oldest sector to the head, and
+ * erase it.
+ */
+static nor_err_e _jrnl_compact(nor_jrnl_t *j){
+	nor_jrnl_record_t *rec = &j->_internal.Record;
+	nor_jrnl_sector_t hdr;
+	uint32_t Index, End, i;
+
+	if (j->_internal.u32Used < 2){
+		return NOR_FAIL;
+	}
+	// the last record of the tail may continue on the next sectors
+	Index = 1;
+	do{
+		if (_jrnl_read_header(j, (j->_internal.u32Tail + Index) % j->config.u32SectorCount, &hdr) != NOR_OK){
+			return NOR_FAIL;
+		}
+		End = (Index * j->_internal.u16SlotsPerSector) + hdr.u16Skip;
+		Index++;
+	}while (hdr.u16Skip == j->_internal.u16SlotsPerSector && Index < j->_internal.u32Used);
+
+	i = 0;
+	while (i < j->config.u16PageCount){
+		rec->u16Count = 0;
+		for ( ; i<j->config.u16PageCount && rec->u16Count<NOR_JRNL_MAX_PAGES ; i++){
+			if (j->config.pMap[i] != NOR_JRNL_NONE && _jrnl_pos(j, j->config.pMap[i]) < End){
+				rec->u16Page[rec->u16Count++] = i;
+			}
+		}
+		if (rec->u16Count > 0){
+			if (_jrnl_commit(j, 0, NULL, 0) != NOR_OK){
+				return NOR_FAIL;
+			}
+			j->stats.u32PagesRelocated += rec->u16Count;
+		}
+	}
+	if (NOR_EraseSector(j->nor, j->config.u32FirstSector + j->_internal.u32Tail) != NOR_OK){
+		return NOR_FAIL;
+	}
+	j->stats.u32Erases++;
+	j->_internal.u32Tail = (j->_internal.u32Tail + 1) % j->config.u32SectorCount;
+	j->_internal.u32Used--;
+
+	return NOR_OK;
+}
+
+static nor_err_e _jrnl_make_room(nor_jrnl_t *j, uint32_t Slots){
+	uint32_t i;
+
+	Slots += _jrnl_reserve(j);
+	for (i=0 ; i<(2 * j->config.u32SectorCount) && _jrnl_free(j) < Slots ; i++){
+		if (_jrnl_compact(j) != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	return (_jrnl_free(j) >= Slots) ? NOR_OK : NOR_FAIL;
+}
+
+/*
+ * Move the walk to the first record of the next sector of the log.
+ */
+static nor_err_e _jrnl_next_sector(nor_jrnl_t *j, uint32_t *pIndex, uint16_t *pPage){
+	nor_jrnl_sector_t hdr;
+
+	(*pIndex)++;
+	*pPage = 1;
+	if (*pIndex < j->_internal.u32Used){
+		if (_jrnl_read_header(j, (j->_internal.u32Tail + *pIndex) % j->config.u32SectorCount, &hdr) != NOR_OK){
+			return NOR_FAIL;
+		}
+		*pPage += hdr.u16Skip;
+	}
+	return NOR_OK;
+}
+
+/*
+ * Walk the records from the tail, applying the committed ones to the map.
+ * The walk leaves a sector on the first record not committed, and the head
+ * sector is sealed unless it ends on erased pages, so the next records never
+ * follow a torn one on the same sector.
+ */
+static nor_err_e _jrnl_replay(nor_jrnl_t *j){
+	nor_jrnl_record_t *rec = &j->_internal.Record;
+	uint32_t Index, Ring, Address, Pos, i;
+	uint16_t Page, Flags;
+	uint8_t Valid;
+	nor_err_e err;
+
+	j->_internal.u16HeadPage = j->_internal.u16SlotsPerSector + 1;
+	Index = (uint32_t)-1;
+	if (_jrnl_next_sector(j, &Index, &Page) != NOR_OK){
+		return NOR_FAIL;
+	}
+	while (Index < j->_internal.u32Used){
+		if (Page > j->_internal.u16SlotsPerSector){
+			if (_jrnl_next_sector(j, &Index, &Page) != NOR_OK){
+				return NOR_FAIL;
+			}
+			continue;
+		}
+		Ring = (j->_internal.u32Tail + Index) % j->config.u32SectorCount;
+		Address = _jrnl_addr(j, Ring, Page);
+		if (NOR_ReadBytes(j->nor, (uint8_t*)rec, Address, NOR_PAGE_SIZE) != NOR_OK){
+			return NOR_FAIL;
+		}
+		if (rec->u32Magic == NOR_JRNL_NONE && Index == (j->_internal.u32Used - 1)){
+			err = NOR_IsEmptyAddress(j->nor, Address, _jrnl_addr(j, Ring, j->_internal.u16SlotsPerSector + 1) - Address);
+			if (err == NOR_OK){
+				j->_internal.u16HeadPage = Page;
+				break;
+			}
+			if (err != NOR_REGIONS_IS_NOT_EMPTY){
+				return NOR_FAIL;
+			}
+		}
+		Valid = (rec->u32Magic == NOR_JRNL_RECORD_MAGIC && rec->u32Crc == _jrnl_record_crc(rec) &&
+				rec->u16Count > 0 && rec->u16Count <= NOR_JRNL_MAX_PAGES);
+		for (i=0 ; Valid && i<rec->u16Count ; i++){
+			Valid = (rec->u16Page[i] < j->config.u16PageCount);
+		}
+		// slot after the last page of the record
+		Pos = (Page - 1) + rec->u16Count + 1;
+		if (!Valid || rec->u16Flags == NOR_JRNL_FLAG_PENDING ||
+				(Index + ((Pos - 1) / j->_internal.u16SlotsPerSector)) >= j->_internal.u32Used){
+			if (rec->u32Magic != NOR_JRNL_NONE){
+				j->stats.u32Discarded++;
+			}
+			if (_jrnl_next_sector(j, &Index, &Page) != NOR_OK){
+				return NOR_FAIL;
+			}
+			continue;
+		}
+		// any cleared bit means the pages were complete, finish a torn commit
+		if (rec->u16Flags != NOR_JRNL_FLAG_COMMITTED){
+			Flags = NOR_JRNL_FLAG_COMMITTED;
+			if (NOR_WriteBytes(j->nor, (uint8_t*)&Flags, Address + offsetof(nor_jrnl_record_t, u16Flags), sizeof(Flags)) != NOR_OK){
+				return NOR_FAIL;
+			}
+		}
+		for (i=0 ; i<rec->u16Count ; i++){
+			j->config.pMap[rec->u16Page[i]] = _jrnl_slot_addr(j, Ring, Page, i + 1);
+		}
+		Index += Pos / j->_internal.u16SlotsPerSector;
+		Page = (Pos % j->_internal.u16SlotsPerSector) + 1;
+		j->_internal.u32Seq = rec->u32Seq + 1;
+	}
+	return NOR_OK;
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_JRNL_Init(nor_jrnl_t *j){
+	nor_jrnl_sector_t hdr;
+	uint32_t Ring, Seq, Slots;
+	uint8_t Found = 0;
+	nor_err_e err;
+
+	if (j == NULL || j->nor == NULL || j->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			j->config.pMap == NULL || j->config.u16PageCount == 0 || j->config.u32SectorCount < 4){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((j->config.u32FirstSector + j->config.u32SectorCount) > j->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	j->_internal.u16Initialized = 0;
+	j->_internal.u16SlotsPerSector = (j->nor->info.u16SectorSize / NOR_PAGE_SIZE) - 1;
+	Slots = (j->config.u32SectorCount - 3) * j->_internal.u16SlotsPerSector;
+	if (Slots < ((uint32_t)j->config.u16PageCount + (2 * _jrnl_max_update(j)) + 3)){
+		return NOR_INVALID_PARAMS;
+	}
+	memset(&j->stats, 0, sizeof(j->stats));
+	_jrnl_reset(j);
+
+	// the head is the newest sector, the log goes back while the sequence does
+	Seq = 0;
+	for (Ring=0 ; Ring<j->config.u32SectorCount ; Ring++){
+		err = _jrnl_read_header(j, Ring, &hdr);
+		if (err == NOR_FAIL){
+			return NOR_FAIL;
+		}
+		if (err == NOR_OK && (!Found || hdr.u32Seq > Seq)){
+			Found = 1;
+			Seq = hdr.u32Seq;
+			j->_internal.u32Head = Ring;
+		}
+	}
+	if (Found){
+		j->_internal.u32SectorSeq = Seq;
+		j->_internal.u32Used = 1;
+		while (j->_internal.u32Used < j->config.u32SectorCount){
+			Ring = (j->_internal.u32Head + j->config.u32SectorCount - j->_internal.u32Used) % j->config.u32SectorCount;
+			err = _jrnl_read_header(j, Ring, &hdr);
+			if (err == NOR_FAIL){
+				return NOR_FAIL;
+			}
+			if (err != NOR_OK || hdr.u32Seq != (Seq - j->_internal.u32Used)){
+				break;
+			}
+			j->_internal.u32Used++;
+		}
+		j->_internal.u32Tail = (j->_internal.u32Head + j->config.u32SectorCount + 1 - j->_internal.u32Used) % j->config.u32SectorCount;
+		if (_jrnl_replay(j) != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	j->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_JRNL_Format(nor_jrnl_t *j){
+	uint32_t Sector, i;
+	nor_err_e err;
+
+	_JRNL_SANITY_CHECK(j);
+
+	for (i=0 ; i<j->config.u32SectorCount ; i++){
+		Sector = j->config.u32FirstSector + i;
+		err = NOR_IsEmptySector(j->nor, Sector, 0, j->nor->info.u16SectorSize);
+		if (err == NOR_REGIONS_IS_NOT_EMPTY){
+			err = NOR_EraseSector(j->nor, Sector);
+			j->stats.u32Erases++;
+		}
+		if (err != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	_jrnl_reset(j);
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_JRNL_Write(nor_jrnl_t *j, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	nor_jrnl_record_t *rec = &j->_internal.Record;
+	uint32_t First, Last, PageStart, Start, End, p;
+
+	_JRNL_SANITY_CHECK(j);
+
+	if (pData == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Offset > ((uint32_t)j->config.u16PageCount * NOR_PAGE_SIZE) ||
+			Len > (((uint32_t)j->config.u16PageCount * NOR_PAGE_SIZE) - Offset)){
+		return NOR_OUT_OF_RANGE;
+	}
+	if (Len == 0){
+		return NOR_OK;
+	}
+	First = Offset / NOR_PAGE_SIZE;
+	Last = (Offset + Len - 1) / NOR_PAGE_SIZE;
+	if ((Last - First + 1) > NOR_JRNL_MAX_PAGES){
+		return NOR_INVALID_PARAMS;
+	}
+	// before the list of pages, the compaction programs its own record
+	if (_jrnl_make_room(j, Last - First + 2) != NOR_OK){
+		return NOR_FAIL;
+	}
+	rec->u16Count = 0;
+	for (p=First ; p<=Last ; p++){
+		PageStart = p * NOR_PAGE_SIZE;
+		Start = (Offset > PageStart) ? Offset : PageStart;
+		End = _JRNL_MIN(Offset + Len, PageStart + NOR_PAGE_SIZE);
+		if (_jrnl_read_page(j, p, Start - PageStart, j->_internal.u8Page, End - Start) != NOR_OK){
+			return NOR_FAIL;
+		}
+		if (memcmp(j->_internal.u8Page, &pData[Start - Offset], End - Start) == 0){
+			j->stats.u32PagesSkipped++;
+			continue;
+		}
+		rec->u16Page[rec->u16Count++] = p;
+	}
+	if (rec->u16Count == 0){
+		return NOR_OK;
+	}
+	if (_jrnl_commit(j, Offset, pData, Len) != NOR_OK){
+		return NOR_FAIL;
+	}
+	j->stats.u32PagesWritten += rec->u16Count;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_JRNL_Read(nor_jrnl_t *j, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	uint32_t Page, In, n;
+
+	_JRNL_SANITY_CHECK(j);
+
+	if (pData == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Offset > ((uint32_t)j->config.u16PageCount * NOR_PAGE_SIZE) ||
+			Len > (((uint32_t)j->config.u16PageCount * NOR_PAGE_SIZE) - Offset)){
+		return NOR_OUT_OF_RANGE;
+	}
+	while (Len > 0){
+		Page = Offset / NOR_PAGE_SIZE;
+		In = Offset % NOR_PAGE_SIZE;
+		n = _JRNL_MIN(Len, NOR_PAGE_SIZE - In);
+		if (_jrnl_read_page(j, Page, In, pData, n) != NOR_OK){
+			return NOR_FAIL;
+		}
+		Offset += n;
+		pData += n;
+		Len -= n;
+	}
+	return NOR_OK;
+}
+
+nor_err_e NOR_JRNL_Compact(nor_jrnl_t *j){
+	_JRNL_SANITY_CHECK(j);
+
+	return _jrnl_make_room(j, _jrnl_max_update(j) + 1);
+}
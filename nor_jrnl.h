@@ -0,0 +1,185 @@
+/*
+ * nor_jrnl.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Journaled blob, updated atomically across power loss. The blob is split
+ *  in logical pages, and an update programs only the pages it changes, after
+ *  a record page listing them. The record is committed by clearing its flags
+ *  once all the pages are programmed, so NOR_JRNL_Init replays the committed
+ *  records and discards the one torn by a power loss.
+ *
+ *  The region is a ring of sectors, each one starting with a header page
+ *  carrying a sequence number. Compaction is lazy: only when the free space
+ *  runs out, the live pages of the oldest sector are copied to the head by
+ *  a normal record, and then the sector is erased.
+ */
+
+#ifndef NOR_JRNL_H_
+#define NOR_JRNL_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_JRNL_SECTOR_MAGIC		0x534E524A	// "JRNS"
+#define NOR_JRNL_RECORD_MAGIC		0x524E524A	// "JRNR"
+#define NOR_JRNL_NONE				0xFFFFFFFF
+
+// Flags of the record, cleared on commit
+#define NOR_JRNL_FLAG_PENDING		0xFFFF
+#define NOR_JRNL_FLAG_COMMITTED		0x0000
+
+// Pages changed by a single update, listed on the record page
+#define NOR_JRNL_MAX_PAGES			((NOR_PAGE_SIZE - 16) / sizeof(uint16_t))
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	uint32_t u32Magic;
+	uint32_t u32Seq;
+	// pages at the start of the sector continuing a record of the previous one
+	uint16_t u16Skip;
+	uint16_t u16Reserved;
+	// CRC32 of the 12 bytes above
+	uint32_t u32Crc;
+}nor_jrnl_sector_t;
+
+typedef struct{
+	uint32_t u32Magic;
+	uint32_t u32Seq;
+	uint16_t u16Count;
+	uint16_t u16Flags;
+	// CRC32 of the whole page, with u16Flags and u32Crc erased
+	uint32_t u32Crc;
+	// logical pages, programmed in this order after the record
+	uint16_t u16Page[NOR_JRNL_MAX_PAGES];
+}nor_jrnl_record_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		// at least 4, see NOR_JRNL_Init
+		uint32_t u32SectorCount;
+		// size of the blob, in pages
+		uint16_t u16PageCount;
+		// PageCount entries, the address of every logical page
+		uint32_t *pMap;
+	}config;
+	struct{
+		uint32_t u32Commits;
+		// data pages programmed by the updates
+		uint32_t u32PagesWritten;
+		// pages on the range of an update with the same content
+		uint32_t u32PagesSkipped;
+		// pages copied by the compaction
+		uint32_t u32PagesRelocated;
+		uint32_t u32Erases;
+		// records found torn or not committed on NOR_JRNL_Init
+		uint32_t u32Discarded;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		uint16_t u16SlotsPerSector;
+		// ring indexes of the oldest and newest sectors of the log
+		uint32_t u32Tail;
+		uint32_t u32Head;
+		uint32_t u32Used;
+		// next page of the head sector, SlotsPerSector + 1 when full
+		uint16_t u16HeadPage;
+		uint32_t u32SectorSeq;
+		uint32_t u32Seq;
+		nor_jrnl_record_t Record;
+		uint8_t u8Page[NOR_PAGE_SIZE];
+	}_internal;
+}nor_jrnl_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Mount the journal, replaying the committed records to build the
+ * page map. A record torn or not committed by a power loss is discarded, so
+ * the blob reads as before that update. An erased region mounts as a blob
+ * of 0xFF. Fill the nor and config fields before call this function.
+ *
+ * The region needs room for the blob, an update and the compaction:
+ * (SectorCount - 3) * (SectorSize / PageSize - 1) >= PageCount + 2 * MaxUpdate + 3,
+ * where MaxUpdate is the smaller of PageCount and NOR_JRNL_MAX_PAGES.
+ *
+ * @param j pointer to the journal instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid, or the region is too small
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ * @return NOR_FAIL failed to access the device
+ */
+nor_err_e NOR_JRNL_Init(nor_jrnl_t *j);
+
+/**
+ * @brief Erase the region, the blob reads as 0xFF.
+ *
+ * @param j pointer to the journal instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_JRNL_Init first
+ * @return NOR_FAIL failed to erase
+ */
+nor_err_e NOR_JRNL_Format(nor_jrnl_t *j);
+
+/**
+ * @brief Update a range of the blob atomically: after a power loss, the
+ * blob reads all old or all new. Only the pages with a different content
+ * are programmed, and the update touching no page returns without write.
+ *
+ * @param j pointer to the journal instance
+ * @param Offset offset on the blob
+ * @param pData new data of the range
+ * @param Len length of the range, touching up to NOR_JRNL_MAX_PAGES pages
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_JRNL_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL, or the range touches too many pages
+ * @return NOR_OUT_OF_RANGE the range is beyond the blob
+ * @return NOR_FAIL failed to program or erase, the update may be lost
+ */
+nor_err_e NOR_JRNL_Write(nor_jrnl_t *j, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Read a range of the blob, as of the last committed update.
+ *
+ * @param j pointer to the journal instance
+ * @param Offset offset on the blob
+ * @param pData receives the data
+ * @param Len length of the range
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_JRNL_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL
+ * @return NOR_OUT_OF_RANGE the range is beyond the blob
+ * @return NOR_FAIL failed to read
+ */
+nor_err_e NOR_JRNL_Read(nor_jrnl_t *j, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Compact now the oldest sectors that the next update would compact,
+ * leaving room for the largest update. Call it on idle
+ * time to take the erases out of the update path.
+ *
+ * @param j pointer to the journal instance
+ * @return NOR_OK everything was ok, or there was nothing to compact
+ * @return NOR_NOT_INITIALIZED call NOR_JRNL_Init first
+ * @return NOR_FAIL failed to program or erase
+ */
+nor_err_e NOR_JRNL_Compact(nor_jrnl_t *j);
+
+#endif /* NOR_JRNL_H_ */
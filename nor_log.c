@@ -0,0 +1,371 @@
+/*
+ * nor_log.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include "nor_log.h"
+
+/*
+ * Privates
+ */
+
+#define _LOG_SANITY_CHECK(l)		if (l == NULL)	return NOR_INVALID_PARAMS;					\
+									if (l->_internal.u8Mounted == 0)							\
+										return NOR_NOT_INITIALIZED;
+
+/* Functions */
+
+static uint32_t _log_sector_addr(nor_log_t *log, uint32_t Sector){
+	return (log->config.u32FirstSector + Sector) * log->nor->info.u16SectorSize;
+}
+
+static uint32_t _log_slot_addr(nor_log_t *log, uint32_t Sector, uint32_t Slot){
+	return _log_sector_addr(log, Sector) + sizeof(nor_log_header_t) + (Slot * log->_internal.u16SlotSize);
+}
+
+static uint8_t _log_read_header(nor_log_t *log, uint32_t Sector, uint32_t *pSeq){
+	nor_log_header_t header;
+
+	if (NOR_ReadBytes(log->nor, (uint8_t*)&header, _log_sector_addr(log, Sector), sizeof(header)) != NOR_OK){
+		return 0;
+	}
+	if (header.u32Magic != NOR_LOG_MAGIC || header.u32Seq != ~header.u32SeqInv){
+		return 0;
+	}
+	*pSeq = header.u32Seq;
+	return 1;
+}
+
+static uint32_t _log_read_timestamp(nor_log_t *log, uint32_t Sector, uint32_t Slot){
+	uint32_t Timestamp;
+
+	if (NOR_ReadBytes(log->nor, (uint8_t*)&Timestamp, _log_slot_addr(log, Sector, Slot), sizeof(Timestamp)) != NOR_OK){
+		return NOR_LOG_EMPTY_TIMESTAMP;
+	}
+	return Timestamp;
+}
+
+static uint16_t _log_count_slots(nor_log_t *log, uint32_t Sector){
+	uint32_t lo, hi, mid;
+
+	// slots are written in order, search the first empty one
+	lo = 0;
+	hi = log->_internal.u16SlotsPerSector;
+	while (lo < hi){
+		mid = (lo + hi) / 2;
+		if (_log_read_timestamp(log, Sector, mid) != NOR_LOG_EMPTY_TIMESTAMP){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	return (uint16_t)lo;
+}
+
+static nor_err_e _log_erase(nor_log_t *log, uint32_t Sector){
+	uint32_t Seq;
+
+	// avoid the erase when the sector was never written since the last erase
+	if (_log_read_header(log, Sector, &Seq) == 0 &&
+			NOR_IsEmptySector(log->nor, log->config.u32FirstSector + Sector, 0, log->nor->info.u16SectorSize) == NOR_OK){
+		return NOR_OK;
+	}
+	return NOR_EraseSector(log->nor, log->config.u32FirstSector + Sector);
+}
+
+static nor_err_e _log_open_sector(nor_log_t *log){
+	nor_log_header_t header;
+	uint32_t Next, Ahead, Seq;
+	nor_err_e err;
+
+	if (log->_internal.u8Empty){
+		Next = 0;
+		Seq = 0;
+		// nobody erased the first sector ahead of us
+		err = _log_erase(log, Next);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	else{
+		Next = (log->_internal.u32HeadSector + 1) % log->config.u32SectorCount;
+		Seq = log->_internal.u32HeadSeq + 1;
+	}
+	Ahead = (Next + 1) % log->config.u32SectorCount;
+	if (log->_internal.u8Empty == 0 && Ahead == log->_internal.u32TailSector){
+		// the oldest sector will be discarded
+		log->_internal.u32TailSector = (log->_internal.u32TailSector + 1) % log->config.u32SectorCount;
+		log->_internal.u32TailSeq++;
+	}
+	// erase the sector ahead first, so a valid header always has an erased sector after it
+	err = _log_erase(log, Ahead);
+	if (err != NOR_OK){
+		return err;
+	}
+	header.u32Magic = NOR_LOG_MAGIC;
+	header.u32Seq = Seq;
+	header.u32SeqInv = ~Seq;
+	err = NOR_WriteBytes(log->nor, (uint8_t*)&header, _log_sector_addr(log, Next), sizeof(header));
+	if (err != NOR_OK){
+		return err;
+	}
+	if (log->_internal.u8Empty){
+		log->_internal.u32TailSector = Next;
+		log->_internal.u32TailSeq = Seq;
+		log->_internal.u8Empty = 0;
+	}
+	log->_internal.u32HeadSector = Next;
+	log->_internal.u32HeadSeq = Seq;
+	log->_internal.u16HeadSlot = 0;
+
+	return NOR_OK;
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_LOG_Init(nor_log_t *log, nor_t *nor, uint32_t FirstSector, uint32_t SectorCount, uint16_t RecordSize){
+	if (log == NULL || nor == NULL || nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			SectorCount < 3 || RecordSize == 0 ||
+			(RecordSize + sizeof(uint32_t) + sizeof(nor_log_header_t)) > nor->info.u16SectorSize){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((FirstSector + SectorCount) > nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	log->nor = nor;
+	log->config.u32FirstSector = FirstSector;
+	log->config.u32SectorCount = SectorCount;
+	log->config.u16RecordSize = RecordSize;
+	log->_internal.u16SlotSize = RecordSize + sizeof(uint32_t);
+	log->_internal.u16SlotsPerSector = (nor->info.u16SectorSize - sizeof(nor_log_header_t)) / log->_internal.u16SlotSize;
+	log->_internal.u8Mounted = 0;
+	log->_internal.u8Empty = 1;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LOG_Format(nor_log_t *log){
+	uint32_t i;
+	nor_err_e err;
+
+	if (log == NULL || log->nor == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	log->_internal.u8Mounted = 0;
+	for (i=0 ; i<log->config.u32SectorCount ; i++){
+		err = NOR_EraseSector(log->nor, log->config.u32FirstSector + i);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	log->_internal.u8Empty = 1;
+	log->_internal.u8Mounted = 1;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LOG_Mount(nor_log_t *log){
+	uint32_t N, Ref, RefSeq, Seq, lo, hi, mid, HeadK;
+
+	if (log == NULL || log->nor == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	N = log->config.u32SectorCount;
+	log->_internal.u8Mounted = 0;
+	/*
+	 * Only the sector ahead of the head is erased after the first lap (two on
+	 * a power loss while opening a sector), so one of the first three sectors
+	 * holds a valid header, unless the log is empty.
+	 */
+	for (Ref=0 ; Ref<3 ; Ref++){
+		if (_log_read_header(log, Ref, &RefSeq)){
+			break;
+		}
+	}
+	if (Ref == 3){
+		log->_internal.u8Empty = 1;
+		log->_internal.u8Mounted = 1;
+		return NOR_OK;
+	}
+	/*
+	 * Walking from the reference, the sequence increments by one on every sector
+	 * until the head. Search the last sector where it holds.
+	 */
+	lo = 0;
+	hi = N;
+	while ((hi - lo) > 1){
+		mid = (lo + hi) / 2;
+		if (_log_read_header(log, (Ref + mid) % N, &Seq) && Seq == (RefSeq + mid)){
+			lo = mid;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	HeadK = lo;
+	/*
+	 * After the head comes the erased sectors, and then the oldest sectors of the
+	 * previous lap, up to the reference. Search the first valid one.
+	 */
+	lo = HeadK + 1;
+	hi = N;
+	while (lo < hi){
+		mid = (lo + hi) / 2;
+		if (_log_read_header(log, (Ref + mid) % N, &Seq)){
+			hi = mid;
+		}
+		else{
+			lo = mid + 1;
+		}
+	}
+	if (lo < N && _log_read_header(log, (Ref + lo) % N, &Seq) && Seq == (RefSeq + lo - N)){
+		log->_internal.u32TailSector = (Ref + lo) % N;
+		log->_internal.u32TailSeq = Seq;
+	}
+	else{
+		log->_internal.u32TailSector = Ref;
+		log->_internal.u32TailSeq = RefSeq;
+	}
+	log->_internal.u32HeadSector = (Ref + HeadK) % N;
+	log->_internal.u32HeadSeq = RefSeq + HeadK;
+	log->_internal.u16HeadSlot = _log_count_slots(log, log->_internal.u32HeadSector);
+	log->_internal.u8Empty = 0;
+	log->_internal.u8Mounted = 1;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LOG_Append(nor_log_t *log, uint32_t Timestamp, uint8_t *pData){
+	uint32_t Address;
+	nor_err_e err;
+
+	_LOG_SANITY_CHECK(log);
+
+	if (pData == NULL || Timestamp == NOR_LOG_EMPTY_TIMESTAMP){
+		return NOR_INVALID_PARAMS;
+	}
+	if (log->_internal.u8Empty || log->_internal.u16HeadSlot >= log->_internal.u16SlotsPerSector){
+		err = _log_open_sector(log);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	Address = _log_slot_addr(log, log->_internal.u32HeadSector, log->_internal.u16HeadSlot);
+	// the timestamp marks the slot as used, write it first
+	err = NOR_WriteBytes(log->nor, (uint8_t*)&Timestamp, Address, sizeof(Timestamp));
+	if (err != NOR_OK){
+		return err;
+	}
+	log->_internal.u16HeadSlot++;
+
+	return NOR_WriteBytes(log->nor, pData, Address + sizeof(Timestamp), log->config.u16RecordSize);
+}
+
+nor_err_e NOR_LOG_GetRange(nor_log_t *log, uint32_t *pFirstSeq, uint32_t *pCount){
+	uint32_t First, End;
+
+	_LOG_SANITY_CHECK(log);
+
+	if (pFirstSeq == NULL || pCount == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	if (log->_internal.u8Empty){
+		*pFirstSeq = 0;
+		*pCount = 0;
+		return NOR_OK;
+	}
+	First = log->_internal.u32TailSeq * log->_internal.u16SlotsPerSector;
+	End = (log->_internal.u32HeadSeq * log->_internal.u16SlotsPerSector) + log->_internal.u16HeadSlot;
+	*pFirstSeq = First;
+	*pCount = End - First;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LOG_Read(nor_log_t *log, uint32_t Seq, uint32_t *pTimestamp, uint8_t *pData){
+	uint32_t First, Count, Sector, Slot, Address;
+	nor_err_e err;
+
+	_LOG_SANITY_CHECK(log);
+
+	NOR_LOG_GetRange(log, &First, &Count);
+	if (Seq < First || (Seq - First) >= Count){
+		return NOR_OUT_OF_RANGE;
+	}
+	Sector = (log->_internal.u32TailSector + ((Seq / log->_internal.u16SlotsPerSector) - log->_internal.u32TailSeq)) % log->config.u32SectorCount;
+	Slot = Seq % log->_internal.u16SlotsPerSector;
+	Address = _log_slot_addr(log, Sector, Slot);
+	if (pTimestamp != NULL){
+		err = NOR_ReadBytes(log->nor, (uint8_t*)pTimestamp, Address, sizeof(uint32_t));
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	if (pData != NULL){
+		err = NOR_ReadBytes(log->nor, pData, Address + sizeof(uint32_t), log->config.u16RecordSize);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LOG_FindTimestamp(nor_log_t *log, uint32_t Timestamp, uint32_t *pSeq){
+	uint32_t First, Count, Sectors, Sector, Slots, lo, hi, mid, Seq;
+
+	_LOG_SANITY_CHECK(log);
+
+	if (pSeq == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	NOR_LOG_GetRange(log, &First, &Count);
+	if (Count == 0){
+		return NOR_OUT_OF_RANGE;
+	}
+	Sectors = log->_internal.u32HeadSeq - log->_internal.u32TailSeq + 1;
+	// search the last sector where the first record is older than Timestamp
+	lo = 0;
+	hi = Sectors;
+	while (lo < hi){
+		mid = (lo + hi) / 2;
+		Sector = (log->_internal.u32TailSector + mid) % log->config.u32SectorCount;
+		if (_log_read_timestamp(log, Sector, 0) < Timestamp){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	if (lo == 0){
+		*pSeq = First;
+		return NOR_OK;
+	}
+	// and the first record of this sector not older than Timestamp
+	mid = lo - 1;
+	Sector = (log->_internal.u32TailSector + mid) % log->config.u32SectorCount;
+	Slots = (mid == (Sectors - 1)) ? log->_internal.u16HeadSlot : log->_internal.u16SlotsPerSector;
+	lo = 0;
+	hi = Slots;
+	while (lo < hi){
+		Seq = (lo + hi) / 2;
+		if (_log_read_timestamp(log, Sector, Seq) < Timestamp){
+			lo = Seq + 1;
+		}
+		else{
+			hi = Seq;
+		}
+	}
+	Seq = ((log->_internal.u32TailSeq + mid) * log->_internal.u16SlotsPerSector) + lo;
+	if ((Seq - First) >= Count){
+		return NOR_OUT_OF_RANGE;
+	}
+	*pSeq = Seq;
+
+	return NOR_OK;
+}
@@ -0,0 +1,152 @@
+/*
+ * nor_log.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Circular append log on top of the NOR driver. Every sector of the log
+ *  region starts with a header carrying a sequence number, so the head and
+ *  the tail are found by binary search at mount, and records can be looked
+ *  up by sequence or timestamp without a linear scan.
+ */
+
+#ifndef NOR_LOG_H_
+#define NOR_LOG_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_LOG_MAGIC				0x474F4C4E	// "NLOG"
+#define NOR_LOG_EMPTY_TIMESTAMP		0xFFFFFFFF
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	uint32_t u32Magic;
+	uint32_t u32Seq;
+	uint32_t u32SeqInv;
+}nor_log_header_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+		uint16_t u16RecordSize;
+	}config;
+	struct{
+		uint16_t u16SlotSize;
+		uint16_t u16SlotsPerSector;
+		uint32_t u32TailSector;
+		uint32_t u32TailSeq;
+		uint32_t u32HeadSector;
+		uint32_t u32HeadSeq;
+		uint16_t u16HeadSlot;
+		uint8_t u8Empty;
+		uint8_t u8Mounted;
+	}_internal;
+}nor_log_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Configure a log instance over a region of sectors. The log is not
+ * usable until NOR_LOG_Mount or NOR_LOG_Format is called.
+ *
+ * Every record uses a slot of (4 + RecordSize) bytes, where the first 4 bytes
+ * stores the timestamp. Records are never splitted between sectors.
+ *
+ * @param log pointer to the log instance
+ * @param nor pointer to an initialized Nor Instance
+ * @param FirstSector first sector of the log region
+ * @param SectorCount number of sectors on the log region, at least 3
+ * @param RecordSize size, in bytes, of the record payload
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was NULL or the geometry is invalid
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ */
+nor_err_e NOR_LOG_Init(nor_log_t *log, nor_t *nor, uint32_t FirstSector, uint32_t SectorCount, uint16_t RecordSize);
+
+/**
+ * @brief Erase the entire log region and start an empty log.
+ *
+ * @param log pointer to the log instance
+ * @return NOR_OK everything was ok
+ * @return NOR_FAIL the device failed to erase or program
+ */
+nor_err_e NOR_LOG_Format(nor_log_t *log);
+
+/**
+ * @brief Find the head and tail of the log, using O(log SectorCount) header
+ * reads and O(log SlotsPerSector) record reads.
+ *
+ * @param log pointer to the log instance
+ * @return NOR_OK everything was ok, the log can be empty
+ * @return NOR_FAIL the log region doesn't contains a valid log, format it
+ */
+nor_err_e NOR_LOG_Mount(nor_log_t *log);
+
+/**
+ * @brief Append a record to the head of the log. When the head sector is full,
+ * the log moves to the next sector, that was erased previously, and erases
+ * the sector ahead of it, discarding the oldest records when needed.
+ *
+ * @param log pointer to the log instance
+ * @param Timestamp timestamp of the record, must be non decreasing and not
+ * equal to NOR_LOG_EMPTY_TIMESTAMP
+ * @param pData RecordSize bytes of payload
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid
+ * @return NOR_NOT_INITIALIZED log wasn't mounted or formatted
+ * @return NOR_FAIL the device failed to erase or program
+ */
+nor_err_e NOR_LOG_Append(nor_log_t *log, uint32_t Timestamp, uint8_t *pData);
+
+/**
+ * @brief Get the range of sequence numbers available on the log.
+ *
+ * @param log pointer to the log instance
+ * @param pFirstSeq sequence of the oldest record
+ * @param pCount number of records, the newest has sequence (FirstSeq + Count - 1)
+ * @return NOR_OK everything was ok
+ */
+nor_err_e NOR_LOG_GetRange(nor_log_t *log, uint32_t *pFirstSeq, uint32_t *pCount);
+
+/**
+ * @brief Read a record by your sequence number.
+ *
+ * @param log pointer to the log instance
+ * @param Seq sequence number of the record
+ * @param pTimestamp timestamp of the record, can be NULL
+ * @param pData buffer with RecordSize bytes to receive the payload, can be NULL
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE the record isn't on the log anymore, or wasn't written yet
+ */
+nor_err_e NOR_LOG_Read(nor_log_t *log, uint32_t Seq, uint32_t *pTimestamp, uint8_t *pData);
+
+/**
+ * @brief Find the first record with timestamp greater or equal to Timestamp,
+ * using binary search over the sectors and over the records of the sector.
+ *
+ * @param log pointer to the log instance
+ * @param Timestamp timestamp to search
+ * @param pSeq sequence number of the record found
+ * @return NOR_OK everything was ok
+ * @return NOR_OUT_OF_RANGE all records are older than Timestamp, or the log is empty
+ */
+nor_err_e NOR_LOG_FindTimestamp(nor_log_t *log, uint32_t Timestamp, uint32_t *pSeq);
+
+#endif /* NOR_LOG_H_ */
@@ -0,0 +1,534 @@
+/*
+ * nor_lz.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_lz.h"
+#include "nor_crc.h"
+
+/*
+ * Privates
+ */
+
+#define _LZ_SANITY_CHECK(l)			if (l == NULL)	return NOR_INVALID_PARAMS;					\
+									if (l->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+// LZ4 block format limits, the last match starts 12 bytes before the end
+// and the last 5 bytes are always literals
+#define _LZ_MIN_MATCH				4
+#define _LZ_MF_LIMIT				12
+#define _LZ_LAST_LITERALS			5
+#define _LZ_MAX_OFFSET				0xFFFF
+
+#define _LZ_NONE					0xFFFFFFFF
+
+/* Enumerates */
+
+enum _lz_hdr_e{
+	_LZ_HDR_VALID,
+	_LZ_HDR_ERASED,
+	_LZ_HDR_TORN,
+	_LZ_HDR_END,
+};
+
+/* Functions */
+
+static uint32_t _lz_read32(const uint8_t *p){
+	return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t _lz_hash(uint32_t Value){
+	return (uint32_t)(Value * 2654435761U) >> (32 - NOR_LZ_HASH_BITS);
+}
+
+static uint8_t *_lz_put_len(uint8_t *op, uint32_t Len){
+	while (Len >= 255){
+		*op++ = 255;
+		Len -= 255;
+	}
+	*op++ = Len;
+	return op;
+}
+
+/*
+ * Greedy LZ4 block compressor. Returns the compressed size, or 0 if it
+ * doesn't fit on DstMax bytes.
+ */
+static uint32_t _lz_compress(nor_lz_t *lz, const uint8_t *pSrc, uint32_t SrcLen, uint8_t *pDst, uint32_t DstMax){
+	uint16_t *pHash = lz->_internal.u16Hash;
+	uint8_t *op = pDst, *token;
+	uint32_t ip = 0, Anchor = 0, Ref, h, LitLen, MatchLen, MatchLimit;
+
+	memset(pHash, 0, sizeof(lz->_internal.u16Hash));
+	if (SrcLen > _LZ_MF_LIMIT){
+		MatchLimit = SrcLen - _LZ_LAST_LITERALS;
+		while ((ip + _LZ_MF_LIMIT) <= SrcLen){
+			h = _lz_hash(_lz_read32(&pSrc[ip]));
+			Ref = pHash[h];
+			pHash[h] = ip;
+			if (Ref >= ip || (ip - Ref) > _LZ_MAX_OFFSET || _lz_read32(&pSrc[Ref]) != _lz_read32(&pSrc[ip])){
+				// skip faster over data that doesn't compress
+				ip += 1 + ((ip - Anchor) >> 6);
+				continue;
+			}
+			MatchLen = _LZ_MIN_MATCH;
+			while ((ip + MatchLen) < MatchLimit && pSrc[Ref + MatchLen] == pSrc[ip + MatchLen]){
+				MatchLen++;
+			}
+			LitLen = ip - Anchor;
+			if ((uint32_t)(op - pDst) + 1 + (LitLen / 255) + 1 + LitLen + 2 + ((MatchLen - _LZ_MIN_MATCH) / 255) + 1 > DstMax){
+				return 0;
+			}
+			token = op++;
+			*token = (LitLen >= 15) ? 0xF0 : (LitLen << 4);
+			if (LitLen >= 15){
+				op = _lz_put_len(op, LitLen - 15);
+			}
+			memcpy(op, &pSrc[Anchor], LitLen);
+			op += LitLen;
+			*op++ = (ip - Ref) & 0xFF;
+			*op++ = (ip - Ref) >> 8;
+			if ((MatchLen - _LZ_MIN_MATCH) >= 15){
+				*token |= 0x0F;
+				op = _lz_put_len(op, MatchLen - _LZ_MIN_MATCH - 15);
+			}
+			else{
+				*token |= (MatchLen - _LZ_MIN_MATCH);
+			}
+			ip += MatchLen;
+			Anchor = ip;
+			if ((ip + _LZ_MF_LIMIT) <= SrcLen){
+				pHash[_lz_hash(_lz_read32(&pSrc[ip - 2]))] = ip - 2;
+			}
+		}
+	}
+	// the last sequence has only literals
+	LitLen = SrcLen - Anchor;
+	if ((uint32_t)(op - pDst) + 1 + (LitLen / 255) + 1 + LitLen > DstMax){
+		return 0;
+	}
+	if (LitLen >= 15){
+		*op++ = 0xF0;
+		op = _lz_put_len(op, LitLen - 15);
+	}
+	else{
+		*op++ = (LitLen << 4);
+	}
+	memcpy(op, &pSrc[Anchor], LitLen);
+	op += LitLen;
+
+	return (uint32_t)(op - pDst);
+}
+
+/*
+ * LZ4 block decompressor, checking every length against the buffers. Returns
+ * the decompressed size, or 0 if the block is corrupted.
+ */
+static uint32_t _lz_decompress(const uint8_t *pSrc, uint32_t SrcLen, uint8_t *pDst, uint32_t DstLen){
+	uint32_t ip = 0, op = 0, LitLen, MatchLen, Offset;
+	uint8_t Token, b;
+
+	while (ip < SrcLen){
+		Token = pSrc[ip++];
+		LitLen = Token >> 4;
+		if (LitLen == 15){
+			do{
+				if (ip >= SrcLen){
+					return 0;
+				}
+				b = pSrc[ip++];
+				LitLen += b;
+			}while (b == 255);
+		}
+		if (LitLen > (SrcLen - ip) || LitLen > (DstLen - op)){
+			return 0;
+		}
+		memcpy(&pDst[op], &pSrc[ip], LitLen);
+		ip += LitLen;
+		op += LitLen;
+		if (ip == SrcLen){
+			break;
+		}
+		if ((SrcLen - ip) < 2){
+			return 0;
+		}
+		Offset = pSrc[ip] | ((uint32_t)pSrc[ip + 1] << 8);
+		ip += 2;
+		if (Offset == 0 || Offset > op){
+			return 0;
+		}
+		MatchLen = Token & 0x0F;
+		if (MatchLen == 15){
+			do{
+				if (ip >= SrcLen){
+					return 0;
+				}
+				b = pSrc[ip++];
+				MatchLen += b;
+			}while (b == 255);
+		}
+		MatchLen += _LZ_MIN_MATCH;
+		if (MatchLen > (DstLen - op)){
+			return 0;
+		}
+		// byte by byte, the match can overlap the output
+		while (MatchLen--){
+			pDst[op] = pDst[op - Offset];
+			op++;
+		}
+	}
+
+	return op;
+}
+
+static enum _lz_hdr_e _lz_read_header(nor_lz_t *lz, uint32_t Address, uint32_t Expected, nor_lz_chunk_t *pHdr){
+	uint8_t *p = (uint8_t*)pHdr;
+	uint32_t i;
+
+	if ((Address + sizeof(nor_lz_chunk_t)) > lz->_internal.u32End){
+		return _LZ_HDR_END;
+	}
+	if (NOR_ReadBytes(lz->nor, p, Address, sizeof(nor_lz_chunk_t)) != NOR_OK){
+		return _LZ_HDR_END;
+	}
+	for (i=0 ; i<sizeof(nor_lz_chunk_t) && p[i] == 0xFF ; i++);
+	if (i == sizeof(nor_lz_chunk_t)){
+		return _LZ_HDR_ERASED;
+	}
+	if (pHdr->u16Magic != NOR_LZ_MAGIC || (pHdr->u16Flags != NOR_LZ_FLAG_VALID && pHdr->u16Flags != NOR_LZ_FLAG_DISCARDED) ||
+			pHdr->u16RawLen == 0 || pHdr->u16RawLen > lz->config.u16ChunkSize ||
+			pHdr->u16CompLen == 0 || pHdr->u16CompLen > pHdr->u16RawLen || pHdr->u32Offset != Expected ||
+			(Address + sizeof(nor_lz_chunk_t) + pHdr->u16CompLen) > lz->_internal.u32End){
+		return _LZ_HDR_TORN;
+	}
+	return _LZ_HDR_VALID;
+}
+
+/*
+ * Read the header of the chunk on *pAddress. A torn header hides the size of
+ * the chunk, so the writer moved to the next sector, and so does the walk.
+ */
+static enum _lz_hdr_e _lz_next(nor_lz_t *lz, uint32_t *pAddress, uint32_t Expected, nor_lz_chunk_t *pHdr){
+	enum _lz_hdr_e st;
+
+	while ((st = _lz_read_header(lz, *pAddress, Expected, pHdr)) == _LZ_HDR_TORN){
+		*pAddress += lz->nor->info.u16SectorSize - (*pAddress % lz->nor->info.u16SectorSize);
+	}
+	return st;
+}
+
+static void _lz_index_add(nor_lz_t *lz, uint32_t Offset, uint32_t Address){
+	uint16_t i;
+
+	if ((lz->_internal.u32Chunks % lz->_internal.u32Stride) == 0){
+		if (lz->_internal.u16IndexCount == lz->config.u16IndexSize){
+			// keep every other entry, doubling the stride
+			for (i=0 ; i<((lz->_internal.u16IndexCount + 1) / 2) ; i++){
+				lz->config.pIndex[i] = lz->config.pIndex[2 * i];
+			}
+			lz->_internal.u16IndexCount = (lz->_internal.u16IndexCount + 1) / 2;
+			lz->_internal.u32Stride *= 2;
+		}
+		if ((lz->_internal.u32Chunks % lz->_internal.u32Stride) == 0){
+			lz->config.pIndex[lz->_internal.u16IndexCount].u32Offset = Offset;
+			lz->config.pIndex[lz->_internal.u16IndexCount].u32Address = Address;
+			lz->_internal.u16IndexCount++;
+		}
+	}
+	lz->_internal.u32Chunks++;
+}
+
+static void _lz_discard(nor_lz_t *lz, uint32_t Address){
+	uint16_t Flags = NOR_LZ_FLAG_DISCARDED;
+
+	NOR_WriteBytes(lz->nor, (uint8_t*)&Flags, Address + offsetof(nor_lz_chunk_t, u16Flags), sizeof(Flags));
+}
+
+static nor_err_e _lz_program(nor_lz_t *lz){
+	nor_lz_chunk_t hdr;
+	uint8_t *pData = lz->config.pCompBuffer + sizeof(nor_lz_chunk_t);
+	uint32_t CompLen, Len;
+	nor_err_e err;
+
+	if (lz->_internal.u16RawLen == 0){
+		return NOR_OK;
+	}
+	CompLen = _lz_compress(lz, lz->config.pRawBuffer, lz->_internal.u16RawLen, pData, lz->_internal.u16RawLen - 1);
+	if (CompLen == 0){
+		memcpy(pData, lz->config.pRawBuffer, lz->_internal.u16RawLen);
+		CompLen = lz->_internal.u16RawLen;
+		lz->stats.u32RawChunks++;
+	}
+	Len = sizeof(nor_lz_chunk_t) + CompLen;
+	if ((lz->_internal.u32WriteAddr + Len) > lz->_internal.u32End){
+		return NOR_OUT_OF_RANGE;
+	}
+	hdr.u16Magic = NOR_LZ_MAGIC;
+	hdr.u16Flags = NOR_LZ_FLAG_VALID;
+	hdr.u16RawLen = lz->_internal.u16RawLen;
+	hdr.u16CompLen = CompLen;
+	hdr.u32Offset = lz->_internal.u32Size;
+	hdr.u32Crc = NOR_CRC32(0, pData, CompLen);
+	memcpy(lz->config.pCompBuffer, &hdr, sizeof(hdr));
+	err = NOR_WriteBytes(lz->nor, lz->config.pCompBuffer, lz->_internal.u32WriteAddr, Len);
+	if (err != NOR_OK){
+		// skip the bad chunk, the data stays on RAM for the next try
+		_lz_discard(lz, lz->_internal.u32WriteAddr);
+		lz->_internal.u32WriteAddr += Len;
+		return NOR_FAIL;
+	}
+	_lz_index_add(lz, lz->_internal.u32Size, lz->_internal.u32WriteAddr);
+	lz->_internal.u32LastAddr = lz->_internal.u32WriteAddr;
+	lz->_internal.u32WriteAddr += Len;
+	lz->_internal.u32Size += lz->_internal.u16RawLen;
+	lz->stats.u32RawBytes += lz->_internal.u16RawLen;
+	lz->stats.u32StoredBytes += Len;
+	lz->stats.u32Chunks++;
+	lz->_internal.u16RawLen = 0;
+
+	return NOR_OK;
+}
+
+static nor_err_e _lz_load(nor_lz_t *lz, uint32_t Offset){
+	nor_lz_chunk_t hdr;
+	uint32_t Address, Expected, lo, hi, mid;
+
+	if (lz->_internal.u16CacheLen > 0 && Offset >= lz->_internal.u32CacheOffset &&
+			Offset < (lz->_internal.u32CacheOffset + lz->_internal.u16CacheLen)){
+		return NOR_OK;
+	}
+	// the last index entry before the offset
+	lo = 0;
+	hi = lz->_internal.u16IndexCount;
+	while ((hi - lo) > 1){
+		mid = (lo + hi) / 2;
+		if (lz->config.pIndex[mid].u32Offset <= Offset){
+			lo = mid;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	Address = lz->config.pIndex[lo].u32Address;
+	Expected = lz->config.pIndex[lo].u32Offset;
+	// sequential reads continue from the cached chunk
+	if (lz->_internal.u16CacheLen > 0 && lz->_internal.u32CacheOffset <= Offset && lz->_internal.u32CacheOffset > Expected){
+		Address = lz->_internal.u32CacheAddr;
+		Expected = lz->_internal.u32CacheOffset;
+	}
+	lz->_internal.u16CacheLen = 0;
+	while (1){
+		if (_lz_next(lz, &Address, Expected, &hdr) != _LZ_HDR_VALID){
+			return NOR_FAIL;
+		}
+		if (hdr.u16Flags == NOR_LZ_FLAG_VALID){
+			if (Offset < (Expected + hdr.u16RawLen)){
+				break;
+			}
+			Expected += hdr.u16RawLen;
+		}
+		Address += sizeof(nor_lz_chunk_t) + hdr.u16CompLen;
+	}
+	if (NOR_ReadBytes(lz->nor, lz->config.pCompBuffer, Address + sizeof(nor_lz_chunk_t), hdr.u16CompLen) != NOR_OK){
+		return NOR_FAIL;
+	}
+	if (NOR_CRC32(0, lz->config.pCompBuffer, hdr.u16CompLen) != hdr.u32Crc){
+		return NOR_FAIL;
+	}
+	if (hdr.u16CompLen == hdr.u16RawLen){
+		memcpy(lz->config.pReadBuffer, lz->config.pCompBuffer, hdr.u16RawLen);
+	}
+	else if (_lz_decompress(lz->config.pCompBuffer, hdr.u16CompLen, lz->config.pReadBuffer, hdr.u16RawLen) != hdr.u16RawLen){
+		return NOR_FAIL;
+	}
+	lz->stats.u32ChunksDecompressed++;
+	lz->_internal.u32CacheAddr = Address;
+	lz->_internal.u32CacheOffset = Expected;
+	lz->_internal.u16CacheLen = hdr.u16RawLen;
+
+	return NOR_OK;
+}
+
+static void _lz_reset(nor_lz_t *lz){
+	lz->_internal.u32WriteAddr = lz->_internal.u32Start;
+	lz->_internal.u32Size = 0;
+	lz->_internal.u32LastAddr = _LZ_NONE;
+	lz->_internal.u32Chunks = 0;
+	lz->_internal.u32Stride = 1;
+	lz->_internal.u16IndexCount = 0;
+	lz->_internal.u16RawLen = 0;
+	lz->_internal.u16CacheLen = 0;
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_LZ_Init(nor_lz_t *lz){
+	nor_lz_chunk_t hdr, LastHdr;
+	uint32_t Address, Crc;
+
+	if (lz == NULL || lz->nor == NULL || lz->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			lz->config.u32SectorCount == 0 || lz->config.u16ChunkSize == 0 || lz->config.pRawBuffer == NULL ||
+			lz->config.pReadBuffer == NULL || lz->config.pCompBuffer == NULL ||
+			lz->config.pIndex == NULL || lz->config.u16IndexSize == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((lz->config.u32FirstSector + lz->config.u32SectorCount) > lz->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	lz->_internal.u16Initialized = 0;
+	lz->_internal.u32Start = lz->config.u32FirstSector * lz->nor->info.u16SectorSize;
+	lz->_internal.u32End = lz->_internal.u32Start + (lz->config.u32SectorCount * lz->nor->info.u16SectorSize);
+	memset(&lz->stats, 0, sizeof(lz->stats));
+	memset(&LastHdr, 0, sizeof(LastHdr));
+	_lz_reset(lz);
+
+	Address = lz->_internal.u32Start;
+	while (_lz_next(lz, &Address, lz->_internal.u32Size, &hdr) == _LZ_HDR_VALID){
+		if (hdr.u16Flags == NOR_LZ_FLAG_VALID){
+			_lz_index_add(lz, lz->_internal.u32Size, Address);
+			lz->_internal.u32LastAddr = Address;
+			lz->_internal.u32Size += hdr.u16RawLen;
+			LastHdr = hdr;
+		}
+		Address += sizeof(nor_lz_chunk_t) + hdr.u16CompLen;
+	}
+	lz->_internal.u32WriteAddr = (Address < lz->_internal.u32End) ? Address : lz->_internal.u32End;
+	// only the last chunk can be torn by a power loss
+	if (lz->_internal.u32LastAddr != _LZ_NONE){
+		Crc = 0;
+		if (NOR_Crc32Range(lz->nor, lz->_internal.u32LastAddr + sizeof(nor_lz_chunk_t), LastHdr.u16CompLen, &Crc) != NOR_OK){
+			return NOR_FAIL;
+		}
+		if (Crc != LastHdr.u32Crc){
+			_lz_discard(lz, lz->_internal.u32LastAddr);
+			lz->_internal.u32Size -= LastHdr.u16RawLen;
+			lz->_internal.u32Chunks--;
+			if (lz->_internal.u16IndexCount > 0 &&
+					lz->config.pIndex[lz->_internal.u16IndexCount - 1].u32Address == lz->_internal.u32LastAddr){
+				lz->_internal.u16IndexCount--;
+			}
+		}
+	}
+	lz->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LZ_Format(nor_lz_t *lz){
+	uint32_t Sector, End, SectorsPerBlock;
+	nor_err_e err;
+
+	_LZ_SANITY_CHECK(lz);
+
+	Sector = lz->config.u32FirstSector;
+	End = Sector + lz->config.u32SectorCount;
+	SectorsPerBlock = lz->nor->info.u32BlockSize / lz->nor->info.u16SectorSize;
+	while (Sector < End){
+		if ((Sector % SectorsPerBlock) == 0 && (End - Sector) >= SectorsPerBlock){
+			err = NOR_EraseBlock(lz->nor, Sector / SectorsPerBlock);
+			Sector += SectorsPerBlock;
+		}
+		else{
+			err = NOR_EraseSector(lz->nor, Sector);
+			Sector++;
+		}
+		if (err != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	_lz_reset(lz);
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LZ_Append(nor_lz_t *lz, uint8_t *pData, uint32_t Len){
+	uint32_t n;
+	nor_err_e err;
+
+	_LZ_SANITY_CHECK(lz);
+
+	if (pData == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	while (Len > 0){
+		if (lz->_internal.u16RawLen == lz->config.u16ChunkSize){
+			err = _lz_program(lz);
+			if (err != NOR_OK){
+				return err;
+			}
+		}
+		n = lz->config.u16ChunkSize - lz->_internal.u16RawLen;
+		if (n > Len){
+			n = Len;
+		}
+		memcpy(&lz->config.pRawBuffer[lz->_internal.u16RawLen], pData, n);
+		lz->_internal.u16RawLen += n;
+		pData += n;
+		Len -= n;
+	}
+	if (lz->_internal.u16RawLen == lz->config.u16ChunkSize){
+		return _lz_program(lz);
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LZ_Flush(nor_lz_t *lz){
+	_LZ_SANITY_CHECK(lz);
+
+	return _lz_program(lz);
+}
+
+nor_err_e NOR_LZ_Read(nor_lz_t *lz, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	uint32_t n;
+	nor_err_e err;
+
+	_LZ_SANITY_CHECK(lz);
+
+	if (pData == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	if (Offset > (lz->_internal.u32Size + lz->_internal.u16RawLen) ||
+			Len > (lz->_internal.u32Size + lz->_internal.u16RawLen - Offset)){
+		return NOR_OUT_OF_RANGE;
+	}
+	while (Len > 0){
+		if (Offset >= lz->_internal.u32Size){
+			// not programmed yet
+			memcpy(pData, &lz->config.pRawBuffer[Offset - lz->_internal.u32Size], Len);
+			break;
+		}
+		err = _lz_load(lz, Offset);
+		if (err != NOR_OK){
+			return err;
+		}
+		n = lz->_internal.u32CacheOffset + lz->_internal.u16CacheLen - Offset;
+		if (n > Len){
+			n = Len;
+		}
+		memcpy(pData, &lz->config.pReadBuffer[Offset - lz->_internal.u32CacheOffset], n);
+		pData += n;
+		Offset += n;
+		Len -= n;
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_LZ_GetSize(nor_lz_t *lz, uint32_t *pSize){
+	_LZ_SANITY_CHECK(lz);
+
+	if (pSize == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	*pSize = lz->_internal.u32Size + lz->_internal.u16RawLen;
+
+	return NOR_OK;
+}
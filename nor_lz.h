@@ -0,0 +1,194 @@
+/*
+ * nor_lz.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Compressed append-only region. The appended data is collected on a RAM
+ *  chunk, compressed with a LZ4 block compatible codec and programmed with a
+ *  small header carrying the logical offset, so the chunks are found by a
+ *  walk over the headers. A sparse index on RAM, keeping every Nth chunk,
+ *  makes NOR_LZ_Read decompress only the chunks touched by the range.
+ *
+ *  The region is erased by NOR_LZ_Format and filled only once, the appends
+ *  fail with NOR_OUT_OF_RANGE when it's full. A chunk torn by a power loss
+ *  is discarded on the next NOR_LZ_Init.
+ */
+
+#ifndef NOR_LZ_H_
+#define NOR_LZ_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_LZ_MAGIC				0x5A4C	// "LZ"
+
+// Flags of the chunk header, cleared when the chunk is discarded
+#define NOR_LZ_FLAG_VALID			0xFFFF
+#define NOR_LZ_FLAG_DISCARDED		0x0000
+
+// Size of the hash table of the compressor, in entries of 16 bits
+#ifndef NOR_LZ_HASH_BITS
+#define NOR_LZ_HASH_BITS			10
+#endif
+
+// Size of config.pCompBuffer, for a ChunkSize
+#define NOR_LZ_COMP_BUFFER_SIZE(c)	((c) + sizeof(nor_lz_chunk_t))
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	uint16_t u16Magic;
+	uint16_t u16Flags;
+	uint16_t u16RawLen;
+	// equal to u16RawLen when the chunk is stored without compression
+	uint16_t u16CompLen;
+	// logical offset of the first byte of the chunk
+	uint32_t u32Offset;
+	// CRC32 of the stored data
+	uint32_t u32Crc;
+}nor_lz_chunk_t;
+
+typedef struct{
+	uint32_t u32Offset;
+	uint32_t u32Address;
+}nor_lz_index_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+		// logical bytes of a chunk, up to 65535
+		uint16_t u16ChunkSize;
+		// ChunkSize bytes, appended data not programmed yet
+		uint8_t *pRawBuffer;
+		// ChunkSize bytes, the last chunk decompressed
+		uint8_t *pReadBuffer;
+		// NOR_LZ_COMP_BUFFER_SIZE(ChunkSize) bytes
+		uint8_t *pCompBuffer;
+		// the index keeps every Nth chunk, N grows when the index is full
+		nor_lz_index_t *pIndex;
+		uint16_t u16IndexSize;
+	}config;
+	struct{
+		// logical bytes programmed
+		uint32_t u32RawBytes;
+		// bytes programmed, with the headers
+		uint32_t u32StoredBytes;
+		uint32_t u32Chunks;
+		// chunks that didn't compress, stored as they are
+		uint32_t u32RawChunks;
+		uint32_t u32ChunksDecompressed;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		uint32_t u32Start;
+		uint32_t u32End;
+		uint32_t u32WriteAddr;
+		uint32_t u32Size;
+		uint32_t u32LastAddr;
+		uint32_t u32Chunks;
+		uint32_t u32Stride;
+		uint16_t u16IndexCount;
+		uint16_t u16RawLen;
+		uint32_t u32CacheAddr;
+		uint32_t u32CacheOffset;
+		uint16_t u16CacheLen;
+		uint16_t u16Hash[1 << NOR_LZ_HASH_BITS];
+	}_internal;
+}nor_lz_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Mount the compressed region, walking the chunk headers to build the
+ * index and find the end. A torn chunk, left by a power loss, is discarded.
+ * Fill the nor and config fields before call this function, and call
+ * NOR_LZ_Format on the first use of the region.
+ *
+ * @param lz pointer to the compressed region instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ * @return NOR_FAIL failed to access the device
+ */
+nor_err_e NOR_LZ_Init(nor_lz_t *lz);
+
+/**
+ * @brief Erase the region, discarding all the data.
+ *
+ * @param lz pointer to the compressed region instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_LZ_Init first
+ * @return NOR_FAIL failed to erase
+ */
+nor_err_e NOR_LZ_Format(nor_lz_t *lz);
+
+/**
+ * @brief Append data to the region. The data is kept on the RAM chunk, and
+ * every full chunk is compressed and programmed.
+ *
+ * @param lz pointer to the compressed region instance
+ * @param pData data to append
+ * @param Len length of the data
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_LZ_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL
+ * @return NOR_OUT_OF_RANGE the region is full, the data that fit was appended
+ * @return NOR_FAIL failed to program
+ */
+nor_err_e NOR_LZ_Append(nor_lz_t *lz, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Compress and program the data on the RAM chunk, even if it isn't full.
+ * Call it before a power off, small chunks compress worse.
+ *
+ * @param lz pointer to the compressed region instance
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_LZ_Init first
+ * @return NOR_OUT_OF_RANGE the region is full
+ * @return NOR_FAIL failed to program
+ */
+nor_err_e NOR_LZ_Flush(nor_lz_t *lz);
+
+/**
+ * @brief Read a logical range, decompressing only the chunks touched by it.
+ * The data not flushed yet is read from the RAM chunk.
+ *
+ * @param lz pointer to the compressed region instance
+ * @param Offset logical offset
+ * @param pData receives the data
+ * @param Len length of the range
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_LZ_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL
+ * @return NOR_OUT_OF_RANGE the range is beyond the appended data
+ * @return NOR_FAIL a chunk is corrupted, or failed to read
+ */
+nor_err_e NOR_LZ_Read(nor_lz_t *lz, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Get the logical size of the region, with the data not flushed yet.
+ *
+ * @param lz pointer to the compressed region instance
+ * @param pSize receives the size in bytes
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_LZ_Init first
+ */
+nor_err_e NOR_LZ_GetSize(nor_lz_t *lz, uint32_t *pSize);
+
+#endif /* NOR_LZ_H_ */
@@ -0,0 +1,294 @@
+/*
+ * nor_part.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_part.h"
+
+/*
+ * Privates
+ */
+
+#define _PART_SANITY_CHECK(p)		if (p == NULL)	return NOR_INVALID_PARAMS;					\
+									if (p->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+// Offset and Len checked against the size computed on init
+#define _PART_IN_RANGE(p, o, l)		((o) < (p)->_internal.u32Size && (l) <= ((p)->_internal.u32Size - (o)))
+
+/* Functions */
+
+static uint8_t _part_overlaps(uint32_t Offset, uint32_t Len, uint32_t Start, uint32_t Size){
+	return (Offset < (Start + Size) && Start < (Offset + Len));
+}
+
+static nor_err_e _part_program(nor_part_t *part, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	part->stats.u32Programs++;
+	if (part->policy.u8Flags & NOR_PART_POSTED){
+		return NOR_WriteBytesPosted(part->_internal.nor, pData, part->_internal.u32Start + Offset, Len);
+	}
+	return NOR_WriteBytes(part->_internal.nor, pData, part->_internal.u32Start + Offset, Len);
+}
+
+static nor_err_e _part_flush(nor_part_t *part){
+	nor_err_e err;
+
+	if (part->_internal.u32PendingLen == 0){
+		return NOR_OK;
+	}
+	err = _part_program(part, part->_internal.u32PendingOffset, part->policy.pWriteBuffer, part->_internal.u32PendingLen);
+	part->_internal.u32PendingLen = 0;
+	// the buffer is reused by the next write, the program must be done
+	if (err == NOR_OK && (part->policy.u8Flags & NOR_PART_POSTED)){
+		err = NOR_Sync(part->_internal.nor);
+	}
+	return err;
+}
+
+/*
+ * Apply a program to the cache window, as the flash does: bits are only
+ * cleared.
+ */
+static void _part_cache_program(nor_part_t *part, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	uint32_t Start, End, i;
+
+	if (!part->_internal.u8CacheValid ||
+			!_part_overlaps(Offset, Len, part->_internal.u32CacheOffset, part->policy.u32CacheSize)){
+		return;
+	}
+	Start = (Offset > part->_internal.u32CacheOffset) ? Offset : part->_internal.u32CacheOffset;
+	End = Offset + Len;
+	if (End > (part->_internal.u32CacheOffset + part->policy.u32CacheSize)){
+		End = part->_internal.u32CacheOffset + part->policy.u32CacheSize;
+	}
+	for (i=Start ; i<End ; i++){
+		part->policy.pCache[i - part->_internal.u32CacheOffset] &= pData[i - Offset];
+	}
+}
+
+static nor_err_e _part_cache_fill(nor_part_t *part, uint32_t Offset){
+	// aligned to the window size, and kept inside the partition
+	Offset -= (Offset % part->policy.u32CacheSize);
+	if ((Offset + part->policy.u32CacheSize) > part->_internal.u32Size){
+		Offset = part->_internal.u32Size - part->policy.u32CacheSize;
+	}
+	part->_internal.u8CacheValid = 0;
+	if (NOR_ReadBytes(part->_internal.nor, part->policy.pCache, part->_internal.u32Start + Offset, part->policy.u32CacheSize) != NOR_OK){
+		return NOR_FAIL;
+	}
+	part->_internal.u32CacheOffset = Offset;
+	part->_internal.u8CacheValid = 1;
+
+	return NOR_OK;
+}
+
+static uint32_t _part_erase_size(nor_t *nor, nor_erase_method_e Method){
+	switch (Method){
+	case NOR_ERASE_4K:
+		return nor->info.u16SectorSize;
+	case NOR_ERASE_32K:
+		return nor->info.u32BlockSize / 2;
+	case NOR_ERASE_64K:
+		return nor->info.u32BlockSize;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_PART_Init(nor_ptable_t *pt){
+	nor_part_t *part;
+	uint32_t i, k;
+
+	if (pt == NULL || pt->nor == NULL || pt->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			pt->config.pParts == NULL || pt->config.u32Count == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	pt->_internal.u16Initialized = 0;
+	for (i=0 ; i<pt->config.u32Count ; i++){
+		part = &pt->config.pParts[i];
+		part->_internal.u16Initialized = 0;
+		if (part->pName == NULL || part->u32SectorCount == 0 ||
+				(part->policy.pCache != NULL && part->policy.u32CacheSize == 0) ||
+				(part->policy.pWriteBuffer != NULL && part->policy.u32WriteBufferSize == 0)){
+			return NOR_INVALID_PARAMS;
+		}
+		if ((part->u32FirstSector + part->u32SectorCount) > pt->nor->info.u32SectorCount){
+			return NOR_OUT_OF_RANGE;
+		}
+		part->_internal.u32Start = part->u32FirstSector * pt->nor->info.u16SectorSize;
+		part->_internal.u32Size = part->u32SectorCount * pt->nor->info.u16SectorSize;
+		part->_internal.u32EraseSize = _part_erase_size(pt->nor, part->policy.EraseMethod);
+		if (part->_internal.u32EraseSize == 0 || (part->_internal.u32Start % part->_internal.u32EraseSize) != 0 ||
+				(part->_internal.u32Size % part->_internal.u32EraseSize) != 0 ||
+				(part->policy.pCache != NULL && part->policy.u32CacheSize > part->_internal.u32Size)){
+			return NOR_INVALID_PARAMS;
+		}
+		for (k=0 ; k<i ; k++){
+			if (_part_overlaps(part->u32FirstSector, part->u32SectorCount,
+					pt->config.pParts[k].u32FirstSector, pt->config.pParts[k].u32SectorCount)){
+				return NOR_INVALID_PARAMS;
+			}
+		}
+		part->_internal.nor = pt->nor;
+		part->_internal.u8CacheValid = 0;
+		part->_internal.u32PendingLen = 0;
+		memset(&part->stats, 0, sizeof(part->stats));
+	}
+	for (i=0 ; i<pt->config.u32Count ; i++){
+		pt->config.pParts[i]._internal.u16Initialized = NOR_INITIALIZED_FLAG;
+	}
+	pt->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_part_t *NOR_PART_Find(nor_ptable_t *pt, const char *pName){
+	uint32_t i;
+
+	if (pt == NULL || pName == NULL || pt->_internal.u16Initialized != NOR_INITIALIZED_FLAG){
+		return NULL;
+	}
+	for (i=0 ; i<pt->config.u32Count ; i++){
+		if (strcmp(pt->config.pParts[i].pName, pName) == 0){
+			return &pt->config.pParts[i];
+		}
+	}
+	return NULL;
+}
+
+nor_err_e NOR_PART_Read(nor_part_t *part, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	_PART_SANITY_CHECK(part);
+
+	if (pData == NULL || Len == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if (!_PART_IN_RANGE(part, Offset, Len)){
+		return NOR_OUT_OF_RANGE;
+	}
+	if (part->policy.pCache != NULL && Len < part->policy.u32CacheSize){
+		// the cache is updated by the writes, even the pending ones
+		if (!part->_internal.u8CacheValid || Offset < part->_internal.u32CacheOffset ||
+				(Offset + Len) > (part->_internal.u32CacheOffset + part->policy.u32CacheSize)){
+			part->stats.u32CacheMisses++;
+			if (_part_flush(part) != NOR_OK || _part_cache_fill(part, Offset) != NOR_OK){
+				return NOR_FAIL;
+			}
+		}
+		else{
+			part->stats.u32CacheHits++;
+		}
+		// a range crossing the window boundary is read in two parts
+		if ((Offset + Len) > (part->_internal.u32CacheOffset + part->policy.u32CacheSize)){
+			uint32_t n = part->_internal.u32CacheOffset + part->policy.u32CacheSize - Offset;
+
+			memcpy(pData, &part->policy.pCache[Offset - part->_internal.u32CacheOffset], n);
+			return NOR_PART_Read(part, Offset + n, pData + n, Len - n);
+		}
+		memcpy(pData, &part->policy.pCache[Offset - part->_internal.u32CacheOffset], Len);
+		return NOR_OK;
+	}
+	if (part->_internal.u32PendingLen > 0 &&
+			_part_overlaps(Offset, Len, part->_internal.u32PendingOffset, part->_internal.u32PendingLen)){
+		if (_part_flush(part) != NOR_OK){
+			return NOR_FAIL;
+		}
+	}
+	return NOR_ReadBytes(part->_internal.nor, pData, part->_internal.u32Start + Offset, Len);
+}
+
+nor_err_e NOR_PART_Write(nor_part_t *part, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	_PART_SANITY_CHECK(part);
+
+	if (pData == NULL || Len == 0 || (part->policy.u8Flags & NOR_PART_READ_ONLY)){
+		return NOR_INVALID_PARAMS;
+	}
+	if (!_PART_IN_RANGE(part, Offset, Len)){
+		return NOR_OUT_OF_RANGE;
+	}
+	_part_cache_program(part, Offset, pData, Len);
+	if (part->policy.pWriteBuffer == NULL){
+		return _part_program(part, Offset, pData, Len);
+	}
+	if (part->_internal.u32PendingLen > 0 &&
+			Offset == (part->_internal.u32PendingOffset + part->_internal.u32PendingLen) &&
+			Len <= (part->policy.u32WriteBufferSize - part->_internal.u32PendingLen)){
+		memcpy(&part->policy.pWriteBuffer[part->_internal.u32PendingLen], pData, Len);
+		part->_internal.u32PendingLen += Len;
+		part->stats.u32CoalescedWrites++;
+		if (part->_internal.u32PendingLen == part->policy.u32WriteBufferSize){
+			return _part_flush(part);
+		}
+		return NOR_OK;
+	}
+	if (_part_flush(part) != NOR_OK){
+		return NOR_FAIL;
+	}
+	if (Len >= part->policy.u32WriteBufferSize){
+		return _part_program(part, Offset, pData, Len);
+	}
+	memcpy(part->policy.pWriteBuffer, pData, Len);
+	part->_internal.u32PendingOffset = Offset;
+	part->_internal.u32PendingLen = Len;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_PART_Erase(nor_part_t *part, uint32_t Offset, uint32_t Len){
+	nor_err_e err;
+
+	_PART_SANITY_CHECK(part);
+
+	if (Len == 0 || (part->policy.u8Flags & NOR_PART_READ_ONLY) ||
+			(Offset % part->_internal.u32EraseSize) != 0 || (Len % part->_internal.u32EraseSize) != 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if (!_PART_IN_RANGE(part, Offset, Len)){
+		return NOR_OUT_OF_RANGE;
+	}
+	if (_part_flush(part) != NOR_OK){
+		return NOR_FAIL;
+	}
+	if (part->_internal.u8CacheValid &&
+			_part_overlaps(Offset, Len, part->_internal.u32CacheOffset, part->policy.u32CacheSize)){
+		part->_internal.u8CacheValid = 0;
+	}
+	while (Len > 0){
+		if (part->policy.u8Flags & NOR_PART_POSTED){
+			err = NOR_EraseAddressPosted(part->_internal.nor, part->_internal.u32Start + Offset, part->policy.EraseMethod);
+		}
+		else{
+			err = NOR_EraseAddress(part->_internal.nor, part->_internal.u32Start + Offset, part->policy.EraseMethod);
+		}
+		if (err != NOR_OK){
+			return NOR_FAIL;
+		}
+		part->stats.u32Erases++;
+		Offset += part->_internal.u32EraseSize;
+		Len -= part->_internal.u32EraseSize;
+	}
+	return NOR_OK;
+}
+
+nor_err_e NOR_PART_Sync(nor_part_t *part){
+	_PART_SANITY_CHECK(part);
+
+	if (_part_flush(part) != NOR_OK || NOR_Sync(part->_internal.nor) != NOR_OK){
+		return NOR_FAIL;
+	}
+	return NOR_OK;
+}
+
+uint32_t NOR_PART_GetSize(nor_part_t *part){
+	if (part == NULL || part->_internal.u16Initialized != NOR_INITIALIZED_FLAG){
+		return 0;
+	}
+	return part->_internal.u32Size;
+}
@@ -0,0 +1,188 @@
+/*
+ * nor_part.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Partition table over the geometry of a nor_t. Every named partition has
+ *  its own I/O policy: a read cache, write coalescing, posted programs and
+ *  erases, and the erase granularity. The range of each partition is
+ *  computed once by NOR_PART_Init, so the accesses are checked against it
+ *  with two compares, and the offsets are relative to the partition.
+ *
+ *  The partitions aren't thread safe: call the functions of a partition
+ *  from the same task, or protect them with a mutex. Different partitions
+ *  may be used by different tasks, the nor_t lock serializes the bus.
+ */
+
+#ifndef NOR_PART_H_
+#define NOR_PART_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+// Flags of the policy
+#define NOR_PART_READ_ONLY			0x01
+// programs and erases return without wait the device, see NOR_WriteBytesPosted
+#define NOR_PART_POSTED				0x02
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	const char *pName;
+	uint32_t u32FirstSector;
+	uint32_t u32SectorCount;
+	struct{
+		uint8_t u8Flags;
+		// unit of NOR_PART_Erase, the partition must be aligned to it
+		nor_erase_method_e EraseMethod;
+		// Optional, read cache. Reads shorter than CacheSize are served from a
+		// window of CacheSize bytes, kept up to date by the writes
+		uint8_t *pCache;
+		uint32_t u32CacheSize;
+		// Optional, write coalescing. Sequential writes are collected on the
+		// buffer and programmed together, when it's full, on a write that
+		// isn't sequential, or on NOR_PART_Sync
+		uint8_t *pWriteBuffer;
+		uint32_t u32WriteBufferSize;
+	}policy;
+	struct{
+		uint32_t u32CacheHits;
+		uint32_t u32CacheMisses;
+		// writes appended to the coalescing buffer
+		uint32_t u32CoalescedWrites;
+		// program calls done on the device
+		uint32_t u32Programs;
+		uint32_t u32Erases;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		nor_t *nor;
+		uint32_t u32Start;
+		uint32_t u32Size;
+		uint32_t u32EraseSize;
+		uint32_t u32CacheOffset;
+		uint8_t u8CacheValid;
+		uint32_t u32PendingOffset;
+		uint32_t u32PendingLen;
+	}_internal;
+}nor_part_t;
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		// partitions, in any order, may leave sectors out of the table
+		nor_part_t *pParts;
+		uint32_t u32Count;
+	}config;
+	struct{
+		uint16_t u16Initialized;
+	}_internal;
+}nor_ptable_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Check the partitions and compute their ranges. Fill the nor and
+ * config fields, and the name, sectors and policy of every partition before
+ * call this function.
+ *
+ * @param pt pointer to the partition table
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid, two partitions overlap,
+ * a partition isn't aligned to its EraseMethod, or the cache is bigger than it
+ * @return NOR_OUT_OF_RANGE a partition is beyond the device
+ */
+nor_err_e NOR_PART_Init(nor_ptable_t *pt);
+
+/**
+ * @brief Find a partition by name.
+ *
+ * @param pt pointer to the partition table
+ * @param pName name of the partition
+ * @return the partition, or NULL if not found
+ */
+nor_part_t *NOR_PART_Find(nor_ptable_t *pt, const char *pName);
+
+/**
+ * @brief Read from a partition. The data waiting on the coalescing buffer is
+ * programmed first, when the range overlaps it.
+ *
+ * @param part pointer to the partition
+ * @param Offset offset on the partition
+ * @param pData receives the data
+ * @param Len length of the range
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_PART_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL or Len is zero
+ * @return NOR_OUT_OF_RANGE the range is beyond the partition
+ * @return NOR_FAIL failed to access the device
+ */
+nor_err_e NOR_PART_Read(nor_part_t *part, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Program a range of a partition, as NOR_WriteBytes: the range should
+ * be erased. With write coalescing, the data may be kept on the buffer until
+ * the next write, read or NOR_PART_Sync, so pData can be reused at return.
+ *
+ * @param part pointer to the partition
+ * @param Offset offset on the partition
+ * @param pData data to program
+ * @param Len length of the range
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_PART_Init first
+ * @return NOR_INVALID_PARAMS pData was NULL, Len is zero, or the partition
+ * is read only
+ * @return NOR_OUT_OF_RANGE the range is beyond the partition
+ * @return NOR_FAIL failed to program
+ */
+nor_err_e NOR_PART_Write(nor_part_t *part, uint32_t Offset, uint8_t *pData, uint32_t Len);
+
+/**
+ * @brief Erase a range of a partition, with the EraseMethod of its policy.
+ *
+ * @param part pointer to the partition
+ * @param Offset offset on the partition, aligned to the erase unit
+ * @param Len length of the range, multiple of the erase unit
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_PART_Init first
+ * @return NOR_INVALID_PARAMS the range isn't aligned, or the partition is
+ * read only
+ * @return NOR_OUT_OF_RANGE the range is beyond the partition
+ * @return NOR_FAIL failed to erase
+ */
+nor_err_e NOR_PART_Erase(nor_part_t *part, uint32_t Offset, uint32_t Len);
+
+/**
+ * @brief Program the data waiting on the coalescing buffer, and wait the
+ * posted operations of the device.
+ *
+ * @param part pointer to the partition
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_PART_Init first
+ * @return NOR_FAIL failed to program
+ */
+nor_err_e NOR_PART_Sync(nor_part_t *part);
+
+/**
+ * @brief Get the size of a partition.
+ *
+ * @param part pointer to the partition
+ * @return size in bytes, 0 if the partition isn't initialized
+ */
+uint32_t NOR_PART_GetSize(nor_part_t *part);
+
+#endif /* NOR_PART_H_ */
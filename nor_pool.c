@@ -0,0 +1,214 @@
+/*
+ * nor_pool.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <string.h>
+
+#include "nor_pool.h"
+
+/*
+ * Privates
+ */
+
+#define _POOL_SANITY_CHECK(p)		if (p == NULL)	return NOR_INVALID_PARAMS;					\
+									if (p->_internal.u16Initialized != NOR_INITIALIZED_FLAG)	\
+										return NOR_NOT_INITIALIZED;
+
+/* Functions */
+
+static void _pool_set_state(nor_pool_t *pool, uint32_t Index, nor_pool_state_e State){
+	switch (pool->config.pState[Index]){
+	case NOR_POOL_DIRTY:
+		pool->_internal.u32Dirty--;
+		break;
+	case NOR_POOL_ERASED:
+		pool->_internal.u32Erased--;
+		break;
+	default:
+		break;
+	}
+	switch (State){
+	case NOR_POOL_DIRTY:
+		pool->_internal.u32Dirty++;
+		break;
+	case NOR_POOL_ERASED:
+		pool->_internal.u32Erased++;
+		break;
+	default:
+		break;
+	}
+	pool->config.pState[Index] = State;
+}
+
+static uint32_t _pool_find(nor_pool_t *pool, nor_pool_state_e State, uint32_t Start){
+	uint32_t i, Index;
+
+	for (i=0 ; i<pool->config.u32SectorCount ; i++){
+		Index = (Start + i) % pool->config.u32SectorCount;
+		if (pool->config.pState[Index] == State){
+			return Index;
+		}
+	}
+	return NOR_POOL_NONE;
+}
+
+static nor_err_e _pool_start_erase(nor_pool_t *pool){
+	uint32_t Index, Sector;
+	nor_err_e err;
+
+	// round robin over the released sectors, to spread the wear
+	Index = _pool_find(pool, NOR_POOL_DIRTY, pool->_internal.u32Cursor);
+	if (Index == NOR_POOL_NONE){
+		return NOR_OK;
+	}
+	pool->_internal.u32Cursor = (Index + 1) % pool->config.u32SectorCount;
+	Sector = pool->config.u32FirstSector + Index;
+	// the sectors released right after the format are usually blank
+	err = NOR_IsEmptySector(pool->nor, Sector, 0, pool->nor->info.u16SectorSize);
+	if (err == NOR_OK){
+		_pool_set_state(pool, Index, NOR_POOL_ERASED);
+		pool->stats.u32Blank++;
+		return NOR_OK;
+	}
+	if (err != NOR_REGIONS_IS_NOT_EMPTY){
+		return NOR_FAIL;
+	}
+	err = NOR_EraseAddressPosted(pool->nor, Sector * pool->nor->info.u16SectorSize, NOR_ERASE_4K);
+	if (err != NOR_OK){
+		return NOR_FAIL;
+	}
+	_pool_set_state(pool, Index, NOR_POOL_ERASING);
+	pool->_internal.u32Erasing = Index;
+
+	return NOR_OK;
+}
+
+static void _pool_erase_done(nor_pool_t *pool){
+	_pool_set_state(pool, pool->_internal.u32Erasing, NOR_POOL_ERASED);
+	pool->_internal.u32Erasing = NOR_POOL_NONE;
+	pool->stats.u32Erases++;
+}
+
+/*
+ * A sector is never marked erased after an error. A worn sector is dropped,
+ * on the other errors it's erased again.
+ */
+static void _pool_erase_failed(nor_pool_t *pool, uint32_t Index, nor_err_e err){
+	_pool_set_state(pool, Index, (err == NOR_ERASE_FAILED) ? NOR_POOL_BAD : NOR_POOL_DIRTY);
+	if (Index == pool->_internal.u32Erasing){
+		pool->_internal.u32Erasing = NOR_POOL_NONE;
+	}
+	pool->stats.u32EraseFails++;
+}
+
+/*
+ * Publics
+ */
+
+nor_err_e NOR_POOL_Init(nor_pool_t *pool){
+	if (pool == NULL || pool->nor == NULL || pool->nor->_internal.u16Initialized != NOR_INITIALIZED_FLAG ||
+			pool->config.pState == NULL || pool->config.u32SectorCount == 0){
+		return NOR_INVALID_PARAMS;
+	}
+	if ((pool->config.u32FirstSector + pool->config.u32SectorCount) > pool->nor->info.u32SectorCount){
+		return NOR_OUT_OF_RANGE;
+	}
+	memset(pool->config.pState, NOR_POOL_IN_USE, pool->config.u32SectorCount);
+	memset(&pool->stats, 0, sizeof(pool->stats));
+	pool->_internal.u32Dirty = 0;
+	pool->_internal.u32Erased = 0;
+	pool->_internal.u32Cursor = 0;
+	pool->_internal.u32Erasing = NOR_POOL_NONE;
+	pool->_internal.u16Initialized = NOR_INITIALIZED_FLAG;
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_POOL_Release(nor_pool_t *pool, uint32_t Sector){
+	uint32_t Index;
+
+	_POOL_SANITY_CHECK(pool);
+
+	if (Sector < pool->config.u32FirstSector || Sector >= (pool->config.u32FirstSector + pool->config.u32SectorCount)){
+		return NOR_OUT_OF_RANGE;
+	}
+	Index = Sector - pool->config.u32FirstSector;
+	if (pool->config.pState[Index] == NOR_POOL_IN_USE){
+		_pool_set_state(pool, Index, NOR_POOL_DIRTY);
+	}
+
+	return NOR_OK;
+}
+
+nor_err_e NOR_POOL_Service(nor_pool_t *pool, uint8_t *pBusy){
+	uint8_t Busy;
+	nor_err_e err = NOR_OK;
+
+	_POOL_SANITY_CHECK(pool);
+
+	if (pool->_internal.u32Erasing != NOR_POOL_NONE){
+		err = NOR_IsBusy(pool->nor, &Busy);
+		if (err != NOR_OK){
+			_pool_erase_failed(pool, pool->_internal.u32Erasing, err);
+		}
+		else if (Busy == 0){
+			_pool_erase_done(pool);
+		}
+	}
+	else if (pool->_internal.u32Dirty > 0){
+		err = _pool_start_erase(pool);
+	}
+	if (pBusy != NULL){
+		*pBusy = (pool->_internal.u32Erasing != NOR_POOL_NONE || pool->_internal.u32Dirty > 0);
+	}
+
+	return err;
+}
+
+nor_err_e NOR_POOL_Get(nor_pool_t *pool, uint32_t *pSector){
+	uint32_t Index;
+	nor_err_e err;
+
+	_POOL_SANITY_CHECK(pool);
+
+	if (pSector == NULL){
+		return NOR_INVALID_PARAMS;
+	}
+	Index = _pool_find(pool, NOR_POOL_ERASED, 0);
+	if (Index == NOR_POOL_NONE && pool->_internal.u32Erasing != NOR_POOL_NONE){
+		// the erase is already running, just wait it
+		err = NOR_Sync(pool->nor);
+		if (err != NOR_OK){
+			_pool_erase_failed(pool, pool->_internal.u32Erasing, err);
+			return NOR_FAIL;
+		}
+		Index = pool->_internal.u32Erasing;
+		_pool_erase_done(pool);
+	}
+	if (Index == NOR_POOL_NONE && pool->_internal.u32Dirty > 0){
+		Index = _pool_find(pool, NOR_POOL_DIRTY, pool->_internal.u32Cursor);
+		err = NOR_EraseSector(pool->nor, pool->config.u32FirstSector + Index);
+		if (err != NOR_OK){
+			_pool_erase_failed(pool, Index, err);
+			return NOR_FAIL;
+		}
+		pool->stats.u32SyncErases++;
+	}
+	if (Index == NOR_POOL_NONE){
+		return NOR_FAIL;
+	}
+	_pool_set_state(pool, Index, NOR_POOL_IN_USE);
+	*pSector = pool->config.u32FirstSector + Index;
+
+	return NOR_OK;
+}
+
+uint32_t NOR_POOL_Available(nor_pool_t *pool){
+	if (pool == NULL || pool->_internal.u16Initialized != NOR_INITIALIZED_FLAG){
+		return 0;
+	}
+	return pool->_internal.u32Erased;
+}
@@ -0,0 +1,146 @@
+/*
+ * nor_pool.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Pool of pre-erased sectors. The upper layers release the sectors they
+ *  don't need anymore, NOR_POOL_Service erases them in background, one posted
+ *  erase at a time, and NOR_POOL_Get hands out an erased sector, so the erase
+ *  time stays out of the write path. Enable config.EraseSuspend on the nor
+ *  instance to let the reads and programs of other tasks suspend the erase.
+ *
+ *  The pool itself isn't thread safe: call Release, Service and Get from the
+ *  same task, or protect them with a mutex.
+ */
+
+#ifndef NOR_POOL_H_
+#define NOR_POOL_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_POOL_NONE				0xFFFFFFFF
+
+/**
+ * Enumerates
+ */
+
+typedef enum{
+	NOR_POOL_IN_USE, /**< NOR_POOL_IN_USE, owned by the application */
+	NOR_POOL_DIRTY,  /**< NOR_POOL_DIRTY, free, may be erased */
+	NOR_POOL_ERASING,/**< NOR_POOL_ERASING, the posted erase is running */
+	NOR_POOL_ERASED, /**< NOR_POOL_ERASED, ready to be handed out */
+	NOR_POOL_BAD     /**< NOR_POOL_BAD, the device reported the erase failed, dropped */
+}nor_pool_state_e;
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	nor_t *nor;
+	struct{
+		uint32_t u32FirstSector;
+		uint32_t u32SectorCount;
+		// one byte per sector of the region, provided by the application
+		uint8_t *pState;
+	}config;
+	struct{
+		// erases done by NOR_POOL_Service
+		uint32_t u32Erases;
+		// released sectors found already erased, without an erase
+		uint32_t u32Blank;
+		// erases done by NOR_POOL_Get, the pool had no erased sector
+		uint32_t u32SyncErases;
+		// erases failed, by the device (the sector is dropped) or by a timeout
+		// (the sector is erased again)
+		uint32_t u32EraseFails;
+	}stats;
+	struct{
+		uint16_t u16Initialized;
+		uint32_t u32Dirty;
+		uint32_t u32Erased;
+		uint32_t u32Cursor;
+		uint32_t u32Erasing;
+	}_internal;
+}nor_pool_t;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Initialize the pool, with all sectors of the region in use. Fill the
+ * nor and config fields before call this function.
+ *
+ * @param pool pointer to the pool instance
+ * @return NOR_OK everything was ok
+ * @return NOR_INVALID_PARAMS a parameter was invalid
+ * @return NOR_OUT_OF_RANGE the region is bigger than the device
+ */
+nor_err_e NOR_POOL_Init(nor_pool_t *pool);
+
+/**
+ * @brief Release a sector to the pool, telling that it may be erased. Releasing
+ * a free sector again does nothing.
+ *
+ * @param pool pointer to the pool instance
+ * @param Sector sector number, on the device
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_POOL_Init first
+ * @return NOR_OUT_OF_RANGE the sector isn't in the region of the pool
+ */
+nor_err_e NOR_POOL_Release(nor_pool_t *pool, uint32_t Sector);
+
+/**
+ * @brief Do one step of the background work, without wait the device: check the
+ * running erase, or start the erase of the next released sector. The sectors
+ * already blank are moved to the pool without erase. Call it on the idle task,
+ * or periodically, while pBusy returns 1.
+ *
+ * @param pool pointer to the pool instance
+ * @param pBusy optional, receives 1 while there is an erase running or sectors
+ * waiting the erase
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_POOL_Init first
+ * @return NOR_ERASE_FAILED the device reported the erase failed, the sector was
+ * dropped from the pool
+ * @return NOR_PROGRAM_FAILED a posted program failed, the sector is erased again
+ * @return NOR_FAIL failed to access the device
+ */
+nor_err_e NOR_POOL_Service(nor_pool_t *pool, uint8_t *pBusy);
+
+/**
+ * @brief Get an erased sector from the pool, and mark it in use. When the pool
+ * has no erased sector, the running erase is waited, or a released sector is
+ * erased right now (see stats.u32SyncErases).
+ *
+ * @param pool pointer to the pool instance
+ * @param pSector receives the sector number, on the device
+ * @return NOR_OK everything was ok
+ * @return NOR_NOT_INITIALIZED call NOR_POOL_Init first
+ * @return NOR_INVALID_PARAMS pSector was NULL
+ * @return NOR_FAIL there is no free sector, or the erase failed. A sector whose
+ * erase failed is never handed out
+ */
+nor_err_e NOR_POOL_Get(nor_pool_t *pool, uint32_t *pSector);
+
+/**
+ * @brief Get the number of erased sectors ready on the pool.
+ *
+ * @param pool pointer to the pool instance
+ * @return number of erased sectors, 0 if the pool isn't initialized
+ */
+uint32_t NOR_POOL_Available(nor_pool_t *pool);
+
+#endif /* NOR_POOL_H_ */
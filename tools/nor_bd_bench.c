@@ -0,0 +1,432 @@
+/*
+ * nor_bd_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host benchmark of the read latency of nor_bd under a write load, with
+ *  pthreads. Reader threads run small NOR_BD_Read on random blocks of the
+ *  region, while a writer thread erases and programs the blocks of its upper
+ *  half, with NOR_BD_Sync after each block. The simulated device runs on the
+ *  wall clock, the transfers and the busy operations take their real time, so
+ *  the latencies are the ones the readers would see.
+ *
+ *  Each mode runs for the same time:
+ *    idle        no writer, the reference
+ *    serialized  a single mutex around every call, the lock held while the
+ *                device is busy
+ *    shared      the shared/exclusive lock of nor_bd and the lock of nor_t,
+ *                both on rwlocks
+ *    suspend     as shared, with config.EraseSuspend
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_bd_bench tools/nor_bd_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c nor_bd.c -lpthread
+ *
+ *  Usage:
+ *    nor_bd_bench [-r readers] [-s size] [-t ms] [-x seed]
+ *
+ *    -r  reader threads, 2 if not provided
+ *    -s  bytes of each read, a power of two up to the block, 64 if not
+ *        provided. From the size of the read cache, 256, the reads go
+ *        straight to the bus
+ *    -t  duration of each mode, 2000 ms if not provided
+ *    -x  seed of the random generator
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_bd.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1740EF	// W25Q64
+#define _BENCH_SIZE					(8 * 1024 * 1024)
+#define _BENCH_BLOCK_SIZE			4096
+#define _BENCH_BLOCK_COUNT			64
+#define _BENCH_READ_MAX			4096
+#define _BENCH_READ_PERIOD_US		500
+#define _BENCH_READERS_MAX			16
+#define _BENCH_SAMPLES_MAX			(1 << 16)
+
+typedef enum{
+	_BENCH_IDLE,
+	_BENCH_SERIALIZED,
+	_BENCH_SHARED,
+	_BENCH_SUSPEND,
+}bench_mode_e;
+
+typedef struct{
+	pthread_t Thread;
+	uint32_t u32Seed;
+	uint32_t u32Count;
+	uint32_t u32Errors;
+	uint32_t u32LatUs[_BENCH_SAMPLES_MAX];
+}bench_reader_t;
+
+static const char *ModeNames[] = {"idle", "serialized", "shared", "suspend"};
+
+static uint8_t Memory[_BENCH_SIZE];
+static uint8_t ReadCache[256];
+static uint8_t ProgCache[256];
+static uint8_t ErasedMap[(_BENCH_BLOCK_COUNT + 7) / 8];
+static uint8_t Block[_BENCH_BLOCK_SIZE];
+static nor_t Nor;
+static nor_sim_t Sim;
+static nor_bd_t Bd;
+static nor_ops_t Ops;
+static bench_reader_t Readers[_BENCH_READERS_MAX];
+static uint32_t Samples[_BENCH_READERS_MAX * _BENCH_SAMPLES_MAX];
+
+static pthread_mutex_t BusMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t AppMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t NorLock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_rwlock_t BdLock = PTHREAD_RWLOCK_INITIALIZER;
+static struct timespec Epoch;
+static volatile int Stop;
+static uint32_t ReadSize = 64;
+static bench_mode_e Mode;
+static uint32_t WriterBlocks, WriterErrors;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-r readers] [-s size] [-t ms] [-x seed]\n", name);
+}
+
+static uint64_t _bench_now_ns(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)(ts.tv_sec - Epoch.tv_sec) * 1000000000ULL) + (uint64_t)ts.tv_nsec - (uint64_t)Epoch.tv_nsec;
+}
+
+static void _bench_sleep_ns(uint64_t ns){
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(ns / 1000000000ULL);
+	ts.tv_nsec = (long)(ns % 1000000000ULL);
+	nanosleep(&ts, NULL);
+}
+
+/*
+ * The virtual clock of the device follows the wall clock: it's advanced to
+ * the current time before each transaction, and the caller sleeps until the
+ * wall clock reaches the end of the transfer. Differences under 50us are
+ * left to the next transaction, the sleeps are coarser than that.
+ */
+static void _bench_sync_begin(void){
+	uint64_t Now = _bench_now_ns();
+
+	pthread_mutex_lock(&BusMutex);
+	if (Sim._internal.u64TimeNs < Now){
+		Sim._internal.u64TimeNs = Now;
+	}
+}
+
+static void _bench_sync_end(void){
+	uint64_t Until = Sim._internal.u64TimeNs, Now;
+
+	pthread_mutex_unlock(&BusMutex);
+	Now = _bench_now_ns();
+	if (Until > (Now + 50000)){
+		_bench_sleep_ns(Until - Now);
+	}
+}
+
+static void _bench_spi_tx(void *Ctx, uint8_t *TxBuff, uint32_t len){
+	_bench_sync_begin();
+	NOR_SIM_SpiTx(Ctx, TxBuff, len);
+	_bench_sync_end();
+}
+
+static void _bench_spi_rx(void *Ctx, uint8_t *RxBuff, uint32_t len){
+	_bench_sync_begin();
+	NOR_SIM_SpiRx(Ctx, RxBuff, len);
+	_bench_sync_end();
+}
+
+static void _bench_cs_assert(void *Ctx){
+	_bench_sync_begin();
+	NOR_SIM_CsAssert(Ctx);
+	_bench_sync_end();
+}
+
+static void _bench_cs_deassert(void *Ctx){
+	_bench_sync_begin();
+	NOR_SIM_CsDeassert(Ctx);
+	_bench_sync_end();
+}
+
+static void _bench_delay_us(void *Ctx, uint32_t us){
+	(void)Ctx;
+	_bench_sleep_ns((uint64_t)us * 1000);
+}
+
+static void _bench_nor_lock(void *Ctx, nor_lock_e LockMode){
+	(void)Ctx;
+	if (LockMode == NOR_LOCK_SHARED){
+		pthread_rwlock_rdlock(&NorLock);
+	}
+	else{
+		pthread_rwlock_wrlock(&NorLock);
+	}
+}
+
+static void _bench_nor_unlock(void *Ctx, nor_lock_e LockMode){
+	(void)Ctx;
+	(void)LockMode;
+	pthread_rwlock_unlock(&NorLock);
+}
+
+static void _bench_bd_lock(void *Ctx, nor_lock_e LockMode){
+	if (LockMode == NOR_LOCK_SHARED){
+		pthread_rwlock_rdlock((pthread_rwlock_t*)Ctx);
+	}
+	else{
+		pthread_rwlock_wrlock((pthread_rwlock_t*)Ctx);
+	}
+}
+
+static void _bench_bd_unlock(void *Ctx, nor_lock_e LockMode){
+	(void)LockMode;
+	pthread_rwlock_unlock((pthread_rwlock_t*)Ctx);
+}
+
+static void _bench_app_lock(void){
+	if (Mode == _BENCH_SERIALIZED){
+		pthread_mutex_lock(&AppMutex);
+	}
+}
+
+static void _bench_app_unlock(void){
+	if (Mode == _BENCH_SERIALIZED){
+		pthread_mutex_unlock(&AppMutex);
+	}
+}
+
+static void* _bench_reader(void *arg){
+	bench_reader_t *r = (bench_reader_t*)arg;
+	uint8_t Buffer[_BENCH_READ_MAX];
+	uint32_t BlockNum, Offset;
+	uint64_t Start;
+	nor_err_e err;
+
+	while (!Stop && r->u32Count < _BENCH_SAMPLES_MAX){
+		BlockNum = (uint32_t)rand_r(&r->u32Seed) % _BENCH_BLOCK_COUNT;
+		Offset = ((uint32_t)rand_r(&r->u32Seed) % (_BENCH_BLOCK_SIZE / ReadSize)) * ReadSize;
+		Start = _bench_now_ns();
+		_bench_app_lock();
+		err = NOR_BD_Read(&Bd, BlockNum, Offset, Buffer, ReadSize);
+		_bench_app_unlock();
+		r->u32LatUs[r->u32Count++] = (uint32_t)((_bench_now_ns() - Start) / 1000);
+		if (err != NOR_OK){
+			r->u32Errors++;
+		}
+		_bench_sleep_ns(_BENCH_READ_PERIOD_US * 1000ULL);
+	}
+	return NULL;
+}
+
+static void* _bench_writer(void *arg){
+	uint32_t BlockNum, Offset, Next = 0;
+	nor_err_e err;
+
+	(void)arg;
+	while (!Stop){
+		BlockNum = (_BENCH_BLOCK_COUNT / 2) + Next;
+		Next = (Next + 1) % (_BENCH_BLOCK_COUNT / 2);
+		_bench_app_lock();
+		err = NOR_BD_Erase(&Bd, BlockNum);
+		_bench_app_unlock();
+		for (Offset=0 ; Offset<_BENCH_BLOCK_SIZE && err == NOR_OK ; Offset+=256){
+			_bench_app_lock();
+			err = NOR_BD_Prog(&Bd, BlockNum, Offset, &Block[Offset], 256);
+			_bench_app_unlock();
+		}
+		if (err == NOR_OK){
+			_bench_app_lock();
+			err = NOR_BD_Sync(&Bd);
+			_bench_app_unlock();
+		}
+		if (err != NOR_OK){
+			WriterErrors++;
+		}
+		WriterBlocks++;
+	}
+	return NULL;
+}
+
+static int _bench_cmp(const void *a, const void *b){
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+static int _bench_setup(bench_mode_e BenchMode){
+	uint32_t i;
+
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _BENCH_JEDEC_ID);
+	memset(&Ops, 0, sizeof(Ops));
+	Ops.SpiTx = _bench_spi_tx;
+	Ops.SpiRx = _bench_spi_rx;
+	Ops.CsAssert = _bench_cs_assert;
+	Ops.CsDeassert = _bench_cs_deassert;
+	Ops.DelayUs = _bench_delay_us;
+	Ops.BusWidth = NOR_SIM_SetBusWidth;
+	memset(&Nor, 0, sizeof(Nor));
+	memset(&Bd, 0, sizeof(Bd));
+	if (BenchMode != _BENCH_SERIALIZED){
+		Ops.Lock = _bench_nor_lock;
+		Ops.Unlock = _bench_nor_unlock;
+		Bd.config.LockFxn = _bench_bd_lock;
+		Bd.config.UnlockFxn = _bench_bd_unlock;
+		Bd.config.LockCtx = &BdLock;
+	}
+	// filled on the virtual clock, the wall clock is used from the first run
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	Nor.config.EraseSuspend = (BenchMode == _BENCH_SUSPEND);
+	if (NOR_Init(&Nor) != NOR_OK){
+		return -1;
+	}
+	Bd.nor = &Nor;
+	Bd.config.u32FirstSector = 0;
+	Bd.config.u32BlockSize = _BENCH_BLOCK_SIZE;
+	Bd.config.u32BlockCount = _BENCH_BLOCK_COUNT;
+	Bd.config.pReadCache = ReadCache;
+	Bd.config.u16ReadCacheSize = sizeof(ReadCache);
+	Bd.config.pProgCache = ProgCache;
+	Bd.config.u16ProgCacheSize = sizeof(ProgCache);
+	Bd.config.pErasedMap = ErasedMap;
+	if (NOR_BD_Init(&Bd) != NOR_OK){
+		return -1;
+	}
+	// every block written, so the reads reach the cache and the bus
+	for (i=0 ; i<_BENCH_BLOCK_COUNT ; i++){
+		if (NOR_BD_Erase(&Bd, i) != NOR_OK || NOR_BD_Write(&Bd, i, Block) != NOR_OK){
+			return -1;
+		}
+	}
+	if (NOR_BD_Sync(&Bd) != NOR_OK){
+		return -1;
+	}
+	// the wall clock starts from the virtual one
+	clock_gettime(CLOCK_MONOTONIC, &Epoch);
+	Epoch.tv_sec -= (time_t)(Sim._internal.u64TimeNs / 1000000000ULL);
+	Epoch.tv_nsec -= (long)(Sim._internal.u64TimeNs % 1000000000ULL);
+	if (Epoch.tv_nsec < 0){
+		Epoch.tv_sec--;
+		Epoch.tv_nsec += 1000000000L;
+	}
+	Nor.config.pOps = &Ops;
+
+	return 0;
+}
+
+static int _bench_run(bench_mode_e BenchMode, uint32_t NumReaders, uint32_t DurationMs, uint32_t Seed){
+	pthread_t Writer;
+	uint32_t i, j, n = 0, Errors = 0;
+	uint64_t Sum = 0;
+
+	if (_bench_setup(BenchMode) != 0){
+		return -1;
+	}
+	Mode = BenchMode;
+	Stop = 0;
+	WriterBlocks = 0;
+	WriterErrors = 0;
+	memset(&Bd.stats, 0, sizeof(Bd.stats));
+	for (i=0 ; i<NumReaders ; i++){
+		Readers[i].u32Seed = Seed + i;
+		Readers[i].u32Count = 0;
+		Readers[i].u32Errors = 0;
+		pthread_create(&Readers[i].Thread, NULL, _bench_reader, &Readers[i]);
+	}
+	if (BenchMode != _BENCH_IDLE){
+		pthread_create(&Writer, NULL, _bench_writer, NULL);
+	}
+	_bench_sleep_ns((uint64_t)DurationMs * 1000000ULL);
+	Stop = 1;
+	for (i=0 ; i<NumReaders ; i++){
+		pthread_join(Readers[i].Thread, NULL);
+		for (j=0 ; j<Readers[i].u32Count ; j++){
+			Samples[n++] = Readers[i].u32LatUs[j];
+			Sum += Readers[i].u32LatUs[j];
+		}
+		Errors += Readers[i].u32Errors;
+	}
+	if (BenchMode != _BENCH_IDLE){
+		pthread_join(Writer, NULL);
+	}
+	if (n == 0){
+		return -1;
+	}
+	qsort(Samples, n, sizeof(Samples[0]), _bench_cmp);
+	printf(" %-10s | %6u | %7llu | %6u | %6u | %7u | %6u | %6u | %u\n", ModeNames[BenchMode], (unsigned)n,
+			(unsigned long long)(Sum / n), (unsigned)Samples[n / 2], (unsigned)Samples[(n * 99) / 100],
+			(unsigned)Samples[n - 1], (unsigned)Bd.stats.u32BusReads, (unsigned)WriterBlocks,
+			(unsigned)(Errors + WriterErrors));
+
+	return 0;
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	uint32_t NumReaders = 2, DurationMs = 2000, Seed = 1, i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:s:t:x:")) != -1){
+		switch (opt){
+		case 'r':
+			NumReaders = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			ReadSize = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			DurationMs = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			Seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (NumReaders == 0 || NumReaders > _BENCH_READERS_MAX){
+		fprintf(stderr, "readers must be from 1 to %u\n", _BENCH_READERS_MAX);
+		return 1;
+	}
+	if (ReadSize == 0 || ReadSize > _BENCH_READ_MAX || (ReadSize & (ReadSize - 1)) != 0){
+		fprintf(stderr, "the size must be a power of two up to %u\n", _BENCH_READ_MAX);
+		return 1;
+	}
+	srand(Seed);
+	for (i=0 ; i<sizeof(Block) ; i++){
+		Block[i] = (uint8_t)rand();
+	}
+	printf("== Read latency, %u readers of %u bytes each %u us, %u ms per mode ==\n", (unsigned)NumReaders,
+			(unsigned)ReadSize, _BENCH_READ_PERIOD_US, (unsigned)DurationMs);
+	printf(" mode       | reads  | mean us | p50 us | p99 us | max us  | bus rd | blocks | errors\n");
+	for (i=_BENCH_IDLE ; i<=_BENCH_SUSPEND ; i++){
+		if (_bench_run((bench_mode_e)i, NumReaders, DurationMs, Seed) != 0){
+			fprintf(stderr, "failed to run the mode %s\n", ModeNames[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
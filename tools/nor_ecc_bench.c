@@ -0,0 +1,263 @@
+/*
+ * nor_ecc_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host benchmark of nor_ecc on the simulated device. A region is filled
+ *  with random data, random bit flips are injected on the memory of the
+ *  device, on the data and on the codes, and every chunk is read back. The
+ *  report shows, for each rate of flips, the chunks that would be corrupted
+ *  without the ECC, and the chunks corrected, detected as uncorrectable and
+ *  silently corrupted with it. The time of the bus to read the region, with
+ *  and without the codes, and the speed of the codec on the host are also
+ *  measured.
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_ecc_bench tools/nor_ecc_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c nor_ecc.c
+ *
+ *  Usage:
+ *    nor_ecc_bench [-s sectors] [-c chunks] [-o offset] [-r rounds] [-x seed]
+ *
+ *    -s  sectors of the region, 256 if not provided
+ *    -c  chunks of data per sector, config.u16ChunksPerSector
+ *    -o  offset of the codes on the sector, config.u16CodeOffset
+ *    -r  rounds for each rate, with new data and flips, 4 if not provided
+ *    -x  seed of the random generator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_ecc.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1740EF	// W25Q64
+#define _BENCH_SIZE					(8 * 1024 * 1024)
+#define _BENCH_FIRST_SECTOR			16
+#define _BENCH_CODEC_CHUNKS			100000
+
+typedef struct{
+	uint32_t u32Chunks;
+	uint32_t u32Flips;
+	uint32_t u32RawBad;
+	uint32_t u32Corrected;
+	uint32_t u32Detected;
+	uint32_t u32Silent;
+}bench_stats_t;
+
+// flips per sector, on average
+static const double Rates[] = {0.25, 0.5, 1, 2, 4, 8, 16, 32};
+
+static uint8_t Memory[_BENCH_SIZE];
+static uint8_t Data[_BENCH_SIZE];
+static uint8_t Buffer[_BENCH_SIZE];
+static nor_t Nor;
+static nor_sim_t Sim;
+static nor_ecc_t Ecc;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-s sectors] [-c chunks] [-o offset] [-r rounds] [-x seed]\n", name);
+}
+
+static int _bench_fill(void){
+	uint32_t i, Size = NOR_ECC_GetSize(&Ecc);
+
+	for (i=0 ; i<Ecc.config.u32SectorCount ; i++){
+		if (NOR_ECC_EraseSector(&Ecc, i) != NOR_OK){
+			return -1;
+		}
+	}
+	for (i=0 ; i<Size ; i++){
+		Data[i] = (uint8_t)rand();
+	}
+	return (NOR_ECC_Write(&Ecc, 0, Data, Size) == NOR_OK) ? 0 : -1;
+}
+
+/*
+ * Flips a random bit of a random sector, on the chunks or on their codes.
+ */
+static void _bench_flip(void){
+	uint32_t Sector, Bit, Address, DataBits, CodeBits;
+
+	DataBits = Ecc._internal.u32SectorData * 8;
+	CodeBits = Ecc._internal.u16Chunks * NOR_ECC_CODE_SIZE * 8;
+	Sector = (uint32_t)rand() % Ecc.config.u32SectorCount;
+	Bit = (uint32_t)rand() % (DataBits + CodeBits);
+	Address = (Ecc.config.u32FirstSector + Sector) * Nor.info.u16SectorSize;
+	if (Bit < DataBits){
+		Address += Bit / 8;
+	}
+	else{
+		Bit -= DataBits;
+		Address += Ecc._internal.u16CodeOffset + (Bit / 8);
+	}
+	Memory[Address] ^= (uint8_t)(1 << (Bit % 8));
+}
+
+static int _bench_round(double Rate, bench_stats_t *pStats){
+	uint32_t i, Flips, Chunks, Sector, Offset, Corrected;
+	nor_err_e err;
+
+	if (_bench_fill() != 0){
+		return -1;
+	}
+	Flips = (uint32_t)(Rate * Ecc.config.u32SectorCount);
+	for (i=0 ; i<Flips ; i++){
+		_bench_flip();
+	}
+	pStats->u32Flips += Flips;
+	Chunks = NOR_ECC_GetSize(&Ecc) / NOR_ECC_CHUNK_SIZE;
+	for (i=0 ; i<Chunks ; i++){
+		// the chunk as it's read without the ECC
+		Sector = i / Ecc._internal.u16Chunks;
+		Offset = (i % Ecc._internal.u16Chunks) * NOR_ECC_CHUNK_SIZE;
+		if (NOR_ReadBytes(&Nor, Buffer, ((Ecc.config.u32FirstSector + Sector) * Nor.info.u16SectorSize) + Offset,
+				NOR_ECC_CHUNK_SIZE) != NOR_OK){
+			return -1;
+		}
+		if (memcmp(Buffer, &Data[i * NOR_ECC_CHUNK_SIZE], NOR_ECC_CHUNK_SIZE) != 0){
+			pStats->u32RawBad++;
+		}
+		Corrected = Ecc.stats.u32Corrected;
+		err = NOR_ECC_Read(&Ecc, i * NOR_ECC_CHUNK_SIZE, Buffer, NOR_ECC_CHUNK_SIZE);
+		if (err == NOR_ECC_UNCORRECTABLE){
+			pStats->u32Detected++;
+		}
+		else if (err != NOR_OK){
+			return -1;
+		}
+		else if (memcmp(Buffer, &Data[i * NOR_ECC_CHUNK_SIZE], NOR_ECC_CHUNK_SIZE) != 0){
+			pStats->u32Silent++;
+		}
+		else if (Ecc.stats.u32Corrected != Corrected){
+			pStats->u32Corrected++;
+		}
+	}
+	pStats->u32Chunks += Chunks;
+
+	return 0;
+}
+
+static void _bench_bus_time(void){
+	uint64_t Start, RawUs, EccUs;
+	uint32_t Size = NOR_ECC_GetSize(&Ecc);
+
+	Start = NOR_SIM_GetTimeUs(&Sim);
+	NOR_ReadBytes(&Nor, Buffer, Ecc.config.u32FirstSector * Nor.info.u16SectorSize, Size);
+	RawUs = NOR_SIM_GetTimeUs(&Sim) - Start;
+	Start = NOR_SIM_GetTimeUs(&Sim);
+	NOR_ECC_Read(&Ecc, 0, Buffer, Size);
+	EccUs = NOR_SIM_GetTimeUs(&Sim) - Start;
+	printf("== Bus time to read %u bytes ==\n", (unsigned)Size);
+	printf(" Without ECC   | %llu us\n", (unsigned long long)RawUs);
+	printf(" With ECC      | %llu us (+%.1f%%)\n", (unsigned long long)EccUs,
+			(RawUs > 0) ? (100.0 * (double)(EccUs - RawUs) / (double)RawUs) : 0.0);
+}
+
+static void _bench_codec(void){
+	uint8_t Code[3], Calc[3];
+	clock_t Start;
+	double Seconds;
+	uint32_t i;
+
+	Start = clock();
+	for (i=0 ; i<_BENCH_CODEC_CHUNKS ; i++){
+		NOR_ECC_Calculate(&Data[(i % 64) * NOR_ECC_CHUNK_SIZE], Code);
+	}
+	Seconds = (double)(clock() - Start) / CLOCKS_PER_SEC;
+	printf("== Codec on the host ==\n");
+	printf(" Calculate     | %.1f MB/s\n", (Seconds > 0) ? (_BENCH_CODEC_CHUNKS * (double)NOR_ECC_CHUNK_SIZE / 1e6 / Seconds) : 0.0);
+	Start = clock();
+	for (i=0 ; i<_BENCH_CODEC_CHUNKS ; i++){
+		// the decode of a read, a calculate and a compare with the stored code
+		NOR_ECC_Calculate(&Data[(i % 64) * NOR_ECC_CHUNK_SIZE], Calc);
+		Calc[0] ^= (uint8_t)(i & 1);
+		NOR_ECC_Correct(&Data[(i % 64) * NOR_ECC_CHUNK_SIZE], Code, Calc);
+	}
+	Seconds = (double)(clock() - Start) / CLOCKS_PER_SEC;
+	printf(" Decode        | %.1f MB/s\n", (Seconds > 0) ? (_BENCH_CODEC_CHUNKS * (double)NOR_ECC_CHUNK_SIZE / 1e6 / Seconds) : 0.0);
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	bench_stats_t stats;
+	uint32_t Rounds = 4, Seed = 1, i, r;
+	int opt;
+
+	memset(&Ecc, 0, sizeof(Ecc));
+	Ecc.config.u32FirstSector = _BENCH_FIRST_SECTOR;
+	Ecc.config.u32SectorCount = 256;
+	while ((opt = getopt(argc, argv, "s:c:o:r:x:")) != -1){
+		switch (opt){
+		case 's':
+			Ecc.config.u32SectorCount = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			Ecc.config.u16ChunksPerSector = (uint16_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			Ecc.config.u16CodeOffset = (uint16_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			Rounds = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			Seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	srand(Seed);
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _BENCH_JEDEC_ID);
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		fprintf(stderr, "failed to initialize the driver\n");
+		return 1;
+	}
+	Ecc.nor = &Nor;
+	if (NOR_ECC_Init(&Ecc) != NOR_OK){
+		fprintf(stderr, "invalid ECC region or layout\n");
+		return 1;
+	}
+	printf("== Region ==\n");
+	printf(" Sectors       | %u\n", (unsigned)Ecc.config.u32SectorCount);
+	printf(" Chunks/sector | %u, codes on the offset %u\n", (unsigned)Ecc._internal.u16Chunks, (unsigned)Ecc._internal.u16CodeOffset);
+	printf(" Data          | %u bytes\n", (unsigned)NOR_ECC_GetSize(&Ecc));
+
+	printf("== Chunks with bit flips, %u rounds ==\n", (unsigned)Rounds);
+	printf(" flips/sector | flips   | bad w/o ECC | corrected | detected | silent\n");
+	for (i=0 ; i<(sizeof(Rates) / sizeof(Rates[0])) ; i++){
+		memset(&stats, 0, sizeof(stats));
+		for (r=0 ; r<Rounds ; r++){
+			if (_bench_round(Rates[i], &stats) != 0){
+				fprintf(stderr, "failed to access the region\n");
+				return 1;
+			}
+		}
+		printf(" %12.2f | %7u | %11u | %9u | %8u | %6u\n", Rates[i], (unsigned)stats.u32Flips,
+				(unsigned)stats.u32RawBad, (unsigned)stats.u32Corrected, (unsigned)stats.u32Detected,
+				(unsigned)stats.u32Silent);
+	}
+	_bench_fill();
+	_bench_bus_time();
+	_bench_codec();
+
+	return 0;
+}
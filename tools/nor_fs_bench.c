@@ -0,0 +1,407 @@
+/*
+ * nor_fs_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host benchmark of nor_bd under the access pattern of a filesystem, on the
+ *  simulated device. Each file write of the workload is a logical write, and
+ *  for each workload it reports the hit rate of the read cache, the block
+ *  erases requested, skipped and merged into larger erase commands, and the
+ *  page programs per logical write.
+ *
+ *  The lfs workload follows littlefs: the files go to new blocks from a
+ *  rotating allocator, each block erased just before its first program, the
+ *  data is programmed in chunks of the lfs cache, and every write ends with
+ *  a commit appended to the metadata pair, read back in small pieces first.
+ *  Full metadata blocks are compacted to the other block of the pair.
+ *
+ *  The fat workload follows FatFs with the sector of the block size: every
+ *  write reads the FAT and the directory, rewrites the data clusters with
+ *  NOR_BD_Write, then the FAT, the directory and the FSInfo sector, which
+ *  keeps the same content.
+ *
+ *  Both start with the region erased block by block, like a full format,
+ *  reported apart. At the end, the region is compared with a model on RAM.
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_fs_bench tools/nor_fs_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c nor_bd.c
+ *
+ *  Usage:
+ *    nor_fs_bench [-n files] [-b blocks] [-c cache] [-x seed]
+ *
+ *    -n  file writes of each workload, 2000 if not provided
+ *    -b  blocks of 4 KB of the region, 256 if not provided, up to 1024
+ *    -c  size of the read cache, 256 if not provided, 0 disables it
+ *    -x  seed of the random generator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_bd.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1740EF	// W25Q64
+#define _BENCH_SIZE					(8 * 1024 * 1024)
+#define _BENCH_FIRST_SECTOR			16
+#define _BENCH_BLOCK_SIZE			NOR_SECTOR_SIZE
+#define _BENCH_MAX_BLOCKS			1024
+#define _BENCH_MAX_FILE				(8 * 1024)
+// lfs cache_size, the size of every program of the data
+#define _BENCH_LFS_CACHE			64
+// FatFs layout, the data clusters start after the FAT and the directory
+#define _BENCH_FAT_FSINFO			0
+#define _BENCH_FAT_TABLE			1
+#define _BENCH_FAT_DIR				2
+#define _BENCH_FAT_FIRST_DATA		3
+
+typedef struct{
+	const char *Name;
+	uint32_t u32Writes;
+	uint32_t u32EraseCalls;
+	uint64_t u64TimeUs;
+	uint32_t u32Mismatches;
+	nor_err_e Err;
+}bench_result_t;
+
+static uint8_t Memory[_BENCH_SIZE];
+static uint8_t Model[_BENCH_MAX_BLOCKS * _BENCH_BLOCK_SIZE];
+static uint8_t Buffer[_BENCH_MAX_FILE + _BENCH_BLOCK_SIZE];
+static uint8_t ReadCache[NOR_SECTOR_SIZE];
+static uint8_t ProgCache[NOR_PAGE_SIZE];
+static uint8_t ErasedMap[(_BENCH_MAX_BLOCKS + 7) / 8];
+static uint32_t Blocks = 256, CacheSize = 256;
+static nor_t Nor;
+static nor_sim_t Sim;
+static nor_bd_t Bd;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-n files] [-b blocks] [-c cache] [-x seed]\n", name);
+}
+
+static uint8_t* _bench_model(uint32_t Block, uint32_t Offset){
+	return &Model[(Block * _BENCH_BLOCK_SIZE) + Offset];
+}
+
+static nor_err_e _bench_erase(bench_result_t *pRes, uint32_t Block){
+	pRes->u32EraseCalls++;
+	memset(_bench_model(Block, 0), 0xFF, _BENCH_BLOCK_SIZE);
+	return NOR_BD_Erase(&Bd, Block);
+}
+
+static nor_err_e _bench_prog(uint32_t Block, uint32_t Offset, uint8_t *pData, uint32_t Len){
+	memcpy(_bench_model(Block, Offset), pData, Len);
+	return NOR_BD_Prog(&Bd, Block, Offset, pData, Len);
+}
+
+static nor_err_e _bench_write(uint32_t Block, uint8_t *pData){
+	memcpy(_bench_model(Block, 0), pData, _BENCH_BLOCK_SIZE);
+	return NOR_BD_Write(&Bd, Block, pData);
+}
+
+static void _bench_random(uint8_t *pData, uint32_t Len){
+	uint32_t i;
+
+	for (i=0 ; i<Len ; i++){
+		pData[i] = (uint8_t)rand();
+	}
+}
+
+/*
+ * File size, mostly small, like configuration and log files.
+ */
+static uint32_t _bench_file_size(void){
+	if ((rand() % 4) != 0){
+		return 16 + ((uint32_t)rand() % 496);
+	}
+	return 512 + ((uint32_t)rand() % (_BENCH_MAX_FILE - 512));
+}
+
+static nor_err_e _bench_setup(void){
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _BENCH_JEDEC_ID);
+	memset(&Nor, 0, sizeof(Nor));
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		return NOR_FAIL;
+	}
+	memset(&Bd, 0, sizeof(Bd));
+	Bd.nor = &Nor;
+	Bd.config.u32FirstSector = _BENCH_FIRST_SECTOR;
+	Bd.config.u32BlockSize = _BENCH_BLOCK_SIZE;
+	Bd.config.u32BlockCount = Blocks;
+	if (CacheSize > 0){
+		Bd.config.pReadCache = ReadCache;
+		Bd.config.u16ReadCacheSize = (uint16_t)CacheSize;
+	}
+	Bd.config.pProgCache = ProgCache;
+	Bd.config.u16ProgCacheSize = sizeof(ProgCache);
+	Bd.config.pErasedMap = ErasedMap;
+	// the simulated device starts with random content, like a used part
+	_bench_random(Memory, sizeof(Memory));
+
+	return NOR_BD_Init(&Bd);
+}
+
+static void _bench_start(bench_result_t *pRes, const char *Name){
+	memset(pRes, 0, sizeof(bench_result_t));
+	memset(&Bd.stats, 0, sizeof(Bd.stats));
+	pRes->Name = Name;
+	pRes->u64TimeUs = NOR_SIM_GetTimeUs(&Sim);
+}
+
+static void _bench_stop(bench_result_t *pRes, nor_err_e err){
+	uint32_t Block;
+
+	if (err == NOR_OK){
+		err = NOR_BD_Sync(&Bd);
+	}
+	pRes->Err = err;
+	pRes->u64TimeUs = NOR_SIM_GetTimeUs(&Sim) - pRes->u64TimeUs;
+	for (Block=0 ; Block<Blocks ; Block++){
+		if (NOR_ReadBytes(&Nor, Buffer, ((_BENCH_FIRST_SECTOR * NOR_SECTOR_SIZE) + (Block * _BENCH_BLOCK_SIZE)),
+				_BENCH_BLOCK_SIZE) != NOR_OK || memcmp(Buffer, _bench_model(Block, 0), _BENCH_BLOCK_SIZE) != 0){
+			pRes->u32Mismatches++;
+		}
+	}
+}
+
+static nor_err_e _bench_format(bench_result_t *pRes){
+	uint32_t Block;
+	nor_err_e err = NOR_OK;
+
+	_bench_start(pRes, "format");
+	for (Block=0 ; Block<Blocks && err == NOR_OK ; Block++){
+		err = _bench_erase(pRes, Block);
+	}
+	_bench_stop(pRes, err);
+
+	return pRes->Err;
+}
+
+/*
+ * Metadata commit of littlefs: the tags are read backwards from the end of
+ * the last commit, then the new tags, and the inline data when small, are
+ * appended. A full block is compacted to the other block of the pair.
+ */
+static nor_err_e _bench_lfs_commit(bench_result_t *pRes, uint32_t *pDir, uint32_t *pOff, uint8_t *pInline, uint32_t Len){
+	uint8_t Tags[64];
+	uint32_t Size, i;
+	nor_err_e err;
+
+	for (i=0 ; i<4 && *pOff >= ((i + 1) * 16) ; i++){
+		err = NOR_BD_Read(&Bd, *pDir, *pOff - ((i + 1) * 16), Tags, 16);
+		if (err != NOR_OK){
+			return err;
+		}
+	}
+	// tags and crc, aligned to the prog size of 16 bytes
+	Size = (sizeof(Tags) + Len + 15) & ~15U;
+	if ((*pOff + Size) > _BENCH_BLOCK_SIZE){
+		*pDir ^= 1;
+		err = _bench_erase(pRes, *pDir);
+		for (i=0 ; i<1024 && err == NOR_OK ; i+=_BENCH_LFS_CACHE){
+			_bench_random(Tags, _BENCH_LFS_CACHE);
+			err = _bench_prog(*pDir, i, Tags, _BENCH_LFS_CACHE);
+		}
+		if (err != NOR_OK){
+			return err;
+		}
+		*pOff = 1024;
+	}
+	_bench_random(Tags, sizeof(Tags));
+	err = _bench_prog(*pDir, *pOff, Tags, sizeof(Tags));
+	if (err == NOR_OK && Len > 0){
+		err = _bench_prog(*pDir, *pOff + sizeof(Tags), pInline, Len);
+	}
+	*pOff += Size;
+
+	return err;
+}
+
+static nor_err_e _bench_lfs(bench_result_t *pRes, uint32_t Files){
+	uint32_t Dir = 0, Off = 0, Next = 2, n, Len, Done, Chunk;
+	nor_err_e err = NOR_OK;
+
+	_bench_start(pRes, "lfs");
+	for (n=0 ; n<Files && err == NOR_OK ; n++){
+		Len = _bench_file_size();
+		_bench_random(Buffer, Len);
+		if (Len <= _BENCH_LFS_CACHE){
+			err = _bench_lfs_commit(pRes, &Dir, &Off, Buffer, Len);
+		}
+		else{
+			for (Done=0 ; Done<Len && err == NOR_OK ; Done+=Chunk){
+				if ((Done % _BENCH_BLOCK_SIZE) == 0){
+					err = _bench_erase(pRes, Next);
+				}
+				Chunk = ((Len - Done) > _BENCH_LFS_CACHE) ? _BENCH_LFS_CACHE : (Len - Done);
+				if (err == NOR_OK){
+					err = _bench_prog(Next, Done % _BENCH_BLOCK_SIZE, &Buffer[Done], Chunk);
+				}
+				if (((Done + Chunk) % _BENCH_BLOCK_SIZE) == 0 || (Done + Chunk) == Len){
+					Next = (Next + 1 < Blocks) ? (Next + 1) : 2;
+				}
+			}
+			if (err == NOR_OK){
+				err = _bench_lfs_commit(pRes, &Dir, &Off, NULL, 0);
+			}
+		}
+		if (err == NOR_OK){
+			err = NOR_BD_Sync(&Bd);
+		}
+		pRes->u32Writes++;
+	}
+	_bench_stop(pRes, err);
+
+	return pRes->Err;
+}
+
+/*
+ * Rewrite a metadata sector of FatFs, changing a few bytes of the content.
+ */
+static nor_err_e _bench_fat_update(uint32_t Block, uint32_t Changes){
+	uint8_t *pSector = &Buffer[_BENCH_MAX_FILE];
+	uint32_t i;
+
+	memcpy(pSector, _bench_model(Block, 0), _BENCH_BLOCK_SIZE);
+	for (i=0 ; i<Changes ; i++){
+		pSector[(uint32_t)rand() % _BENCH_BLOCK_SIZE] = (uint8_t)rand();
+	}
+	return _bench_write(Block, pSector);
+}
+
+static nor_err_e _bench_fat(bench_result_t *pRes, uint32_t Files){
+	uint8_t *pSector = &Buffer[_BENCH_MAX_FILE];
+	uint32_t Next = _BENCH_FAT_FIRST_DATA, n, Len, Done;
+	nor_err_e err = NOR_OK;
+
+	_bench_start(pRes, "fat");
+	memset(pSector, 0, _BENCH_BLOCK_SIZE);
+	err = _bench_write(_BENCH_FAT_FSINFO, pSector);
+	for (n=0 ; n<Files && err == NOR_OK ; n++){
+		Len = _bench_file_size();
+		err = NOR_BD_Read(&Bd, _BENCH_FAT_TABLE, 0, pSector, _BENCH_BLOCK_SIZE);
+		if (err == NOR_OK){
+			err = NOR_BD_Read(&Bd, _BENCH_FAT_DIR, 0, pSector, _BENCH_BLOCK_SIZE);
+		}
+		for (Done=0 ; Done<Len && err == NOR_OK ; Done+=_BENCH_BLOCK_SIZE){
+			// the tail of the last cluster keeps the old content
+			memcpy(Buffer, _bench_model(Next, 0), _BENCH_BLOCK_SIZE);
+			_bench_random(Buffer, ((Len - Done) > _BENCH_BLOCK_SIZE) ? _BENCH_BLOCK_SIZE : (Len - Done));
+			err = _bench_write(Next, Buffer);
+			Next = (Next + 1 < Blocks) ? (Next + 1) : _BENCH_FAT_FIRST_DATA;
+		}
+		if (err == NOR_OK){
+			err = _bench_fat_update(_BENCH_FAT_TABLE, 4);
+		}
+		if (err == NOR_OK){
+			err = _bench_fat_update(_BENCH_FAT_DIR, 2);
+		}
+		if (err == NOR_OK){
+			err = _bench_fat_update(_BENCH_FAT_FSINFO, 0);
+		}
+		if (err == NOR_OK){
+			err = NOR_BD_Sync(&Bd);
+		}
+		pRes->u32Writes++;
+	}
+	_bench_stop(pRes, err);
+
+	return pRes->Err;
+}
+
+static void _bench_print(bench_result_t *pRes){
+	uint32_t Reads = Bd.stats.u32CacheHits + Bd.stats.u32BusReads;
+	uint32_t Erased = pRes->u32EraseCalls - Bd.stats.u32ErasesSkipped;
+
+	printf("== %s ==\n", pRes->Name);
+	printf(" Logical writes | %u\n", (unsigned)pRes->u32Writes);
+	printf(" Cache hit rate | %.1f%% (%u hits, %u bus reads, %u erased reads)\n",
+			(Reads > 0) ? (100.0 * Bd.stats.u32CacheHits / Reads) : 0.0, (unsigned)Bd.stats.u32CacheHits,
+			(unsigned)Bd.stats.u32BusReads, (unsigned)Bd.stats.u32ErasedReads);
+	printf(" Block erases   | %u requested, %u skipped\n", (unsigned)pRes->u32EraseCalls,
+			(unsigned)Bd.stats.u32ErasesSkipped);
+	printf(" Erase commands | %u", (unsigned)Bd.stats.u32Erases);
+	if (pRes->u32EraseCalls > 0 && Erased > Bd.stats.u32Erases){
+		printf(", %u block erases merged", (unsigned)(Erased - Bd.stats.u32Erases));
+	}
+	printf("\n");
+	printf(" Programs       | %u", (unsigned)Bd.stats.u32Progs);
+	if (pRes->u32Writes > 0){
+		printf(", %.2f per logical write", (double)Bd.stats.u32Progs / pRes->u32Writes);
+	}
+	printf("\n");
+	printf(" Bus time       | %.1f ms\n", (double)pRes->u64TimeUs / 1000.0);
+	printf(" Check          | %s\n", (pRes->Err != NOR_OK) ? "failed to access" :
+			((pRes->u32Mismatches == 0) ? "ok" : "MISMATCH"));
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	bench_result_t Res;
+	uint32_t Files = 2000, Seed = 1, k;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:b:c:x:")) != -1){
+		switch (opt){
+		case 'n':
+			Files = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			Blocks = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			CacheSize = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			Seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (Files == 0 || Blocks < 16 || Blocks > _BENCH_MAX_BLOCKS || CacheSize > sizeof(ReadCache)){
+		fprintf(stderr, "invalid files, blocks or cache size\n");
+		return 1;
+	}
+	for (k=0 ; k<2 ; k++){
+		srand(Seed);
+		if (_bench_setup() != NOR_OK){
+			fprintf(stderr, "failed to initialize the block device\n");
+			return 1;
+		}
+		_bench_format(&Res);
+		if (k == 0){
+			_bench_print(&Res);
+		}
+		if (Res.Err == NOR_OK){
+			if (k == 0){
+				_bench_lfs(&Res, Files);
+			}
+			else{
+				_bench_fat(&Res, Files);
+			}
+		}
+		_bench_print(&Res);
+		if (Res.Err != NOR_OK || Res.u32Mismatches != 0){
+			return 1;
+		}
+	}
+
+	return 0;
+}
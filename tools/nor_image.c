@@ -0,0 +1,618 @@
+/*
+ * nor_image.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host tool to build the complete content of the flash offline, for the
+ *  production programmer, and to decode a raw dump of a field device. The
+ *  partitions are formatted and filled by the same modules the firmware
+ *  uses, running over the simulated device, so the image is exactly what
+ *  the firmware would write on the first boot.
+ *
+ *  Build, from the repository root:
+ *    gcc -I. -Itools -o nor_image tools/nor_image.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c \
+ *        nor_jrnl.c nor_log.c nor_lz.c nor_cnt.c
+ *
+ *  Usage:
+ *    nor_image [-j jedec] build layout.txt image.bin
+ *    nor_image [-j jedec] inspect layout.txt dump.bin
+ *    nor_image [-j jedec] extract layout.txt dump.bin partition out.bin
+ *
+ *    -j  JEDEC ID of the device, in hex, 0x1740EF (W25Q64) if not provided
+ *
+ *  The layout has one partition per line, # starts a comment:
+ *    name  type  first_sector  sector_count  [key=value ...]
+ *
+ *    raw   file=           content programmed as it is
+ *    jrnl  pages= file=    journaled blob, nor_jrnl.h
+ *    log   record= file=   log of fixed size records, the file is split in
+ *                          records, with the index as timestamp, nor_log.h
+ *    lz    chunk= file=    compressed region, nor_lz.h, chunk of 4096 bytes
+ *                          by default
+ *    cnt   value=          counter, nor_cnt.h
+ *
+ *  The extract command writes the decoded content of a partition: the used
+ *  bytes of raw, the blob of jrnl, the payloads of log and the data of lz.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_sim.h"
+#include "nor_crc.h"
+#include "nor_jrnl.h"
+#include "nor_log.h"
+#include "nor_lz.h"
+#include "nor_cnt.h"
+
+/*
+ * Privates
+ */
+
+#define _IMAGE_JEDEC_ID				0x1740EF	// W25Q64
+#define _IMAGE_MAX_PARTS			32
+#define _IMAGE_NAME_LEN				16
+#define _IMAGE_PATH_LEN				256
+#define _IMAGE_LZ_CHUNK				4096
+#define _IMAGE_LZ_INDEX				256
+
+typedef enum{
+	_IMAGE_RAW,
+	_IMAGE_JRNL,
+	_IMAGE_LOG,
+	_IMAGE_LZ,
+	_IMAGE_CNT,
+	_IMAGE_TYPES
+}_image_type_e;
+
+typedef struct{
+	char Name[_IMAGE_NAME_LEN];
+	_image_type_e Type;
+	uint32_t u32FirstSector;
+	uint32_t u32SectorCount;
+	// pages of jrnl, record size of log, chunk of lz and value of cnt
+	uint32_t u32Param;
+	char File[_IMAGE_PATH_LEN];
+}_image_part_t;
+
+static const char *TypeNames[_IMAGE_TYPES] = {"raw", "jrnl", "log", "lz", "cnt"};
+static const char *ParamNames[_IMAGE_TYPES] = {NULL, "pages", "record", "chunk", "value"};
+
+static _image_part_t Parts[_IMAGE_MAX_PARTS];
+static uint32_t PartCount;
+static nor_t Nor;
+static nor_sim_t Sim;
+
+/* Functions */
+
+static uint8_t *_image_load(const char *path, uint32_t *pLen){
+	FILE *fp = fopen(path, "rb");
+	uint8_t *pData;
+	long len;
+
+	if (fp == NULL){
+		fprintf(stderr, "can't open %s\n", path);
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	// one byte more, so an empty file still gets a buffer
+	pData = malloc(len + 1);
+	if (pData != NULL && fread(pData, 1, len, fp) != (size_t)len){
+		free(pData);
+		pData = NULL;
+	}
+	fclose(fp);
+	*pLen = len;
+	return pData;
+}
+
+static int _image_save(const char *path, uint8_t *pData, uint32_t Len){
+	FILE *fp = fopen(path, "wb");
+	size_t n;
+
+	if (fp == NULL){
+		fprintf(stderr, "can't create %s\n", path);
+		return -1;
+	}
+	n = fwrite(pData, 1, Len, fp);
+	fclose(fp);
+	return (n == Len) ? 0 : -1;
+}
+
+static int _image_parse_line(char *line, uint32_t LineNum){
+	_image_part_t *part = &Parts[PartCount];
+	char Type[16], *tok, *value;
+	uint32_t i;
+	int n;
+
+	memset(part, 0, sizeof(*part));
+	if (sscanf(line, "%15s %15s %u %u %n", part->Name, Type, &part->u32FirstSector, &part->u32SectorCount, &n) != 4){
+		fprintf(stderr, "line %u: expected name, type, first sector and sector count\n", (unsigned)LineNum);
+		return -1;
+	}
+	for (i=0 ; i<_IMAGE_TYPES && strcmp(Type, TypeNames[i]) != 0 ; i++);
+	if (i == _IMAGE_TYPES){
+		fprintf(stderr, "line %u: unknown type %s\n", (unsigned)LineNum, Type);
+		return -1;
+	}
+	part->Type = i;
+	if (part->Type == _IMAGE_LZ){
+		part->u32Param = _IMAGE_LZ_CHUNK;
+	}
+	for (tok=strtok(line + n, " \t\r\n") ; tok!=NULL ; tok=strtok(NULL, " \t\r\n")){
+		value = strchr(tok, '=');
+		if (value == NULL){
+			fprintf(stderr, "line %u: expected key=value, got %s\n", (unsigned)LineNum, tok);
+			return -1;
+		}
+		*value++ = '\0';
+		if (strcmp(tok, "file") == 0 && part->Type != _IMAGE_CNT){
+			snprintf(part->File, sizeof(part->File), "%s", value);
+		}
+		else if (ParamNames[part->Type] != NULL && strcmp(tok, ParamNames[part->Type]) == 0){
+			part->u32Param = strtoul(value, NULL, 0);
+		}
+		else{
+			fprintf(stderr, "line %u: unknown option %s for %s\n", (unsigned)LineNum, tok, Type);
+			return -1;
+		}
+	}
+	if ((part->Type == _IMAGE_JRNL || part->Type == _IMAGE_LOG || part->Type == _IMAGE_LZ) &&
+			(part->u32Param == 0 || part->u32Param > 0xFFFF)){
+		fprintf(stderr, "line %u: %s needs %s, from 1 to 65535\n", (unsigned)LineNum, Type, ParamNames[part->Type]);
+		return -1;
+	}
+	PartCount++;
+	return 0;
+}
+
+static int _image_parse(const char *path){
+	char line[512], *p;
+	uint32_t LineNum = 0, i, k;
+	FILE *fp = fopen(path, "r");
+
+	if (fp == NULL){
+		fprintf(stderr, "can't open %s\n", path);
+		return -1;
+	}
+	PartCount = 0;
+	while (fgets(line, sizeof(line), fp) != NULL){
+		LineNum++;
+		if ((p = strchr(line, '#')) != NULL){
+			*p = '\0';
+		}
+		for (p=line ; *p==' ' || *p=='\t' ; p++);
+		if (*p == '\0' || *p == '\r' || *p == '\n'){
+			continue;
+		}
+		if (PartCount >= _IMAGE_MAX_PARTS){
+			fprintf(stderr, "line %u: more than %d partitions\n", (unsigned)LineNum, _IMAGE_MAX_PARTS);
+			fclose(fp);
+			return -1;
+		}
+		if (_image_parse_line(p, LineNum) != 0){
+			fclose(fp);
+			return -1;
+		}
+	}
+	fclose(fp);
+	for (i=0 ; i<PartCount ; i++){
+		if (Parts[i].u32SectorCount == 0){
+			fprintf(stderr, "%s: no sectors\n", Parts[i].Name);
+			return -1;
+		}
+		if ((Parts[i].u32FirstSector + Parts[i].u32SectorCount) > Nor.info.u32SectorCount){
+			fprintf(stderr, "%s: sectors %u to %u are out of the device\n", Parts[i].Name,
+					(unsigned)Parts[i].u32FirstSector, (unsigned)(Parts[i].u32FirstSector + Parts[i].u32SectorCount - 1));
+			return -1;
+		}
+		for (k=0 ; k<i ; k++){
+			if (Parts[i].u32FirstSector < (Parts[k].u32FirstSector + Parts[k].u32SectorCount) &&
+					Parts[k].u32FirstSector < (Parts[i].u32FirstSector + Parts[i].u32SectorCount)){
+				fprintf(stderr, "%s overlaps %s\n", Parts[i].Name, Parts[k].Name);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static _image_part_t *_image_find(const char *Name){
+	uint32_t i;
+
+	for (i=0 ; i<PartCount ; i++){
+		if (strcmp(Parts[i].Name, Name) == 0){
+			return &Parts[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Instances of the modules, mounted over a partition
+ */
+
+static int _image_jrnl(_image_part_t *part, nor_jrnl_t *j){
+	memset(j, 0, sizeof(*j));
+	j->nor = &Nor;
+	j->config.u32FirstSector = part->u32FirstSector;
+	j->config.u32SectorCount = part->u32SectorCount;
+	j->config.u16PageCount = part->u32Param;
+	j->config.pMap = malloc(part->u32Param * sizeof(uint32_t));
+	if (j->config.pMap == NULL || NOR_JRNL_Init(j) != NOR_OK){
+		fprintf(stderr, "%s: failed to mount the journal, is the region big enough?\n", part->Name);
+		return -1;
+	}
+	return 0;
+}
+
+static int _image_lz(_image_part_t *part, nor_lz_t *lz){
+	memset(lz, 0, sizeof(*lz));
+	lz->nor = &Nor;
+	lz->config.u32FirstSector = part->u32FirstSector;
+	lz->config.u32SectorCount = part->u32SectorCount;
+	lz->config.u16ChunkSize = part->u32Param;
+	lz->config.pRawBuffer = malloc(part->u32Param);
+	lz->config.pReadBuffer = malloc(part->u32Param);
+	lz->config.pCompBuffer = malloc(NOR_LZ_COMP_BUFFER_SIZE(part->u32Param));
+	lz->config.pIndex = malloc(_IMAGE_LZ_INDEX * sizeof(nor_lz_index_t));
+	lz->config.u16IndexSize = _IMAGE_LZ_INDEX;
+	if (NOR_LZ_Init(lz) != NOR_OK){
+		fprintf(stderr, "%s: failed to mount the compressed region\n", part->Name);
+		return -1;
+	}
+	return 0;
+}
+
+static int _image_log(_image_part_t *part, nor_log_t *log){
+	if (NOR_LOG_Init(log, &Nor, part->u32FirstSector, part->u32SectorCount, part->u32Param) != NOR_OK){
+		fprintf(stderr, "%s: invalid log geometry\n", part->Name);
+		return -1;
+	}
+	return 0;
+}
+
+static int _image_cnt(_image_part_t *part, nor_cnt_t *cnt){
+	memset(cnt, 0, sizeof(*cnt));
+	cnt->nor = &Nor;
+	cnt->config.u32FirstSector = part->u32FirstSector;
+	cnt->config.u32SectorCount = part->u32SectorCount;
+	if (NOR_CNT_Init(cnt) != NOR_OK){
+		fprintf(stderr, "%s: failed to mount the counter\n", part->Name);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Build
+ */
+
+static int _image_build_part(_image_part_t *part){
+	uint8_t *pData = NULL;
+	uint32_t Len = 0, Start, n, i;
+	nor_jrnl_t j;
+	nor_log_t log;
+	nor_lz_t lz;
+	nor_cnt_t cnt;
+	nor_err_e err = NOR_OK;
+
+	Start = part->u32FirstSector * Nor.info.u16SectorSize;
+	if (part->File[0] != '\0' && (pData = _image_load(part->File, &Len)) == NULL){
+		return -1;
+	}
+	switch (part->Type){
+	case _IMAGE_RAW:
+		if (Len > (part->u32SectorCount * Nor.info.u16SectorSize)){
+			fprintf(stderr, "%s: %s doesn't fit\n", part->Name, part->File);
+			err = NOR_OUT_OF_RANGE;
+			break;
+		}
+		if (Len > 0){
+			err = NOR_WriteBytes(&Nor, pData, Start, Len);
+		}
+		break;
+	case _IMAGE_JRNL:
+		if (Len > (part->u32Param * NOR_PAGE_SIZE)){
+			fprintf(stderr, "%s: %s is bigger than the blob\n", part->Name, part->File);
+			err = NOR_OUT_OF_RANGE;
+			break;
+		}
+		if (_image_jrnl(part, &j) != 0 || NOR_JRNL_Format(&j) != NOR_OK){
+			err = NOR_FAIL;
+			break;
+		}
+		for (i=0 ; i<Len && err==NOR_OK ; i+=n){
+			n = ((Len - i) < (NOR_JRNL_MAX_PAGES * NOR_PAGE_SIZE)) ? (Len - i) : (NOR_JRNL_MAX_PAGES * NOR_PAGE_SIZE);
+			err = NOR_JRNL_Write(&j, i, &pData[i], n);
+		}
+		free(j.config.pMap);
+		break;
+	case _IMAGE_LOG:
+		if ((Len % part->u32Param) != 0){
+			fprintf(stderr, "%s: %s isn't a multiple of the record size\n", part->Name, part->File);
+			err = NOR_INVALID_PARAMS;
+			break;
+		}
+		if (_image_log(part, &log) != 0 || NOR_LOG_Format(&log) != NOR_OK){
+			err = NOR_FAIL;
+			break;
+		}
+		for (i=0 ; i<(Len / part->u32Param) && err==NOR_OK ; i++){
+			err = NOR_LOG_Append(&log, i, &pData[i * part->u32Param]);
+		}
+		break;
+	case _IMAGE_LZ:
+		if (_image_lz(part, &lz) != 0 || NOR_LZ_Format(&lz) != NOR_OK){
+			err = NOR_FAIL;
+			break;
+		}
+		err = NOR_LZ_Append(&lz, pData, Len);
+		if (err == NOR_OK){
+			err = NOR_LZ_Flush(&lz);
+		}
+		break;
+	case _IMAGE_CNT:
+		// the counter starts at zero on a blank region
+		for (i=0 ; i<part->u32SectorCount && err==NOR_OK ; i++){
+			err = NOR_EraseSector(&Nor, part->u32FirstSector + i);
+		}
+		if (err != NOR_OK || _image_cnt(part, &cnt) != 0){
+			err = NOR_FAIL;
+			break;
+		}
+		for (i=0 ; i<part->u32Param && err==NOR_OK ; i++){
+			err = NOR_CNT_Increment(&cnt);
+		}
+		break;
+	default:
+		break;
+	}
+	free(pData);
+	if (err != NOR_OK){
+		fprintf(stderr, "%s: failed to build, error %d\n", part->Name, (int)err);
+		return -1;
+	}
+	printf(" %-16s| %-4s | sectors %5u to %5u | %u bytes\n", part->Name, TypeNames[part->Type],
+			(unsigned)part->u32FirstSector, (unsigned)(part->u32FirstSector + part->u32SectorCount - 1), (unsigned)Len);
+	return 0;
+}
+
+static int _image_build(const char *Output){
+	uint32_t i;
+
+	printf("== Build ==\n");
+	for (i=0 ; i<PartCount ; i++){
+		if (_image_build_part(&Parts[i]) != 0){
+			return -1;
+		}
+	}
+	if (NOR_Sync(&Nor) != NOR_OK || NOR_SIM_SaveFile(&Sim, Output) != 0){
+		fprintf(stderr, "can't save %s\n", Output);
+		return -1;
+	}
+	printf(" Page programs | %u\n", (unsigned)Sim.stats.u32PagePrograms);
+	printf(" Erases        | %u\n", (unsigned)Sim.stats.u32Erases);
+	printf(" Device time   | %llu ms\n", (unsigned long long)(NOR_SIM_GetTimeUs(&Sim) / 1000));
+	return 0;
+}
+
+/*
+ * Inspect and extract
+ */
+
+static uint32_t _image_raw_used(_image_part_t *part){
+	uint32_t Start = part->u32FirstSector * Nor.info.u16SectorSize;
+	uint32_t Len = part->u32SectorCount * Nor.info.u16SectorSize;
+
+	while (Len > 0 && Sim.pMem[Start + Len - 1] == 0xFF){
+		Len--;
+	}
+	return Len;
+}
+
+/*
+ * Decode a partition. With pLen NULL, a summary is printed, otherwise the
+ * content is returned on a buffer allocated here.
+ */
+static int _image_decode(_image_part_t *part, uint8_t **ppData, uint32_t *pLen){
+	uint8_t *pData = NULL;
+	uint32_t Len = 0, Stored, First, Count, T0 = 0, T1 = 0, Value, i;
+	nor_jrnl_t j;
+	nor_log_t log;
+	nor_lz_t lz;
+	nor_cnt_t cnt;
+	nor_err_e err = NOR_OK;
+
+	switch (part->Type){
+	case _IMAGE_RAW:
+		Len = _image_raw_used(part);
+		pData = malloc(Len + 1);
+		err = NOR_ReadBytes(&Nor, pData, part->u32FirstSector * Nor.info.u16SectorSize, Len);
+		if (pLen == NULL){
+			printf("   used %u bytes, crc32 %08X\n", (unsigned)Len, (unsigned)NOR_CRC32(0, pData, Len));
+		}
+		break;
+	case _IMAGE_JRNL:
+		if (_image_jrnl(part, &j) != 0){
+			return -1;
+		}
+		Len = part->u32Param * NOR_PAGE_SIZE;
+		pData = malloc(Len);
+		err = NOR_JRNL_Read(&j, 0, pData, Len);
+		if (pLen == NULL){
+			for (i=0, Count=0 ; i<part->u32Param ; i++){
+				Count += (j.config.pMap[i] != NOR_JRNL_NONE);
+			}
+			printf("   %u of %u pages written, %u sectors in use, %u records discarded\n", (unsigned)Count,
+					(unsigned)part->u32Param, (unsigned)j._internal.u32Used, (unsigned)j.stats.u32Discarded);
+			printf("   blob crc32 %08X\n", (unsigned)NOR_CRC32(0, pData, Len));
+		}
+		free(j.config.pMap);
+		break;
+	case _IMAGE_LOG:
+		if (_image_log(part, &log) != 0 || NOR_LOG_Mount(&log) != NOR_OK ||
+				NOR_LOG_GetRange(&log, &First, &Count) != NOR_OK){
+			fprintf(stderr, "%s: no valid log\n", part->Name);
+			return -1;
+		}
+		Len = Count * part->u32Param;
+		pData = malloc(Len + 1);
+		for (i=0 ; i<Count && err==NOR_OK ; i++){
+			err = NOR_LOG_Read(&log, First + i, &Value, &pData[i * part->u32Param]);
+			T0 = (i == 0) ? Value : T0;
+			T1 = Value;
+		}
+		if (pLen == NULL){
+			printf("   %u records, sequence %u to %u, timestamp %u to %u\n", (unsigned)Count,
+					(unsigned)First, (unsigned)(First + Count - 1), (unsigned)T0, (unsigned)T1);
+		}
+		break;
+	case _IMAGE_LZ:
+		if (_image_lz(part, &lz) != 0){
+			return -1;
+		}
+		NOR_LZ_GetSize(&lz, &Len);
+		pData = malloc(Len + 1);
+		err = NOR_LZ_Read(&lz, 0, pData, Len);
+		if (pLen == NULL){
+			Stored = lz._internal.u32WriteAddr - lz._internal.u32Start;
+			printf("   %u bytes in %u chunks, %u bytes stored (%u%%), crc32 %08X\n", (unsigned)Len,
+					(unsigned)lz._internal.u32Chunks, (unsigned)Stored, (unsigned)(Len ? ((uint64_t)Stored * 100) / Len : 0),
+					(unsigned)NOR_CRC32(0, pData, Len));
+		}
+		free(lz.config.pRawBuffer);
+		free(lz.config.pReadBuffer);
+		free(lz.config.pCompBuffer);
+		free(lz.config.pIndex);
+		break;
+	case _IMAGE_CNT:
+		if (_image_cnt(part, &cnt) != 0){
+			return -1;
+		}
+		NOR_CNT_Get(&cnt, &Value);
+		if (pLen == NULL){
+			printf("   value %u\n", (unsigned)Value);
+		}
+		break;
+	default:
+		break;
+	}
+	if (err != NOR_OK){
+		fprintf(stderr, "%s: failed to decode, error %d\n", part->Name, (int)err);
+		free(pData);
+		return -1;
+	}
+	if (pLen != NULL){
+		*ppData = pData;
+		*pLen = Len;
+	}
+	else{
+		free(pData);
+	}
+	return 0;
+}
+
+static int _image_inspect(void){
+	uint32_t i;
+	int ret = 0;
+
+	printf("== Inspect ==\n");
+	for (i=0 ; i<PartCount ; i++){
+		printf(" %-16s| %-4s | sectors %5u to %5u\n", Parts[i].Name, TypeNames[Parts[i].Type],
+				(unsigned)Parts[i].u32FirstSector, (unsigned)(Parts[i].u32FirstSector + Parts[i].u32SectorCount - 1));
+		if (_image_decode(&Parts[i], NULL, NULL) != 0){
+			ret = -1;
+		}
+	}
+	return ret;
+}
+
+static void _image_usage(const char *name){
+	fprintf(stderr, "usage: %s [-j jedec] build layout.txt image.bin\n", name);
+	fprintf(stderr, "       %s [-j jedec] inspect layout.txt dump.bin\n", name);
+	fprintf(stderr, "       %s [-j jedec] extract layout.txt dump.bin partition out.bin\n", name);
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	uint32_t JedecID = _IMAGE_JEDEC_ID, Size, Len;
+	_image_part_t *part;
+	const char *Cmd;
+	uint8_t *pMem, *pData;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "j:")) != -1){
+		switch (opt){
+		case 'j':
+			JedecID = strtoul(optarg, NULL, 16);
+			break;
+		default:
+			_image_usage(argv[0]);
+			return 1;
+		}
+	}
+	if ((argc - optind) < 3){
+		_image_usage(argv[0]);
+		return 1;
+	}
+	Cmd = argv[optind];
+	if ((strcmp(Cmd, "extract") == 0 && (argc - optind) < 5) ||
+			(strcmp(Cmd, "build") != 0 && strcmp(Cmd, "inspect") != 0 && strcmp(Cmd, "extract") != 0)){
+		_image_usage(argv[0]);
+		return 1;
+	}
+	// the capacity byte of the JEDEC ID is log2 of the size
+	Size = ((JedecID >> 16) & 0xFF);
+	pMem = (Size >= 16 && Size <= 27) ? malloc(1UL << Size) : NULL;
+	Size = 1UL << Size;
+	if (pMem == NULL){
+		fprintf(stderr, "unsupported JEDEC ID %06X\n", (unsigned)JedecID);
+		return 1;
+	}
+	NOR_SIM_Init(&Sim, pMem, Size, JedecID);
+	if (strcmp(Cmd, "build") != 0 && NOR_SIM_LoadFile(&Sim, argv[optind + 2]) != 0){
+		fprintf(stderr, "can't open %s\n", argv[optind + 2]);
+		return 1;
+	}
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		fprintf(stderr, "failed to initialize the driver\n");
+		return 1;
+	}
+	if (_image_parse(argv[optind + 1]) != 0){
+		return 1;
+	}
+
+	if (strcmp(Cmd, "build") == 0){
+		ret = _image_build(argv[optind + 2]);
+	}
+	else if (strcmp(Cmd, "inspect") == 0){
+		ret = _image_inspect();
+	}
+	else{
+		part = _image_find(argv[optind + 3]);
+		if (part == NULL){
+			fprintf(stderr, "no partition %s on the layout\n", argv[optind + 3]);
+			return 1;
+		}
+		ret = _image_decode(part, &pData, &Len);
+		if (ret == 0){
+			ret = _image_save(argv[optind + 4], pData, Len);
+			free(pData);
+		}
+	}
+	free(pMem);
+
+	return (ret == 0) ? 0 : 1;
+}
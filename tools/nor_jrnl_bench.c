@@ -0,0 +1,304 @@
+/*
+ * nor_jrnl_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host harness of nor_jrnl on the simulated device.
+ *
+ *  The powercut command runs random updates, and for each one it cuts the
+ *  power on every SPI transaction of the update, from the same starting
+ *  content. After each cut the journal is mounted again and the blob must
+ *  read all old or all new, and the journal must keep working.
+ *
+ *  The erases command measures the erases, the page programs and the time
+ *  of the bus per update, for updates of 1, 4 and all the pages, against the
+ *  erases of rewriting the touched sectors in place.
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_jrnl_bench tools/nor_jrnl_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c nor_jrnl.c
+ *
+ *  Usage:
+ *    nor_jrnl_bench [-p pages] [-s sectors] [-n count] [-x seed] powercut
+ *    nor_jrnl_bench [-p pages] [-s sectors] [-n count] [-x seed] erases
+ *
+ *    -p  pages of the blob, 8 if not provided
+ *    -s  sectors of the region, 8 if not provided
+ *    -n  updates swept by powercut, 100 by default, or timed by erases,
+ *        10000 by default
+ *    -x  seed of the random generator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_jrnl.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1740EF	// W25Q64
+#define _BENCH_SIZE					(8 * 1024 * 1024)
+#define _BENCH_FIRST_SECTOR			16
+#define _BENCH_MAX_PAGES			1024
+#define _BENCH_MAX_SECTORS			256
+// updates done after the recovery of each cut, before mount again
+#define _BENCH_AFTER_CUT			3
+
+static uint8_t Memory[_BENCH_SIZE];
+static uint8_t Snapshot[_BENCH_MAX_SECTORS * NOR_SECTOR_SIZE];
+static uint8_t Model[_BENCH_MAX_PAGES * NOR_PAGE_SIZE];
+static uint8_t New[_BENCH_MAX_PAGES * NOR_PAGE_SIZE];
+static uint8_t Current[_BENCH_MAX_PAGES * NOR_PAGE_SIZE];
+static uint8_t Buffer[_BENCH_MAX_PAGES * NOR_PAGE_SIZE];
+static uint8_t Data[_BENCH_MAX_PAGES * NOR_PAGE_SIZE];
+static uint32_t Map[_BENCH_MAX_PAGES];
+static uint32_t Pages = 8, Sectors = 8;
+static nor_t Nor;
+static nor_sim_t Sim;
+static nor_jrnl_t Jrnl;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-p pages] [-s sectors] [-n count] [-x seed] powercut|erases\n", name);
+}
+
+static uint32_t _bench_blob(void){
+	return Pages * NOR_PAGE_SIZE;
+}
+
+static uint32_t _bench_region(void){
+	return _BENCH_FIRST_SECTOR * NOR_SECTOR_SIZE;
+}
+
+static nor_err_e _bench_mount(void){
+	memset(&Nor, 0, sizeof(Nor));
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		return NOR_FAIL;
+	}
+	memset(&Jrnl, 0, sizeof(Jrnl));
+	Jrnl.nor = &Nor;
+	Jrnl.config.u32FirstSector = _BENCH_FIRST_SECTOR;
+	Jrnl.config.u32SectorCount = Sectors;
+	Jrnl.config.u16PageCount = (uint16_t)Pages;
+	Jrnl.config.pMap = Map;
+
+	return NOR_JRNL_Init(&Jrnl);
+}
+
+/*
+ * Random update, mostly small, sometimes of the largest size accepted.
+ */
+static void _bench_random_update(uint32_t *pOffset, uint32_t *pLen){
+	uint32_t i, Max = _bench_blob();
+
+	if (Max > (NOR_JRNL_MAX_PAGES - 1) * NOR_PAGE_SIZE){
+		Max = (NOR_JRNL_MAX_PAGES - 1) * NOR_PAGE_SIZE;
+	}
+	*pOffset = (uint32_t)rand() % _bench_blob();
+	*pLen = 1 + ((uint32_t)rand() % (((rand() % 4) == 0) ? Max : 300));
+	if ((*pOffset + *pLen) > _bench_blob()){
+		*pLen = _bench_blob() - *pOffset;
+	}
+	for (i=0 ; i<*pLen ; i++){
+		Data[i] = (uint8_t)rand();
+	}
+}
+
+static int _bench_check(const uint8_t *pExpected){
+	if (NOR_JRNL_Read(&Jrnl, 0, Buffer, _bench_blob()) != NOR_OK){
+		return -1;
+	}
+	return (memcmp(Buffer, pExpected, _bench_blob()) == 0) ? 0 : -1;
+}
+
+static int _bench_powercut(uint32_t Count){
+	uint32_t n, Cut, Transactions, Offset, Len, i, o2, l2;
+	uint32_t Olds = 0, News = 0, Cuts = 0;
+
+	if (_bench_mount() != NOR_OK || NOR_JRNL_Format(&Jrnl) != NOR_OK){
+		fprintf(stderr, "failed to mount the journal\n");
+		return 1;
+	}
+	memset(Model, 0xFF, _bench_blob());
+	for (n=0 ; n<Count ; n++){
+		_bench_random_update(&Offset, &Len);
+		memcpy(New, Model, _bench_blob());
+		memcpy(&New[Offset], Data, Len);
+		memcpy(Snapshot, &Memory[_bench_region()], Sectors * NOR_SECTOR_SIZE);
+		// a run without cut gives the transactions of the update
+		if (_bench_mount() != NOR_OK){
+			fprintf(stderr, "update %u: failed to mount\n", (unsigned)n);
+			return 1;
+		}
+		Transactions = Sim.stats.u32Transactions;
+		if (NOR_JRNL_Write(&Jrnl, Offset, &New[Offset], Len) != NOR_OK){
+			fprintf(stderr, "update %u: failed to write\n", (unsigned)n);
+			return 1;
+		}
+		Transactions = Sim.stats.u32Transactions - Transactions;
+		for (Cut=1 ; Cut<=Transactions ; Cut++){
+			memcpy(&Memory[_bench_region()], Snapshot, Sectors * NOR_SECTOR_SIZE);
+			NOR_SIM_PowerOn(&Sim);
+			if (_bench_mount() != NOR_OK){
+				fprintf(stderr, "update %u cut %u: failed to mount\n", (unsigned)n, (unsigned)Cut);
+				return 1;
+			}
+			NOR_SIM_SchedulePowerCut(&Sim, Cut);
+			NOR_JRNL_Write(&Jrnl, Offset, &New[Offset], Len);
+			NOR_SIM_SchedulePowerCut(&Sim, 0);
+			Cuts += Sim._internal.u8PowerOff;
+			NOR_SIM_PowerOn(&Sim);
+			if (_bench_mount() != NOR_OK){
+				fprintf(stderr, "update %u cut %u/%u: failed to mount after the cut\n",
+						(unsigned)n, (unsigned)Cut, (unsigned)Transactions);
+				return 1;
+			}
+			if (_bench_check(Model) == 0){
+				memcpy(Current, Model, _bench_blob());
+				Olds++;
+			}
+			else if (_bench_check(New) == 0){
+				memcpy(Current, New, _bench_blob());
+				News++;
+			}
+			else{
+				fprintf(stderr, "update %u cut %u/%u: torn blob\n", (unsigned)n, (unsigned)Cut, (unsigned)Transactions);
+				return 1;
+			}
+			// the recovered journal keeps working
+			for (i=0 ; i<_BENCH_AFTER_CUT ; i++){
+				_bench_random_update(&o2, &l2);
+				if (NOR_JRNL_Write(&Jrnl, o2, Data, l2) != NOR_OK){
+					fprintf(stderr, "update %u cut %u: failed to write after the cut\n", (unsigned)n, (unsigned)Cut);
+					return 1;
+				}
+				memcpy(&Current[o2], Data, l2);
+			}
+			if (_bench_mount() != NOR_OK || _bench_check(Current) != 0){
+				fprintf(stderr, "update %u cut %u: lost the updates after the cut\n", (unsigned)n, (unsigned)Cut);
+				return 1;
+			}
+		}
+		// the next update starts from the complete one
+		memcpy(&Memory[_bench_region()], Snapshot, Sectors * NOR_SECTOR_SIZE);
+		NOR_SIM_PowerOn(&Sim);
+		if (_bench_mount() != NOR_OK || NOR_JRNL_Write(&Jrnl, Offset, &New[Offset], Len) != NOR_OK){
+			fprintf(stderr, "update %u: failed to complete\n", (unsigned)n);
+			return 1;
+		}
+		memcpy(Model, New, _bench_blob());
+	}
+	printf("== Power cuts ==\n");
+	printf(" Updates       | %u\n", (unsigned)Count);
+	printf(" Cuts          | %u\n", (unsigned)Cuts);
+	printf(" Read old      | %u\n", (unsigned)Olds);
+	printf(" Read new      | %u\n", (unsigned)News);
+	printf(" Torn          | 0\n");
+
+	return 0;
+}
+
+static int _bench_erases(uint32_t Count){
+	const uint32_t Sizes[] = {1, 4, Pages};
+	uint32_t i, n, k, Size, Offset, Erases, Programs, InPlace;
+	uint64_t Start;
+
+	if (_bench_mount() != NOR_OK){
+		fprintf(stderr, "failed to mount the journal\n");
+		return 1;
+	}
+	printf("== Updates of random data, %u each ==\n", (unsigned)Count);
+	printf(" pages | erases/update | in place | programs/update | bus us/update\n");
+	for (i=0 ; i<(sizeof(Sizes) / sizeof(Sizes[0])) ; i++){
+		Size = Sizes[i];
+		if (Size > Pages || Size >= NOR_JRNL_MAX_PAGES || (i > 0 && Size == Sizes[i - 1])){
+			continue;
+		}
+		if (NOR_JRNL_Format(&Jrnl) != NOR_OK){
+			fprintf(stderr, "failed to format\n");
+			return 1;
+		}
+		Erases = Sim.stats.u32Erases;
+		Programs = Sim.stats.u32PagePrograms;
+		InPlace = 0;
+		Start = NOR_SIM_GetTimeUs(&Sim);
+		for (n=0 ; n<Count ; n++){
+			Offset = ((uint32_t)rand() % (Pages - Size + 1)) * NOR_PAGE_SIZE;
+			for (k=0 ; k<(Size * NOR_PAGE_SIZE) ; k++){
+				Data[k] = (uint8_t)rand();
+			}
+			if (NOR_JRNL_Write(&Jrnl, Offset, Data, Size * NOR_PAGE_SIZE) != NOR_OK){
+				fprintf(stderr, "failed to write\n");
+				return 1;
+			}
+			// a rewrite in place erases every sector touched
+			InPlace += ((Offset + (Size * NOR_PAGE_SIZE) - 1) / NOR_SECTOR_SIZE) - (Offset / NOR_SECTOR_SIZE) + 1;
+		}
+		printf(" %5u | %13.4f | %8.2f | %15.2f | %13.1f\n", (unsigned)Size,
+				(double)(Sim.stats.u32Erases - Erases) / Count, (double)InPlace / Count,
+				(double)(Sim.stats.u32PagePrograms - Programs) / Count,
+				(double)(NOR_SIM_GetTimeUs(&Sim) - Start) / Count);
+	}
+
+	return 0;
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	uint32_t Count = 0, Seed = 1;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "p:s:n:x:")) != -1){
+		switch (opt){
+		case 'p':
+			Pages = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			Sectors = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			Count = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			Seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc || Pages == 0 || Pages > _BENCH_MAX_PAGES || Sectors > _BENCH_MAX_SECTORS){
+		_bench_usage(argv[0]);
+		return 1;
+	}
+	srand(Seed);
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _BENCH_JEDEC_ID);
+	if (_bench_mount() == NOR_INVALID_PARAMS){
+		fprintf(stderr, "the region is too small for the blob, see NOR_JRNL_Init\n");
+		return 1;
+	}
+	if (strcmp(argv[optind], "powercut") == 0){
+		ret = _bench_powercut((Count != 0) ? Count : 100);
+	}
+	else if (strcmp(argv[optind], "erases") == 0){
+		ret = _bench_erases((Count != 0) ? Count : 10000);
+	}
+	else{
+		_bench_usage(argv[0]);
+		ret = 1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,236 @@
+/*
+ * nor_lz_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host benchmark of nor_lz on the simulated device. The data is appended
+ *  in records of 64 bytes, and for each kind of data it reports the
+ *  compression ratio, the page programs, the sectors filled and the device
+ *  time of the programs, against writing the same data raw on erased
+ *  sectors. The throughput of the append and of reading back the whole
+ *  region is measured on the host CPU, with the simulated bus.
+ *
+ *  The csv data is telemetry of a sensor, with slowly changing values. The
+ *  random data doesn't compress, and every chunk is stored as it is.
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_lz_bench tools/nor_lz_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c nor_lz.c
+ *
+ *  Usage:
+ *    nor_lz_bench [-n bytes] [-c chunk] [-x seed]
+ *
+ *    -n  bytes appended, 1000000 if not provided, up to 1 MB
+ *    -c  chunk size, 4096 if not provided
+ *    -x  seed of the random generator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_lz.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1740EF	// W25Q64
+#define _BENCH_SIZE					(8 * 1024 * 1024)
+#define _BENCH_MAX_DATA				(1024 * 1024)
+#define _BENCH_MAX_CHUNK			16384
+#define _BENCH_RECORD				64
+// the region holds the raw data, when nothing compresses
+#define _BENCH_LZ_SECTOR			256
+#define _BENCH_LZ_SECTORS			512
+#define _BENCH_RAW_SECTOR			1024
+#define _BENCH_INDEX_SIZE			32
+
+typedef enum{
+	_BENCH_CSV,
+	_BENCH_RANDOM,
+	_BENCH_KINDS
+}bench_kind_e;
+
+static const char *KindNames[] = {"csv", "random"};
+
+static uint8_t Memory[_BENCH_SIZE];
+static uint8_t Data[_BENCH_MAX_DATA + 128];
+static uint8_t Back[_BENCH_MAX_DATA];
+static uint8_t RawBuffer[_BENCH_MAX_CHUNK];
+static uint8_t ReadBuffer[_BENCH_MAX_CHUNK];
+static uint8_t CompBuffer[NOR_LZ_COMP_BUFFER_SIZE(_BENCH_MAX_CHUNK)];
+static nor_lz_index_t Index[_BENCH_INDEX_SIZE];
+static uint32_t Bytes = 1000000, ChunkSize = 4096;
+static nor_t Nor;
+static nor_sim_t Sim;
+static nor_lz_t Lz;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-n bytes] [-c chunk] [-x seed]\n", name);
+}
+
+static double _bench_now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+static void _bench_data(bench_kind_e Kind){
+	int Temp = 2150, Hum = 480, Press = 10130;
+	uint32_t Time = 1700000000, n = 0;
+
+	if (Kind == _BENCH_RANDOM){
+		for (n=0 ; n<Bytes ; n++){
+			Data[n] = (uint8_t)rand();
+		}
+		return;
+	}
+	while (n < Bytes){
+		Temp += (rand() % 3) - 1;
+		Hum += (rand() % 3) - 1;
+		if ((rand() % 9) == 0){
+			Press += (rand() % 3) - 1;
+		}
+		n += (uint32_t)sprintf((char*)&Data[n], "%u,temp=%d.%02d,hum=%d.%d,press=%d,ok\n", (unsigned)Time++,
+				Temp / 100, Temp % 100, Hum / 10, Hum % 10, Press);
+	}
+}
+
+static nor_err_e _bench_setup(void){
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _BENCH_JEDEC_ID);
+	memset(&Nor, 0, sizeof(Nor));
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		return NOR_FAIL;
+	}
+	memset(&Lz, 0, sizeof(Lz));
+	Lz.nor = &Nor;
+	Lz.config.u32FirstSector = _BENCH_LZ_SECTOR;
+	Lz.config.u32SectorCount = _BENCH_LZ_SECTORS;
+	Lz.config.u16ChunkSize = (uint16_t)ChunkSize;
+	Lz.config.pRawBuffer = RawBuffer;
+	Lz.config.pReadBuffer = ReadBuffer;
+	Lz.config.pCompBuffer = CompBuffer;
+	Lz.config.pIndex = Index;
+	Lz.config.u16IndexSize = _BENCH_INDEX_SIZE;
+	if (NOR_LZ_Init(&Lz) != NOR_OK || NOR_LZ_Format(&Lz) != NOR_OK){
+		return NOR_FAIL;
+	}
+
+	return NOR_OK;
+}
+
+static int _bench_run(bench_kind_e Kind){
+	uint64_t Start, LzUs, RawUs;
+	uint32_t Programs, LzPrograms, RawPrograms, Sector, i, n;
+	double Seconds, AppendSeconds, ReadSeconds;
+
+	_bench_data(Kind);
+	if (_bench_setup() != NOR_OK){
+		fprintf(stderr, "failed to initialize the region\n");
+		return -1;
+	}
+	Programs = Sim.stats.u32PagePrograms;
+	Start = NOR_SIM_GetTimeUs(&Sim);
+	Seconds = _bench_now();
+	for (i=0 ; i<Bytes ; i+=_BENCH_RECORD){
+		n = ((Bytes - i) > _BENCH_RECORD) ? _BENCH_RECORD : (Bytes - i);
+		if (NOR_LZ_Append(&Lz, &Data[i], n) != NOR_OK){
+			fprintf(stderr, "failed to append\n");
+			return -1;
+		}
+	}
+	if (NOR_LZ_Flush(&Lz) != NOR_OK){
+		fprintf(stderr, "failed to flush\n");
+		return -1;
+	}
+	AppendSeconds = _bench_now() - Seconds;
+	LzUs = NOR_SIM_GetTimeUs(&Sim) - Start;
+	LzPrograms = Sim.stats.u32PagePrograms - Programs;
+
+	Seconds = _bench_now();
+	if (NOR_LZ_Read(&Lz, 0, Back, Bytes) != NOR_OK || memcmp(Back, Data, Bytes) != 0){
+		fprintf(stderr, "the data read back differs\n");
+		return -1;
+	}
+	ReadSeconds = _bench_now() - Seconds;
+
+	for (Sector=0 ; Sector<((Bytes + NOR_SECTOR_SIZE - 1) / NOR_SECTOR_SIZE) ; Sector++){
+		if (NOR_EraseSector(&Nor, _BENCH_RAW_SECTOR + Sector) != NOR_OK){
+			fprintf(stderr, "failed to erase\n");
+			return -1;
+		}
+	}
+	Programs = Sim.stats.u32PagePrograms;
+	Start = NOR_SIM_GetTimeUs(&Sim);
+	for (i=0 ; i<Bytes ; i+=NOR_SECTOR_SIZE){
+		n = ((Bytes - i) > NOR_SECTOR_SIZE) ? NOR_SECTOR_SIZE : (Bytes - i);
+		if (NOR_WriteBytes(&Nor, &Data[i], (_BENCH_RAW_SECTOR * NOR_SECTOR_SIZE) + i, n) != NOR_OK){
+			fprintf(stderr, "failed to write\n");
+			return -1;
+		}
+	}
+	RawUs = NOR_SIM_GetTimeUs(&Sim) - Start;
+	RawPrograms = Sim.stats.u32PagePrograms - Programs;
+
+	printf("== %s, %u bytes in chunks of %u ==\n", KindNames[Kind], (unsigned)Bytes, (unsigned)ChunkSize);
+	printf(" Ratio          | %.2f (%u chunks, %u stored raw)\n",
+			(double)Lz.stats.u32RawBytes / Lz.stats.u32StoredBytes, (unsigned)Lz.stats.u32Chunks,
+			(unsigned)Lz.stats.u32RawChunks);
+	printf(" Page programs  | %u, raw %u\n", (unsigned)LzPrograms, (unsigned)RawPrograms);
+	printf(" Sectors        | %u, raw %u\n", (unsigned)((Lz.stats.u32StoredBytes + NOR_SECTOR_SIZE - 1) / NOR_SECTOR_SIZE),
+			(unsigned)((Bytes + NOR_SECTOR_SIZE - 1) / NOR_SECTOR_SIZE));
+	printf(" Program time   | %.2f s, raw %.2f s\n", (double)LzUs / 1e6, (double)RawUs / 1e6);
+	printf(" Append on host | %.1f MB/s\n", (AppendSeconds > 0) ? ((double)Bytes / 1e6 / AppendSeconds) : 0.0);
+	printf(" Read on host   | %.1f MB/s\n", (ReadSeconds > 0) ? ((double)Bytes / 1e6 / ReadSeconds) : 0.0);
+
+	return 0;
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	uint32_t Seed = 1, i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:c:x:")) != -1){
+		switch (opt){
+		case 'n':
+			Bytes = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			ChunkSize = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			Seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (Bytes == 0 || Bytes > _BENCH_MAX_DATA || ChunkSize < _BENCH_RECORD || ChunkSize > _BENCH_MAX_CHUNK){
+		fprintf(stderr, "bytes must be up to %u, and the chunk from %u to %u\n", _BENCH_MAX_DATA,
+				_BENCH_RECORD, _BENCH_MAX_CHUNK);
+		return 1;
+	}
+	for (i=0 ; i<_BENCH_KINDS ; i++){
+		srand(Seed);
+		if (_bench_run((bench_kind_e)i) != 0){
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,250 @@
+/*
+ * nor_multi_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host benchmark of many nor_t instances driven from pthreads, each one
+ *  with its own simulated device of 1 MB, through the same operations
+ *  table. The instances are split over 1, 2, 4, ... threads, and each one
+ *  runs rounds of a sector erase and 16 page programs, each program read
+ *  back and compared. At the end, the last page written on every instance
+ *  is checked, to catch an instance touching the device of another.
+ *
+ *  Two tables are measured: NOR_SIM_Ops, and NOR_SIM_Ops with a pthread
+ *  mutex per instance as Lock/Unlock, and WaitReady and TimeUs.
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_multi_bench tools/nor_multi_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c -lpthread
+ *
+ *  Usage:
+ *    nor_multi_bench [-i instances] [-t threads] [-r rounds]
+ *
+ *    -i  instances, 256 if not provided
+ *    -t  largest number of threads, 16 if not provided
+ *    -r  rounds of each instance, 8 if not provided
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1440EF	// W25Q80
+#define _BENCH_SIZE					(1024 * 1024)
+#define _BENCH_SECTORS				(_BENCH_SIZE / NOR_SECTOR_SIZE)
+#define _BENCH_PAGES				(NOR_SECTOR_SIZE / NOR_PAGE_SIZE)
+#define _BENCH_THREADS_MAX			64
+
+// the nor_sim_t goes first, so the context of the operations is the instance
+typedef struct{
+	nor_sim_t Sim;
+	nor_t Nor;
+	uint8_t *pMem;
+	pthread_mutex_t Mutex;
+	uint32_t u32Ops;
+	uint32_t u32Fails;
+}bench_inst_t;
+
+typedef struct{
+	pthread_t Thread;
+	uint32_t u32First;
+}bench_thread_t;
+
+static bench_inst_t *Instances;
+static bench_thread_t Threads[_BENCH_THREADS_MAX];
+static nor_ops_t LockOps;
+static uint32_t NumInstances = 256, NumThreads, Rounds = 8;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-i instances] [-t threads] [-r rounds]\n", name);
+}
+
+static void _bench_lock(void *Ctx, nor_lock_e Mode){
+	(void)Mode;
+	pthread_mutex_lock(&((bench_inst_t*)Ctx)->Mutex);
+}
+
+static void _bench_unlock(void *Ctx, nor_lock_e Mode){
+	(void)Mode;
+	pthread_mutex_unlock(&((bench_inst_t*)Ctx)->Mutex);
+}
+
+static double _bench_now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+static uint32_t _bench_sector(uint32_t Inst, uint32_t Round){
+	return ((Round * 7) + Inst) % _BENCH_SECTORS;
+}
+
+static void _bench_pattern(uint8_t *pBuffer, uint32_t Inst, uint32_t Round, uint32_t Page){
+	uint32_t i;
+
+	for (i=0 ; i<NOR_PAGE_SIZE ; i++){
+		pBuffer[i] = (uint8_t)((Inst * 31) + (Round * 17) + (Page * 5) + i);
+	}
+}
+
+static void* _bench_worker(void *arg){
+	bench_thread_t *t = (bench_thread_t*)arg;
+	bench_inst_t *x;
+	uint8_t Write[NOR_PAGE_SIZE], Read[NOR_PAGE_SIZE];
+	uint32_t i, k, p, Address;
+
+	for (i=t->u32First ; i<NumInstances ; i+=NumThreads){
+		x = &Instances[i];
+		for (k=0 ; k<Rounds ; k++){
+			Address = _bench_sector(i, k) * NOR_SECTOR_SIZE;
+			if (NOR_EraseSector(&x->Nor, _bench_sector(i, k)) != NOR_OK){
+				x->u32Fails++;
+			}
+			x->u32Ops++;
+			for (p=0 ; p<_BENCH_PAGES ; p++){
+				_bench_pattern(Write, i, k, p);
+				if (NOR_WriteBytes(&x->Nor, Write, Address + (p * NOR_PAGE_SIZE), NOR_PAGE_SIZE) != NOR_OK){
+					x->u32Fails++;
+				}
+				if (NOR_ReadBytes(&x->Nor, Read, Address + (p * NOR_PAGE_SIZE), NOR_PAGE_SIZE) != NOR_OK ||
+						memcmp(Write, Read, NOR_PAGE_SIZE) != 0){
+					x->u32Fails++;
+				}
+				x->u32Ops += 2;
+			}
+		}
+	}
+	return NULL;
+}
+
+static int _bench_setup(const nor_ops_t *pOps){
+	bench_inst_t *x;
+	uint32_t i;
+
+	for (i=0 ; i<NumInstances ; i++){
+		x = &Instances[i];
+		NOR_SIM_Init(&x->Sim, x->pMem, _BENCH_SIZE, _BENCH_JEDEC_ID);
+		memset(&x->Nor, 0, sizeof(x->Nor));
+		x->Nor.config.pOps = pOps;
+		x->Nor.config.pOpsCtx = x;
+		x->u32Ops = 0;
+		x->u32Fails = 0;
+		if (NOR_Init(&x->Nor) != NOR_OK){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int _bench_run(const char *Name, const nor_ops_t *pOps, uint32_t Count){
+	uint8_t Read[NOR_PAGE_SIZE], Write[NOR_PAGE_SIZE];
+	uint64_t Ops = 0;
+	uint32_t i, Fails = 0;
+	double Start, Seconds;
+
+	if (_bench_setup(pOps) != 0){
+		return -1;
+	}
+	NumThreads = Count;
+	Start = _bench_now();
+	for (i=0 ; i<NumThreads ; i++){
+		Threads[i].u32First = i;
+		pthread_create(&Threads[i].Thread, NULL, _bench_worker, &Threads[i]);
+	}
+	for (i=0 ; i<NumThreads ; i++){
+		pthread_join(Threads[i].Thread, NULL);
+	}
+	Seconds = _bench_now() - Start;
+	for (i=0 ; i<NumInstances ; i++){
+		Ops += Instances[i].u32Ops;
+		Fails += Instances[i].u32Fails;
+		// the last page written must be the one of this instance
+		_bench_pattern(Write, i, Rounds - 1, _BENCH_PAGES - 1);
+		if (NOR_ReadBytes(&Instances[i].Nor, Read, (_bench_sector(i, Rounds - 1) * NOR_SECTOR_SIZE) +
+				((_BENCH_PAGES - 1) * NOR_PAGE_SIZE), NOR_PAGE_SIZE) != NOR_OK || memcmp(Write, Read, NOR_PAGE_SIZE) != 0){
+			Fails++;
+		}
+	}
+	printf(" %-5s | %7u | %8llu | %7.3f | %9.0f | %u\n", Name, (unsigned)NumThreads, (unsigned long long)Ops,
+			Seconds, (Seconds > 0) ? ((double)Ops / Seconds) : 0.0, (unsigned)Fails);
+
+	return 0;
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	uint32_t MaxThreads = 16, i, n;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:t:r:")) != -1){
+		switch (opt){
+		case 'i':
+			NumInstances = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			MaxThreads = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			Rounds = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (NumInstances == 0 || Rounds == 0 || MaxThreads == 0 || MaxThreads > _BENCH_THREADS_MAX){
+		fprintf(stderr, "invalid instances, threads or rounds\n");
+		return 1;
+	}
+	Instances = calloc(NumInstances, sizeof(bench_inst_t));
+	if (Instances == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i=0 ; i<NumInstances ; i++){
+		Instances[i].pMem = malloc(_BENCH_SIZE);
+		if (Instances[i].pMem == NULL){
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		pthread_mutex_init(&Instances[i].Mutex, NULL);
+	}
+	LockOps = NOR_SIM_Ops;
+	LockOps.Lock = _bench_lock;
+	LockOps.Unlock = _bench_unlock;
+	LockOps.WaitReady = NOR_SIM_WaitReady;
+	LockOps.TimeUs = NOR_SIM_TimeUs;
+
+	printf("== %u instances of %u KB, %u rounds each ==\n", (unsigned)NumInstances, _BENCH_SIZE / 1024, (unsigned)Rounds);
+	printf(" table | threads | ops      | seconds | ops/s     | fails\n");
+	for (n=1 ; n<=MaxThreads ; n*=2){
+		if (_bench_run("sim", &NOR_SIM_Ops, n) != 0){
+			fprintf(stderr, "failed to initialize the driver\n");
+			return 1;
+		}
+	}
+	for (n=1 ; n<=MaxThreads ; n*=2){
+		if (_bench_run("lock", &LockOps, n) != 0){
+			fprintf(stderr, "failed to initialize the driver\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * nor_replay.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host tool to replay a SPI trace, recorded with NOR_TRACE on the target,
+ *  through the driver and the simulated device. The driver calls are rebuilt
+ *  from the data transactions (reads, programs and erases), while the control
+ *  transactions (status polls, write enables, IDs) are left to the driver, so
+ *  the report shows how the current driver performs on the recorded workload.
+ *
+ *  Build, from the repository root:
+ *    gcc -DNOR_TRACE -I. -Itools -o nor_replay tools/nor_replay.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c
+ *
+ *  Usage:
+ *    nor_replay [-i initial.bin] [-d data.bin] [-o replayed.bin] trace.bin
+ *
+ *    -i  initial content of the device, erased if not provided
+ *    -d  image where the programmed data is taken from, zeros if not provided
+ *    -o  dump the trace of the replay, to compare with the original
+ *
+ *  The trace file is the sequence of nor_trace_rec_t, little endian.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _REPLAY_JEDEC_ID			0x1740EF	// W25Q64
+#define _REPLAY_SIZE				(8 * 1024 * 1024)
+#define _REPLAY_RING_LEN			4096
+#define _REPLAY_MAX_PROGRAM			NOR_BLOCK_SIZE
+
+typedef struct{
+	uint32_t u32Transactions;
+	uint32_t u32BusyUs;
+	uint32_t u32SpanUs;
+	uint32_t u32Reads;
+	uint32_t u32ReadBytes;
+	uint32_t u32Programs;
+	uint32_t u32ProgramBytes;
+	uint32_t u32Erases;
+	uint32_t u32PowerDowns;
+}replay_stats_t;
+
+static uint8_t Memory[_REPLAY_SIZE];
+static uint8_t DataImage[_REPLAY_SIZE];
+static uint8_t Buffer[_REPLAY_MAX_PROGRAM];
+static uint8_t ReadBuffer[_REPLAY_SIZE];
+static nor_t Nor;
+static nor_sim_t Sim;
+static FILE *TraceOut;
+#if defined (NOR_TRACE)
+static nor_trace_rec_t Ring[_REPLAY_RING_LEN];
+#endif
+
+/* Functions */
+
+#if defined (NOR_TRACE)
+static uint32_t _replay_time(void){
+	return (uint32_t)NOR_SIM_GetTimeUs(&Sim);
+}
+#endif
+
+static void _replay_dump(void){
+#if defined (NOR_TRACE)
+	nor_trace_rec_t Records[256];
+	uint32_t n;
+
+	if (TraceOut == NULL){
+		return;
+	}
+	while ((n = NOR_TRACE_Read(&Nor, Records, 256)) > 0){
+		fwrite(Records, sizeof(nor_trace_rec_t), n, TraceOut);
+	}
+#endif
+}
+
+static void _replay_program(uint32_t Address, uint32_t Len){
+	memcpy(Buffer, &DataImage[Address], Len);
+	if (NOR_WriteBytes(&Nor, Buffer, Address, Len) != NOR_OK){
+		fprintf(stderr, "program of %u bytes on 0x%06X failed\n", (unsigned)Len, (unsigned)Address);
+	}
+	_replay_dump();
+}
+
+static int _replay_file(FILE *fp, replay_stats_t *pStats){
+	nor_trace_rec_t rec;
+	uint32_t ProgAddr = 0, ProgLen = 0, Address, Len, First = 0, Last = 0;
+	uint8_t Opcode;
+
+	memset(pStats, 0, sizeof(*pStats));
+	while (fread(&rec, sizeof(rec), 1, fp) == 1){
+		if (pStats->u32Transactions == 0){
+			First = rec.u32Timestamp;
+		}
+		Last = rec.u32Timestamp;
+		pStats->u32Transactions++;
+		pStats->u32BusyUs += rec.u32BusyUs;
+		Opcode = rec.u32OpAddr >> 24;
+		Address = rec.u32OpAddr & 0xFFFFFF;
+		Len = rec.u32Len;
+		if (Address >= _REPLAY_SIZE){
+			continue;
+		}
+		if (Opcode == NOR_PAGE_PROGRAM){
+			pStats->u32Programs++;
+			pStats->u32ProgramBytes += Len;
+			if (Len > NOR_PAGE_SIZE){
+				Len = NOR_PAGE_SIZE;
+			}
+			// sequential pages came from the same NOR_WriteBytes call
+			if (ProgLen > 0 && (ProgAddr + ProgLen) == Address && (ProgLen + Len) <= _REPLAY_MAX_PROGRAM){
+				ProgLen += Len;
+				continue;
+			}
+			if (ProgLen > 0){
+				_replay_program(ProgAddr, ProgLen);
+			}
+			ProgAddr = Address;
+			ProgLen = Len;
+			continue;
+		}
+		// the driver polls and enables the write by itself
+		if (Opcode != NOR_READ_DATA && Opcode != NOR_READ_FAST_DATA && Opcode != NOR_SECTOR_ERASE_4K &&
+				Opcode != NOR_SECTOR_ERASE_32K && Opcode != NOR_SECTOR_ERASE_64K && Opcode != NOR_CHIP_ERASE &&
+				Opcode != NOR_ENTER_PD && Opcode != NOR_RELEASE_PD){
+			continue;
+		}
+		if (ProgLen > 0){
+			_replay_program(ProgAddr, ProgLen);
+			ProgLen = 0;
+		}
+		switch (Opcode){
+		case NOR_READ_FAST_DATA:
+			// the dummy byte
+			Len = (Len > 0) ? (Len - 1) : 0;
+			// fall through
+		case NOR_READ_DATA:
+			if (Len == 0){
+				break;
+			}
+			if ((Address + Len) > _REPLAY_SIZE){
+				Len = _REPLAY_SIZE - Address;
+			}
+			pStats->u32Reads++;
+			pStats->u32ReadBytes += Len;
+			NOR_ReadBytes(&Nor, ReadBuffer, Address, Len);
+			break;
+		case NOR_SECTOR_ERASE_4K:
+			pStats->u32Erases++;
+			NOR_EraseAddress(&Nor, Address, NOR_ERASE_4K);
+			break;
+		case NOR_SECTOR_ERASE_32K:
+			pStats->u32Erases++;
+			NOR_EraseAddress(&Nor, Address, NOR_ERASE_32K);
+			break;
+		case NOR_SECTOR_ERASE_64K:
+			pStats->u32Erases++;
+			NOR_EraseAddress(&Nor, Address, NOR_ERASE_64K);
+			break;
+		case NOR_CHIP_ERASE:
+			pStats->u32Erases++;
+			NOR_EraseChip(&Nor);
+			break;
+		case NOR_ENTER_PD:
+			pStats->u32PowerDowns++;
+			NOR_EnterPowerDown(&Nor);
+			break;
+		case NOR_RELEASE_PD:
+			NOR_ExitPowerDown(&Nor);
+			break;
+		}
+		_replay_dump();
+	}
+	if (ProgLen > 0){
+		_replay_program(ProgAddr, ProgLen);
+	}
+	NOR_Sync(&Nor);
+	_replay_dump();
+	pStats->u32SpanUs = Last - First;
+
+	return 0;
+}
+
+static void _replay_usage(const char *name){
+	fprintf(stderr, "usage: %s [-i initial.bin] [-d data.bin] [-o replayed.bin] trace.bin\n", name);
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	const char *Initial = NULL, *Data = NULL, *Output = NULL;
+	replay_stats_t stats;
+	uint64_t Start;
+	FILE *fp;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:d:o:")) != -1){
+		switch (opt){
+		case 'i':
+			Initial = optarg;
+			break;
+		case 'd':
+			Data = optarg;
+			break;
+		case 'o':
+			Output = optarg;
+			break;
+		default:
+			_replay_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc){
+		_replay_usage(argv[0]);
+		return 1;
+	}
+	fp = fopen(argv[optind], "rb");
+	if (fp == NULL){
+		fprintf(stderr, "can't open %s\n", argv[optind]);
+		return 1;
+	}
+	if (Data != NULL){
+		FILE *fd = fopen(Data, "rb");
+		if (fd == NULL){
+			fprintf(stderr, "can't open %s\n", Data);
+			return 1;
+		}
+		fread(DataImage, 1, sizeof(DataImage), fd);
+		fclose(fd);
+	}
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _REPLAY_JEDEC_ID);
+	if (Initial != NULL && NOR_SIM_LoadFile(&Sim, Initial) != 0){
+		fprintf(stderr, "can't open %s\n", Initial);
+		return 1;
+	}
+	Nor.config.pOps = &NOR_SIM_Ops;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		fprintf(stderr, "failed to initialize the driver\n");
+		return 1;
+	}
+	if (Output != NULL){
+#if defined (NOR_TRACE)
+		TraceOut = fopen(Output, "wb");
+		if (TraceOut == NULL){
+			fprintf(stderr, "can't create %s\n", Output);
+			return 1;
+		}
+		NOR_TRACE_Start(&Nor, Ring, _REPLAY_RING_LEN, _replay_time);
+#else
+		fprintf(stderr, "-o needs the tool built with NOR_TRACE\n");
+		return 1;
+#endif
+	}
+	memset(&Sim.stats, 0, sizeof(Sim.stats));
+	Start = NOR_SIM_GetTimeUs(&Sim);
+	_replay_file(fp, &stats);
+	fclose(fp);
+	if (TraceOut != NULL){
+		fclose(TraceOut);
+	}
+
+	printf("== Recorded trace ==\n");
+	printf(" Transactions  | %u\n", (unsigned)stats.u32Transactions);
+	printf(" Span          | %u us\n", (unsigned)stats.u32SpanUs);
+	printf(" Busy waits    | %u us\n", (unsigned)stats.u32BusyUs);
+	printf(" Reads         | %u (%u bytes)\n", (unsigned)stats.u32Reads, (unsigned)stats.u32ReadBytes);
+	printf(" Page programs | %u (%u bytes)\n", (unsigned)stats.u32Programs, (unsigned)stats.u32ProgramBytes);
+	printf(" Erases        | %u\n", (unsigned)stats.u32Erases);
+	printf(" Power downs   | %u\n", (unsigned)stats.u32PowerDowns);
+	printf("== Replay ==\n");
+	printf(" Transactions  | %u\n", (unsigned)Sim.stats.u32Transactions);
+	printf(" Time          | %llu us\n", (unsigned long long)(NOR_SIM_GetTimeUs(&Sim) - Start));
+	printf(" Bytes Tx/Rx   | %u / %u\n", (unsigned)Sim.stats.u32BytesTx, (unsigned)Sim.stats.u32BytesRx);
+	printf(" Status polls  | %u\n", (unsigned)Sim.stats.u32StatusPolls);
+	printf(" Page programs | %u\n", (unsigned)Sim.stats.u32PagePrograms);
+	printf(" Erases        | %u\n", (unsigned)Sim.stats.u32Erases);
+	printf(" Ignored cmds  | %u\n", (unsigned)Sim.stats.u32IgnoredCmds);
+
+	return 0;
+}
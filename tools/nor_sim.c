@@ -0,0 +1,550 @@
+/*
+ * nor_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nor_defines.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+static uint8_t _sim_is_busy(nor_sim_t *sim){
+	return (sim->_internal.u64TimeNs < sim->_internal.u64BusyUntilNs);
+}
+
+static void _sim_set_busy(nor_sim_t *sim, uint32_t us){
+	sim->_internal.u64BusyUntilNs = sim->_internal.u64TimeNs + ((uint64_t)us * 1000);
+	sim->_internal.u8Sr[0] &= ~SR1_WEL_BIT;
+	sim->_internal.u8Erasing = 0;
+	sim->_internal.u32TearSize = 0;
+}
+
+// keeps the content before a program or erase, restored in part by a power cut
+static void _sim_save_tear(nor_sim_t *sim, uint32_t Address, uint32_t Size){
+	sim->_internal.u32TearAddr = Address;
+	if (Size <= NOR_SIM_TEAR_MAX && (Address + Size) <= sim->u32Size){
+		memcpy(sim->_internal.u8Tear, &sim->pMem[Address], Size);
+	}
+}
+
+static void _sim_tear(nor_sim_t *sim, uint32_t Size){
+	if (Size <= NOR_SIM_TEAR_MAX && (sim->_internal.u32TearAddr + Size) <= sim->u32Size){
+		sim->_internal.u32TearSize = Size;
+	}
+}
+
+static void _sim_power_off(nor_sim_t *sim){
+	uint32_t Half = sim->_internal.u32TearSize / 2;
+
+	if (_sim_is_busy(sim) && Half > 0){
+		memcpy(&sim->pMem[sim->_internal.u32TearAddr + Half], &sim->_internal.u8Tear[Half], Half);
+	}
+	sim->_internal.u8PowerOff = 1;
+	sim->_internal.u8Selected = 0;
+	sim->_internal.u64BusyUntilNs = 0;
+	sim->_internal.u32TearSize = 0;
+	sim->stats.u32PowerCuts++;
+}
+
+// failures injected on the sectors of a range
+static uint8_t _sim_fail_mode(nor_sim_t *sim, uint32_t Address, uint32_t Size){
+	uint8_t Mode = 0;
+	uint32_t i, Start;
+
+	for (i=0 ; i<NOR_SIM_FAIL_MAX ; i++){
+		Start = sim->_internal.u32FailSector[i] * NOR_SECTOR_SIZE;
+		if (sim->_internal.u8FailMode[i] != 0 && Start < (Address + Size) && Address < (Start + NOR_SECTOR_SIZE)){
+			Mode |= sim->_internal.u8FailMode[i];
+		}
+	}
+	return Mode;
+}
+
+static uint32_t _sim_fail_time(uint8_t Mode, uint32_t us){
+	return (Mode & NOR_SIM_FAIL_SLOW) ? (us * 4) : us;
+}
+
+static uint8_t _sim_is_mxic(nor_sim_t *sim){
+	return ((sim->u32JedecID & 0xFF) == 0xC2);
+}
+
+static uint8_t _sim_hdr_len(nor_sim_t *sim, uint8_t cmd){
+	switch (cmd){
+	case NOR_READ_DATA:
+	case NOR_PAGE_PROGRAM:
+	case NOR_SECTOR_ERASE_4K:
+	case NOR_SECTOR_ERASE_32K:
+	case NOR_SECTOR_ERASE_64K:
+	case NOR_DEVICE_ID:
+		return 4;
+	case NOR_READ_FAST_DATA:
+		if (sim->_internal.u8Qpi){
+			// dummy clocks of the default read parameters, 2 per byte
+			return 4 + (_sim_is_mxic(sim) ? (NOR_QPI_DUMMY_MXIC / 2) : (NOR_QPI_DUMMY_WINBOND / 2));
+		}
+		return 5;
+	case NOR_UNIQUE_ID:
+	case NOR_READ_SFDP_REG:
+		return 5;
+	case NOR_WRITE_SR1:
+	case NOR_WRITE_SR2:
+	case NOR_WRITE_SR3:
+		return 2;
+	default:
+		return 1;
+	}
+}
+
+static uint8_t _sim_cmd_allowed(nor_sim_t *sim, uint8_t cmd){
+	if (sim->_internal.u8Lines != (sim->_internal.u8Qpi ? 4 : 1)){
+		// the transport doesn't match the mode, the opcode is garbled
+		return 0;
+	}
+	if (sim->_internal.u8PowerDown){
+		return (cmd == NOR_RELEASE_PD);
+	}
+	if (sim->_internal.u8Qpi && (cmd == NOR_READ_DATA || cmd == NOR_UNIQUE_ID || cmd == NOR_READ_SFDP_REG)){
+		return 0;
+	}
+	if (_sim_is_busy(sim)){
+		return (cmd == NOR_READ_SR1 || (cmd == NOR_ER_PROG_SUSPEND && sim->_internal.u8Erasing));
+	}
+	return 1;
+}
+
+// erases the sectors of a range, except the failing ones
+static void _sim_erase_range(nor_sim_t *sim, uint32_t Address, uint32_t Size){
+	uint32_t i;
+
+	sim->_internal.u8Scur &= ~(SCUR_PFAIL_BIT | SCUR_EFAIL_BIT);
+	for (i=Address ; i<(Address + Size) && i<sim->u32Size ; i+=NOR_SECTOR_SIZE){
+		if (_sim_fail_mode(sim, i, NOR_SECTOR_SIZE) & NOR_SIM_FAIL_ERASE){
+			sim->_internal.u8Scur |= SCUR_EFAIL_BIT;
+			sim->stats.u32InjectedFails++;
+			continue;
+		}
+		memset(&sim->pMem[i], 0xFF, NOR_SECTOR_SIZE);
+	}
+	sim->stats.u32Erases++;
+}
+
+static void _sim_erase(nor_sim_t *sim, uint32_t Address, uint32_t Size, uint32_t us){
+	Address &= ~(Size - 1);
+	_sim_save_tear(sim, Address, Size);
+	_sim_erase_range(sim, Address, Size);
+	_sim_set_busy(sim, _sim_fail_time(_sim_fail_mode(sim, Address, Size), us));
+	_sim_tear(sim, Size);
+	sim->_internal.u8Erasing = 1;
+	sim->_internal.u32EraseAddr = Address;
+	sim->_internal.u32EraseSize = Size;
+}
+
+static void _sim_execute(nor_sim_t *sim){
+	uint8_t cmd = sim->_internal.u8Hdr[0];
+	uint8_t wel = (sim->_internal.u8Sr[0] & SR1_WEL_BIT);
+	uint8_t mode;
+	uint32_t i, base, off;
+
+	if (sim->_internal.u8HdrLen < sim->_internal.u8HdrNeed){
+		// truncated command, the device ignores it
+		return;
+	}
+	switch (cmd){
+	case NOR_CMD_WRITE_EN:
+		sim->_internal.u8Sr[0] |= SR1_WEL_BIT;
+		break;
+	case NOR_CMD_WRITE_DIS:
+		sim->_internal.u8Sr[0] &= ~SR1_WEL_BIT;
+		break;
+	case NOR_ENTER_PD:
+		sim->_internal.u8PowerDown = 1;
+		break;
+	case NOR_ENTER_QPI_WINBOND:
+		if (!_sim_is_mxic(sim) && (sim->_internal.u8Sr[1] & SR2_QE_BIT)){
+			sim->_internal.u8Qpi = 1;
+		}
+		break;
+	case NOR_ENTER_QPI_MXIC:
+		// Read SR2 on the other manufacturers
+		if (_sim_is_mxic(sim)){
+			sim->_internal.u8Qpi = 1;
+		}
+		break;
+	case NOR_EXIT_QPI_WINBOND:
+		if (!_sim_is_mxic(sim)){
+			sim->_internal.u8Qpi = 0;
+		}
+		break;
+	case NOR_EXIT_QPI_MXIC:
+		if (_sim_is_mxic(sim)){
+			sim->_internal.u8Qpi = 0;
+		}
+		break;
+	case NOR_RELEASE_PD:
+		sim->_internal.u8PowerDown = 0;
+		break;
+	case NOR_PAGE_PROGRAM:
+		if (!wel){
+			break;
+		}
+		base = sim->_internal.u32Addr & ~(NOR_PAGE_SIZE - 1);
+		off = sim->_internal.u32Addr & (NOR_PAGE_SIZE - 1);
+		// the range of the erase suspended can't be programmed
+		if (sim->_internal.u8Suspended && base >= sim->_internal.u32EraseAddr &&
+				base < (sim->_internal.u32EraseAddr + sim->_internal.u32EraseSize)){
+			sim->_internal.u8Sr[0] &= ~SR1_WEL_BIT;
+			sim->stats.u32IgnoredCmds++;
+			break;
+		}
+		mode = _sim_fail_mode(sim, base, NOR_PAGE_SIZE);
+		_sim_save_tear(sim, base, NOR_PAGE_SIZE);
+		// the result of an erase suspended is known only on its completion
+		sim->_internal.u8Scur &= ~(sim->_internal.u8Suspended ? SCUR_PFAIL_BIT : (SCUR_PFAIL_BIT | SCUR_EFAIL_BIT));
+		if (mode & NOR_SIM_FAIL_PROGRAM){
+			sim->_internal.u8Scur |= SCUR_PFAIL_BIT;
+			sim->stats.u32InjectedFails++;
+		}
+		for (i=0 ; i<sim->_internal.u32DataCount && i<NOR_PAGE_SIZE && !(mode & NOR_SIM_FAIL_PROGRAM) ; i++){
+			if (base < sim->u32Size){
+				sim->pMem[base + ((off + i) & (NOR_PAGE_SIZE - 1))] &= sim->_internal.u8Page[i];
+			}
+		}
+		sim->stats.u32PagePrograms++;
+		_sim_set_busy(sim, _sim_fail_time(mode, sim->timing.u32PageProgUs));
+		_sim_tear(sim, NOR_PAGE_SIZE);
+		break;
+	case NOR_SECTOR_ERASE_4K:
+		if (wel){
+			_sim_erase(sim, sim->_internal.u32Addr, NOR_SECTOR_SIZE, sim->timing.u32Erase4KUs);
+		}
+		break;
+	case NOR_SECTOR_ERASE_32K:
+		if (wel){
+			_sim_erase(sim, sim->_internal.u32Addr, NOR_BLOCK_SIZE/2, sim->timing.u32Erase32KUs);
+		}
+		break;
+	case NOR_SECTOR_ERASE_64K:
+		if (wel){
+			_sim_erase(sim, sim->_internal.u32Addr, NOR_BLOCK_SIZE, sim->timing.u32Erase64KUs);
+		}
+		break;
+	case NOR_CHIP_ERASE:
+		if (wel){
+			_sim_erase_range(sim, 0, sim->u32Size);
+			_sim_set_busy(sim, sim->timing.u32EraseChipUs);
+		}
+		break;
+	case NOR_WRITE_SR1:
+	case NOR_WRITE_SR2:
+	case NOR_WRITE_SR3:
+		if (wel){
+			i = (cmd == NOR_WRITE_SR1) ? 0 : (cmd == NOR_WRITE_SR2) ? 1 : 2;
+			sim->_internal.u8Sr[i] = sim->_internal.u8Hdr[1];
+			if (i == 0){
+				sim->_internal.u8Sr[0] &= ~(SR1_BUSY_BIT | SR1_WEL_BIT);
+			}
+			_sim_set_busy(sim, 10);
+		}
+		break;
+	case NOR_ER_PROG_SUSPEND:
+		if (sim->_internal.u8Erasing && _sim_is_busy(sim)){
+			// the memory was already cleared, keep the remaining time of the erase
+			sim->_internal.u64SuspendedNs = sim->_internal.u64BusyUntilNs - sim->_internal.u64TimeNs;
+			sim->_internal.u64BusyUntilNs = sim->_internal.u64TimeNs + ((uint64_t)sim->timing.u32SuspendUs * 1000);
+			sim->_internal.u8Erasing = 0;
+			sim->_internal.u8Suspended = 1;
+			sim->_internal.u8Sr[1] |= SR2_SUS_BIT;
+			sim->stats.u32Suspends++;
+		}
+		break;
+	case NOR_ER_PROG_RESUME:
+		if (sim->_internal.u8Suspended){
+			sim->_internal.u64BusyUntilNs = sim->_internal.u64TimeNs + sim->_internal.u64SuspendedNs;
+			sim->_internal.u8Erasing = 1;
+			sim->_internal.u8Suspended = 0;
+			sim->_internal.u8Sr[1] &= ~SR2_SUS_BIT;
+		}
+		break;
+	case NOR_ENABLE_RESET:
+		sim->_internal.u8ResetEnabled = 1;
+		break;
+	case NOR_DEVICE_RESET:
+		if (sim->_internal.u8ResetEnabled){
+			sim->_internal.u8Sr[0] &= ~SR1_WEL_BIT;
+			sim->_internal.u8Sr[1] &= ~SR2_SUS_BIT;
+			sim->_internal.u8Erasing = 0;
+			sim->_internal.u8Suspended = 0;
+			sim->_internal.u8Qpi = 0;
+			sim->_internal.u64BusyUntilNs = sim->_internal.u64TimeNs + 30000;
+		}
+		break;
+	default:
+		break;
+	}
+	if (cmd != NOR_ENABLE_RESET){
+		sim->_internal.u8ResetEnabled = 0;
+	}
+}
+
+static uint8_t _sim_rx_byte(nor_sim_t *sim){
+	uint8_t cmd = sim->_internal.u8Hdr[0];
+	uint32_t n = sim->_internal.u32DataCount++;
+	uint8_t value = 0xFF;
+
+	if (sim->_internal.u8Ignore){
+		return 0xFF;
+	}
+	switch (cmd){
+	case NOR_READ_SR1:
+		sim->stats.u32StatusPolls++;
+		value = sim->_internal.u8Sr[0] & ~SR1_BUSY_BIT;
+		if (_sim_is_busy(sim)){
+			value |= SR1_BUSY_BIT | SR1_WEL_BIT;
+		}
+		break;
+	case NOR_READ_SR2:
+		value = _sim_is_mxic(sim) ? 0xFF : sim->_internal.u8Sr[1];
+		break;
+	case NOR_READ_SR3:
+		value = sim->_internal.u8Sr[2];
+		break;
+	case NOR_READ_SCUR_MXIC:
+		value = _sim_is_mxic(sim) ? sim->_internal.u8Scur : 0xFF;
+		break;
+	case NOR_JEDEC_ID:
+		value = (n < 3) ? ((sim->u32JedecID >> (8*n)) & 0xFF) : 0xFF;
+		break;
+	case NOR_UNIQUE_ID:
+		value = (n < 8) ? ((sim->u64UniqueId >> (8*n)) & 0xFF) : 0xFF;
+		break;
+	case NOR_READ_DATA:
+	case NOR_READ_FAST_DATA:
+		value = sim->pMem[(sim->_internal.u32Addr + n) % sim->u32Size];
+		break;
+	default:
+		break;
+	}
+	return value;
+}
+
+static void _sim_tx_byte(nor_sim_t *sim, uint8_t b){
+	if (sim->_internal.u8HdrLen == 0){
+		sim->_internal.u8Hdr[0] = b;
+		sim->_internal.u8HdrLen = 1;
+		sim->_internal.u8HdrNeed = _sim_hdr_len(sim, b);
+		sim->_internal.u8Ignore = !_sim_cmd_allowed(sim, b);
+		if (sim->_internal.u8Ignore){
+			sim->stats.u32IgnoredCmds++;
+		}
+	}
+	else if (sim->_internal.u8HdrLen < sim->_internal.u8HdrNeed){
+		sim->_internal.u8Hdr[sim->_internal.u8HdrLen++] = b;
+	}
+	else{
+		// data phase
+		if (sim->_internal.u32DataCount < NOR_PAGE_SIZE){
+			sim->_internal.u8Page[sim->_internal.u32DataCount] = b;
+		}
+		sim->_internal.u32DataCount++;
+		return;
+	}
+	if (sim->_internal.u8HdrLen == sim->_internal.u8HdrNeed && sim->_internal.u8HdrNeed >= 4){
+		sim->_internal.u32Addr = ((uint32_t)sim->_internal.u8Hdr[1] << 16) |
+				((uint32_t)sim->_internal.u8Hdr[2] << 8) | sim->_internal.u8Hdr[3];
+	}
+}
+
+static void _sim_advance(nor_sim_t *sim, uint32_t bytes){
+	sim->_internal.u64TimeNs += ((uint64_t)bytes * sim->timing.u32NsPerByte) / sim->_internal.u8Lines;
+}
+
+/*
+ * Publics
+ */
+
+void NOR_SIM_Init(nor_sim_t *sim, uint8_t *pMem, uint32_t Size, uint32_t JedecID){
+	memset(sim, 0, sizeof(*sim));
+	sim->pMem = pMem;
+	sim->u32Size = Size;
+	sim->u32JedecID = JedecID;
+	sim->u64UniqueId = 0x0123456789ABCDEFULL;
+	memset(pMem, 0xFF, Size);
+	// 40 MHz SPI clock and typical datasheet times
+	sim->timing.u32NsPerByte = 200;
+	sim->timing.u32PageProgUs = 700;
+	sim->timing.u32Erase4KUs = 45000;
+	sim->timing.u32Erase32KUs = 120000;
+	sim->timing.u32Erase64KUs = 150000;
+	sim->timing.u32EraseChipUs = (Size / NOR_BLOCK_SIZE) * 100000;
+	sim->timing.u32SuspendUs = 20;
+	sim->_internal.u8Lines = 1;
+}
+
+int NOR_SIM_LoadFile(nor_sim_t *sim, const char *path){
+	FILE *fp = fopen(path, "rb");
+	size_t len;
+
+	if (fp == NULL){
+		return -1;
+	}
+	len = fread(sim->pMem, 1, sim->u32Size, fp);
+	fclose(fp);
+	if (len < sim->u32Size){
+		memset(&sim->pMem[len], 0xFF, sim->u32Size - len);
+	}
+	return 0;
+}
+
+int NOR_SIM_SaveFile(nor_sim_t *sim, const char *path){
+	FILE *fp = fopen(path, "wb");
+	size_t len;
+
+	if (fp == NULL){
+		return -1;
+	}
+	len = fwrite(sim->pMem, 1, sim->u32Size, fp);
+	fclose(fp);
+	return (len == sim->u32Size) ? 0 : -1;
+}
+
+void NOR_SIM_SchedulePowerCut(nor_sim_t *sim, uint32_t Transactions){
+	sim->_internal.u32CutCountdown = Transactions;
+}
+
+void NOR_SIM_PowerOn(nor_sim_t *sim){
+	sim->_internal.u8PowerOff = 0;
+	sim->_internal.u32CutCountdown = 0;
+	sim->_internal.u8Sr[0] &= ~SR1_WEL_BIT;
+	sim->_internal.u8Sr[1] &= ~SR2_SUS_BIT;
+	sim->_internal.u8Erasing = 0;
+	sim->_internal.u8Suspended = 0;
+	sim->_internal.u8PowerDown = 0;
+	sim->_internal.u8ResetEnabled = 0;
+	sim->_internal.u8Qpi = 0;
+	sim->_internal.u8Scur &= ~(SCUR_PFAIL_BIT | SCUR_EFAIL_BIT);
+	sim->_internal.u64BusyUntilNs = 0;
+}
+
+int NOR_SIM_InjectFailure(nor_sim_t *sim, uint32_t Sector, uint8_t Mode){
+	uint32_t i, Free = NOR_SIM_FAIL_MAX;
+
+	for (i=0 ; i<NOR_SIM_FAIL_MAX ; i++){
+		if (sim->_internal.u8FailMode[i] != 0 && sim->_internal.u32FailSector[i] == Sector){
+			sim->_internal.u8FailMode[i] = Mode;
+			return 0;
+		}
+		if (sim->_internal.u8FailMode[i] == 0 && Free == NOR_SIM_FAIL_MAX){
+			Free = i;
+		}
+	}
+	if (Mode == 0){
+		return 0;
+	}
+	if (Free == NOR_SIM_FAIL_MAX){
+		return -1;
+	}
+	sim->_internal.u32FailSector[Free] = Sector;
+	sim->_internal.u8FailMode[Free] = Mode;
+	return 0;
+}
+
+uint64_t NOR_SIM_GetTimeUs(nor_sim_t *sim){
+	return sim->_internal.u64TimeNs / 1000;
+}
+
+void NOR_SIM_SpiTx(void *Ctx, uint8_t *TxBuff, uint32_t len){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+	uint32_t i;
+
+	sim->stats.u32BytesTx += len;
+	_sim_advance(sim, len);
+	if (!sim->_internal.u8Selected){
+		return;
+	}
+	for (i=0 ; i<len ; i++){
+		_sim_tx_byte(sim, TxBuff[i]);
+	}
+}
+
+void NOR_SIM_SpiRx(void *Ctx, uint8_t *RxBuff, uint32_t len){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+	uint32_t i;
+
+	sim->stats.u32BytesRx += len;
+	for (i=0 ; i<len ; i++){
+		_sim_advance(sim, 1);
+		RxBuff[i] = (sim->_internal.u8Selected) ? _sim_rx_byte(sim) : 0xFF;
+	}
+}
+
+void NOR_SIM_CsAssert(void *Ctx){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+
+	if (sim->_internal.u32CutCountdown > 0 && --sim->_internal.u32CutCountdown == 0){
+		_sim_power_off(sim);
+	}
+	sim->_internal.u8Selected = !sim->_internal.u8PowerOff;
+	sim->_internal.u8HdrLen = 0;
+	sim->_internal.u8HdrNeed = 0;
+	sim->_internal.u8Ignore = 0;
+	sim->_internal.u32DataCount = 0;
+	sim->stats.u32Transactions++;
+}
+
+void NOR_SIM_CsDeassert(void *Ctx){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+
+	if (sim->_internal.u8Selected && sim->_internal.u8HdrLen > 0 &&
+			!sim->_internal.u8Ignore){
+		_sim_execute(sim);
+	}
+	sim->_internal.u8Selected = 0;
+}
+
+void NOR_SIM_SetBusWidth(void *Ctx, uint8_t Lines){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+
+	sim->_internal.u8Lines = (Lines == 4) ? 4 : 1;
+}
+
+void NOR_SIM_DelayUs(void *Ctx, uint32_t us){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+
+	sim->_internal.u64TimeNs += (uint64_t)us * 1000;
+}
+
+uint8_t NOR_SIM_WaitReady(void *Ctx, uint32_t msTimeout){
+	nor_sim_t *sim = (nor_sim_t*)Ctx;
+	uint64_t TimeoutNs = (uint64_t)msTimeout * 1000000;
+
+	if (!_sim_is_busy(sim)){
+		return 1;
+	}
+	// like the ready line interrupt, wakes up right on the completion
+	if ((sim->_internal.u64BusyUntilNs - sim->_internal.u64TimeNs) > TimeoutNs){
+		sim->_internal.u64TimeNs += TimeoutNs;
+		return 0;
+	}
+	sim->_internal.u64TimeNs = sim->_internal.u64BusyUntilNs;
+	return 1;
+}
+
+uint32_t NOR_SIM_TimeUs(void *Ctx){
+	return (uint32_t)NOR_SIM_GetTimeUs((nor_sim_t*)Ctx);
+}
+
+const nor_ops_t NOR_SIM_Ops = {
+	.SpiTx = NOR_SIM_SpiTx,
+	.SpiRx = NOR_SIM_SpiRx,
+	.CsAssert = NOR_SIM_CsAssert,
+	.CsDeassert = NOR_SIM_CsDeassert,
+	.DelayUs = NOR_SIM_DelayUs,
+	.BusWidth = NOR_SIM_SetBusWidth,
+};
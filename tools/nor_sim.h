@@ -0,0 +1,202 @@
+/*
+ * nor_sim.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host side emulation of a SPI NOR Flash. Provides the operations table
+ *  expected by nor_t, NOR_SIM_Ops, with the nor_sim_t as the context, keeping
+ *  a virtual clock so the time spent on the bus and waiting busy operations
+ *  can be measured. Each nor_sim_t is a device, any number of them can run on
+ *  different threads.
+ *
+ *  A power cut can be scheduled on any transaction boundary, to test the
+ *  recovery of the upper layers. A program or erase running at the cut is
+ *  left half done.
+ *
+ *  The programs into the range of a suspended erase are ignored, counted on
+ *  the u32IgnoredCmds.
+ *
+ *  Worn sectors can be injected: their programs and erases fail, reported
+ *  on the security register of the MXIC devices, or take longer.
+ */
+
+#ifndef NOR_SIM_H_
+#define NOR_SIM_H_
+
+/**
+ * Includes
+ */
+
+#include <stdint.h>
+
+#include "nor.h"
+
+/**
+ * Macros
+ */
+
+#define NOR_SIM_HDR_MAX			8
+// largest range torn by a power cut, a 64K block
+#define NOR_SIM_TEAR_MAX		0x10000
+// sectors with failures injected
+#define NOR_SIM_FAIL_MAX		16
+
+// Failures of NOR_SIM_InjectFailure
+#define NOR_SIM_FAIL_PROGRAM	0x01	// the programs don't clear any bit
+#define NOR_SIM_FAIL_ERASE		0x02	// the erases leave the sector as is
+#define NOR_SIM_FAIL_SLOW		0x04	// the programs and erases take 4 times longer
+
+/**
+ * Structs
+ */
+
+typedef struct{
+	uint8_t *pMem;
+	uint32_t u32Size;
+	uint32_t u32JedecID;
+	uint64_t u64UniqueId;
+	struct{
+		uint32_t u32NsPerByte;
+		uint32_t u32PageProgUs;
+		uint32_t u32Erase4KUs;
+		uint32_t u32Erase32KUs;
+		uint32_t u32Erase64KUs;
+		uint32_t u32EraseChipUs;
+		uint32_t u32SuspendUs;
+	}timing;
+	struct{
+		uint32_t u32Transactions;
+		uint32_t u32BytesTx;
+		uint32_t u32BytesRx;
+		uint32_t u32StatusPolls;
+		uint32_t u32PagePrograms;
+		uint32_t u32Erases;
+		uint32_t u32IgnoredCmds;
+		uint32_t u32Suspends;
+		uint32_t u32PowerCuts;
+		// programs and erases failed by the injection
+		uint32_t u32InjectedFails;
+	}stats;
+	struct{
+		uint64_t u64TimeNs;
+		uint64_t u64BusyUntilNs;
+		uint8_t u8Selected;
+		uint8_t u8Hdr[NOR_SIM_HDR_MAX];
+		uint8_t u8HdrLen;
+		uint8_t u8HdrNeed;
+		uint8_t u8Ignore;
+		uint32_t u32Addr;
+		uint32_t u32DataCount;
+		uint8_t u8Page[256];
+		uint8_t u8Sr[3];
+		uint8_t u8PowerDown;
+		uint8_t u8ResetEnabled;
+		// a sector or block erase is running, it can be suspended
+		uint8_t u8Erasing;
+		uint8_t u8Suspended;
+		uint64_t u64SuspendedNs;
+		uint32_t u32EraseAddr;
+		uint32_t u32EraseSize;
+		// QPI mode of the device, and lines of the transport
+		uint8_t u8Qpi;
+		uint8_t u8Lines;
+		// power cut countdown, in transactions, and the range torn by it
+		uint32_t u32CutCountdown;
+		uint8_t u8PowerOff;
+		uint32_t u32TearAddr;
+		uint32_t u32TearSize;
+		uint8_t u8Tear[NOR_SIM_TEAR_MAX];
+		// security register of the MXIC devices
+		uint8_t u8Scur;
+		uint32_t u32FailSector[NOR_SIM_FAIL_MAX];
+		uint8_t u8FailMode[NOR_SIM_FAIL_MAX];
+	}_internal;
+}nor_sim_t;
+
+// SPI, CS, delay and bus width operations, pOpsCtx is the nor_sim_t
+extern const nor_ops_t NOR_SIM_Ops;
+
+/**
+ * Publics
+ */
+
+/**
+ * @brief Initialize the simulated device, erased, with typical timings. The
+ * timings can be changed on the timing of the device after this call.
+ *
+ * @param sim pointer to the simulated device
+ * @param pMem memory array of the device
+ * @param Size size of the memory array
+ * @param JedecID JEDEC ID answered by the device
+ */
+void NOR_SIM_Init(nor_sim_t *sim, uint8_t *pMem, uint32_t Size, uint32_t JedecID);
+
+/**
+ * @brief Load the content of the device from a file. The bytes beyond the
+ * end of the file are erased.
+ *
+ * @param sim pointer to the simulated device
+ * @param path path to the file
+ * @return 0 on success, -1 if the file can't be opened
+ */
+int NOR_SIM_LoadFile(nor_sim_t *sim, const char *path);
+
+/**
+ * @brief Save the content of the device to a file.
+ *
+ * @param sim pointer to the simulated device
+ * @param path path to the file
+ * @return 0 on success, -1 on failure
+ */
+int NOR_SIM_SaveFile(nor_sim_t *sim, const char *path);
+
+/**
+ * @brief Get the virtual time, advanced by the bus transfers and the delays.
+ *
+ * @param sim pointer to the simulated device
+ * @return time in us
+ */
+uint64_t NOR_SIM_GetTimeUs(nor_sim_t *sim);
+
+/**
+ * @brief Schedule a power cut right before a transaction. The transaction and
+ * all the next ones are lost, the reads return 0xFF, and a program or erase
+ * still running keeps the old content on the second half of its range.
+ *
+ * @param sim pointer to the simulated device
+ * @param Transactions the cut happens on the Nth transaction from now, 0 cancels
+ */
+void NOR_SIM_SchedulePowerCut(nor_sim_t *sim, uint32_t Transactions);
+
+/**
+ * @brief Power the device on again, after a power cut. The volatile state is
+ * lost: write enable, suspend, power down and QPI mode.
+ *
+ * @param sim pointer to the simulated device
+ */
+void NOR_SIM_PowerOn(nor_sim_t *sim);
+
+/**
+ * @brief Make a sector fail, replacing the failures injected before on it.
+ *
+ * @param sim pointer to the simulated device
+ * @param Sector the sector
+ * @param Mode NOR_SIM_FAIL_* flags, 0 heals the sector
+ * @return 0 on success, -1 if NOR_SIM_FAIL_MAX sectors are already failing
+ */
+int NOR_SIM_InjectFailure(nor_sim_t *sim, uint32_t Sector, uint8_t Mode);
+
+/* Operations for nor_ops_t, Ctx is the nor_sim_t. NOR_SIM_Ops has only the
+ * required ones and BusWidth, build another table to add WaitReady and TimeUs */
+
+void NOR_SIM_SpiTx(void *Ctx, uint8_t *TxBuff, uint32_t len);
+void NOR_SIM_SpiRx(void *Ctx, uint8_t *RxBuff, uint32_t len);
+void NOR_SIM_CsAssert(void *Ctx);
+void NOR_SIM_CsDeassert(void *Ctx);
+void NOR_SIM_SetBusWidth(void *Ctx, uint8_t Lines);
+void NOR_SIM_DelayUs(void *Ctx, uint32_t us);
+uint8_t NOR_SIM_WaitReady(void *Ctx, uint32_t msTimeout);
+uint32_t NOR_SIM_TimeUs(void *Ctx);
+
+#endif /* NOR_SIM_H_ */
@@ -0,0 +1,187 @@
+/*
+ * nor_wait_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: pablo-jean
+ *
+ *  Host benchmark of the completion of the programs and erases on the
+ *  simulated device, with the software poll of the status register every
+ *  100 us, and with the WaitReady operation, like the auto-poll of a QSPI
+ *  controller or a ready/busy line. For each kind of operation it reports
+ *  the time per operation, the time over the busy time of the device (the
+ *  transfers of the command and the data, and the late detection of the
+ *  completion), the status polls and the SPI transactions.
+ *
+ *  Build, from the repository root:
+ *    gcc -O2 -I. -Itools -o nor_wait_bench tools/nor_wait_bench.c tools/nor_sim.c nor.c nor_ids.c nor_crc.c
+ *
+ *  Usage:
+ *    nor_wait_bench [-n count] [-x seed]
+ *
+ *    -n  operations of each kind, 32 if not provided, up to 64
+ *    -x  seed of the random generator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nor.h"
+#include "nor_sim.h"
+
+/*
+ * Privates
+ */
+
+#define _BENCH_JEDEC_ID				0x1740EF	// W25Q64
+#define _BENCH_SIZE					(8 * 1024 * 1024)
+#define _BENCH_FIRST_BLOCK			16
+#define _BENCH_COUNT_MAX			64
+
+typedef enum{
+	_BENCH_PAGE_PROGRAM,
+	_BENCH_WRITE_4K,
+	_BENCH_ERASE_4K,
+	_BENCH_ERASE_64K,
+	_BENCH_KINDS
+}bench_kind_e;
+
+typedef struct{
+	uint64_t u64TimeUs;
+	uint64_t u64DeviceUs;
+	uint32_t u32Polls;
+	uint32_t u32Transactions;
+	uint32_t u32Errors;
+}bench_stats_t;
+
+static const char *KindNames[] = {"page program", "4K write", "4K erase", "64K erase"};
+
+static uint8_t Memory[_BENCH_SIZE];
+static uint8_t Data[NOR_SECTOR_SIZE];
+static nor_t Nor;
+static nor_sim_t Sim;
+static nor_ops_t ReadyOps;
+
+/* Functions */
+
+static void _bench_usage(const char *name){
+	fprintf(stderr, "usage: %s [-n count] [-x seed]\n", name);
+}
+
+static nor_err_e _bench_op(bench_kind_e Kind, uint32_t i){
+	switch (Kind){
+	case _BENCH_PAGE_PROGRAM:
+		return NOR_WriteBytes(&Nor, Data, i * NOR_SECTOR_SIZE, NOR_PAGE_SIZE);
+	case _BENCH_WRITE_4K:
+		return NOR_WriteBytes(&Nor, Data, (_BENCH_FIRST_BLOCK * NOR_BLOCK_SIZE) + (i * NOR_SECTOR_SIZE), NOR_SECTOR_SIZE);
+	case _BENCH_ERASE_4K:
+		return NOR_EraseSector(&Nor, i);
+	default:
+		return NOR_EraseBlock(&Nor, _BENCH_FIRST_BLOCK + i);
+	}
+}
+
+static uint32_t _bench_device_us(bench_kind_e Kind){
+	switch (Kind){
+	case _BENCH_PAGE_PROGRAM:
+		return Sim.timing.u32PageProgUs;
+	case _BENCH_WRITE_4K:
+		return (NOR_SECTOR_SIZE / NOR_PAGE_SIZE) * Sim.timing.u32PageProgUs;
+	case _BENCH_ERASE_4K:
+		return Sim.timing.u32Erase4KUs;
+	default:
+		return Sim.timing.u32Erase64KUs;
+	}
+}
+
+/*
+ * Runs every kind of operation on a new device. The 64K erases go first, so
+ * the 4K writes land on erased blocks, and the page programs on the sectors
+ * erased by the 4K erases.
+ */
+static int _bench_run(const nor_ops_t *pOps, uint32_t Count, bench_stats_t *pStats){
+	static const bench_kind_e Order[] = {_BENCH_ERASE_64K, _BENCH_WRITE_4K, _BENCH_ERASE_4K, _BENCH_PAGE_PROGRAM};
+	uint64_t Start;
+	uint32_t Polls, Transactions, i, k;
+
+	NOR_SIM_Init(&Sim, Memory, sizeof(Memory), _BENCH_JEDEC_ID);
+	memset(&Nor, 0, sizeof(Nor));
+	Nor.config.pOps = pOps;
+	Nor.config.pOpsCtx = &Sim;
+	if (NOR_Init(&Nor) != NOR_OK){
+		return -1;
+	}
+	memset(pStats, 0, sizeof(bench_stats_t) * _BENCH_KINDS);
+	for (k=0 ; k<(sizeof(Order) / sizeof(Order[0])) ; k++){
+		for (i=0 ; i<Count ; i++){
+			Start = NOR_SIM_GetTimeUs(&Sim);
+			Polls = Sim.stats.u32StatusPolls;
+			Transactions = Sim.stats.u32Transactions;
+			if (_bench_op(Order[k], i) != NOR_OK){
+				pStats[Order[k]].u32Errors++;
+			}
+			pStats[Order[k]].u64TimeUs += NOR_SIM_GetTimeUs(&Sim) - Start;
+			pStats[Order[k]].u64DeviceUs += _bench_device_us(Order[k]);
+			pStats[Order[k]].u32Polls += Sim.stats.u32StatusPolls - Polls;
+			pStats[Order[k]].u32Transactions += Sim.stats.u32Transactions - Transactions;
+		}
+	}
+
+	return 0;
+}
+
+static void _bench_print(bench_kind_e Kind, const char *Name, bench_stats_t *pStats, uint32_t Count){
+	printf(" %-12s | %-5s | %9.1f | %8.1f | %6.1f | %12.1f | %u\n", KindNames[Kind], Name,
+			(double)pStats->u64TimeUs / Count,
+			((double)pStats->u64TimeUs - (double)pStats->u64DeviceUs) / Count,
+			(double)pStats->u32Polls / Count, (double)pStats->u32Transactions / Count,
+			(unsigned)pStats->u32Errors);
+}
+
+/*
+ * Publics
+ */
+
+int main(int argc, char **argv){
+	bench_stats_t PollStats[_BENCH_KINDS], ReadyStats[_BENCH_KINDS];
+	uint32_t Count = 32, Seed = 1, i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:x:")) != -1){
+		switch (opt){
+		case 'n':
+			Count = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			Seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			_bench_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (Count == 0 || Count > _BENCH_COUNT_MAX){
+		fprintf(stderr, "count must be from 1 to %u\n", _BENCH_COUNT_MAX);
+		return 1;
+	}
+	srand(Seed);
+	for (i=0 ; i<sizeof(Data) ; i++){
+		Data[i] = (uint8_t)rand();
+	}
+	ReadyOps = NOR_SIM_Ops;
+	ReadyOps.WaitReady = NOR_SIM_WaitReady;
+	ReadyOps.TimeUs = NOR_SIM_TimeUs;
+	if (_bench_run(&NOR_SIM_Ops, Count, PollStats) != 0 || _bench_run(&ReadyOps, Count, ReadyStats) != 0){
+		fprintf(stderr, "failed to initialize the driver\n");
+		return 1;
+	}
+	printf("== Completion of %u operations of each kind ==\n", (unsigned)Count);
+	printf(" operation    | wait  | us per op | us over  | polls  | transactions | errors\n");
+	for (i=0 ; i<_BENCH_KINDS ; i++){
+		_bench_print((bench_kind_e)i, "poll", &PollStats[i], Count);
+		_bench_print((bench_kind_e)i, "ready", &ReadyStats[i], Count);
+	}
+
+	return 0;
+}